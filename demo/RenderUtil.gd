@@ -33,18 +33,14 @@ static func enforce_winding(verts, clockwise = true):
 			verts.reverse()
 			
 static func geo_polygon_to_world(verts_geo : PackedVector2Array, geomap : GeoMap) -> PackedVector3Array:
-	var verts_world : PackedVector3Array
-	for vg in verts_geo:
-		verts_world.append(geomap.geo_to_world(vg))
+	var verts_world := geomap.geo_to_world_batch(verts_geo)
 		
 	verts_world.reverse()
 		
 	return verts_world
 	
 static func geo_polygon_to_world_up(verts_geo : PackedVector2Array, geomap : GeoMap) -> PackedVector3Array:
-	var up_world : PackedVector3Array
-	for vg in verts_geo:
-		up_world.append(geomap.geo_to_world_up(vg))
+	var up_world := geomap.geo_to_world_up_batch(verts_geo)
 		
 	up_world.reverse()
 		
@@ -3,6 +3,8 @@ extends Node
 var tile_info : Dictionary = {}
 var node_pos : Dictionary = {}
 var building_part_nodes : Dictionary = {} # TODO: Only works if building parts are defined before building.
+var mesher := BuildingMesher.new()
+var codec := GeometryCodec.new()
 
 @export var one_node_per_building : bool = false
 
@@ -18,6 +20,9 @@ enum RoofType
 func get_required_globals():
 	return GlobalRequirementsBuilder.new().withNodeRequirement("pos").build()
 
+func get_selector():
+	return "node, way[building][building!=no], way[building:part][building:part!=no]"
+
 func import_begin():
 	tile_info = {}
 	node_pos = {}
@@ -50,11 +55,19 @@ func import_way(osm_dict : Dictionary, fa : StreamPeer):
 			continue
 		path.push_back(node_pos[node_id])
 		
-	tile_info[fa].push_back(RenderUtil.building_info(osm_dict, path))
+	tile_info[fa].push_back(mesher.building_info(osm_dict, path))
 
 func import_finished():
 	for fa in tile_info:
-		fa.put_var(tile_info[fa])
+		if one_node_per_building:
+			fa.put_var({"buildings": tile_info[fa]})
+			continue
+		# Mesh once at import time and store the tile geometry quantized.
+		var surfaces := []
+		for surface in mesher.mesh_buildings(tile_info[fa]):
+			surfaces.push_back({"color": surface["color"], "data": codec.encode_arrays(surface["arrays"])})
+			print_verbose("Building surface encoded: ", codec.get_last_stats())
+		fa.put_var({"surfaces": surfaces})
 	for child in get_children():
 		remove_child(child)
 
@@ -75,38 +88,32 @@ func get_roof_arrays(d : Dictionary):
 			return RenderUtil.hipped(nodes, d.get("roof_height", max_height - min_height), max_height, true)
 
 func load_tile(fa : FileAccess):
-	var paths = fa.get_var()
+	var stored = fa.get_var()
 	
-	# For combined node
-	# (color, material) -> Array[Array]
-	var material_arrays : Dictionary
-	var add_to_material_arrays = func (color, material, arrays):
-		var key = [color, material]
-		if not material_arrays.has(key):
-			material_arrays[key] = RenderUtil.get_array_mesh_arrays([Mesh.ARRAY_VERTEX, Mesh.ARRAY_TEX_UV, Mesh.ARRAY_NORMAL])
-		RenderUtil.combine_mesh_arrays(material_arrays[key], arrays)
+	if stored is Dictionary and stored.has("surfaces"):
+		# One combined surface per material, meshed at import time.
+		for surface in stored["surfaces"]:
+			RenderUtil.area_poly(self, "Combined mesh", codec.decode_arrays(surface["data"]), surface["color"], true)
+		return
 
-	for path in paths:
+	# Tiles imported before buildings were meshed natively hold a bare Array of building infos.
+	var buildings = stored["buildings"] if stored is Dictionary else stored
+	for path in buildings:
 		# Path
 		if path["nodes"].is_empty():
 			continue
 		
 		var max_height = path["max_height"]
 		var min_height = path["min_height"]
-		var half_thickness = 0.01
 		var color = path["color"]
 		var roof_color = path["roof_color"] if path.has("roof_color") else color
 		
 		var walls_arrays = RenderUtil.wall_poly_np(path["nodes"], min_height, max_height)
 		var roof_arrays = get_roof_arrays(path)
 		
-		if one_node_per_building:
-			var building = RenderUtil.achild(self, Node3D.new(), "Building"+path["name"])
-			RenderUtil.area_poly(building, path["name"], walls_arrays, color)
-			RenderUtil.area_poly(building, "roof", roof_arrays, roof_color)
-		else:
-			add_to_material_arrays.call(color, '', walls_arrays)
-			add_to_material_arrays.call(roof_color, '', roof_arrays)
+		var building = RenderUtil.achild(self, Node3D.new(), "Building"+path["name"])
+		RenderUtil.area_poly(building, path["name"], walls_arrays, color)
+		RenderUtil.area_poly(building, "roof", roof_arrays, roof_color)
 
 		#if max_height - min_height > 0:
 		#	RenderUtil.area_poly(building, "floor", RenderUtil.polygon(path["nodes"], min_height), color)
@@ -118,8 +125,3 @@ func load_tile(fa : FileAccess):
 		#label.autowrap_mode = TextServer.AUTOWRAP_ARBITRARY
 		#RenderUtil.achild(building, label, "Keys")
 		#label.text = path["dupa"]
-		
-	if not one_node_per_building:
-		for key in material_arrays:
-			var arrays = material_arrays[key]
-			RenderUtil.area_poly(self, "Combined mesh", arrays, key[0], true)
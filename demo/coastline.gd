@@ -4,6 +4,8 @@ extends Node
 @export var material : Material
 @export var add_seabed : bool
 
+var mesh_optimizer := MeshOptimizer.new()
+
 
 func import_polygons_geo(polygons : Array, geomap : GeoMap):
 	for child in self.get_children():
@@ -24,7 +26,8 @@ func import_polygons_geo(polygons : Array, geomap : GeoMap):
 		var sea_area = RenderUtil.achild(self, Node3D.new(), "SeaArea")
 
 		
-		var water = RenderUtil.area_poly(sea_area, "Water", RenderUtil.polygon_triangles(triangles_world, 0, normals))
+		var water_arrays = mesh_optimizer.optimize_arrays(RenderUtil.polygon_triangles(triangles_world, 0, normals))
+		var water = RenderUtil.area_poly(sea_area, "Water", water_arrays)
 		water.mesh.surface_set_material(0, material)
 		
 		if add_seabed:
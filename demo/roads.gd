@@ -1,51 +1,78 @@
 @tool
 extends Node
 var tile_info : Dictionary = {}
-var node_pos : Dictionary = {}
+var node_geo : Dictionary = {}
+var mesher := RoadMesher.new()
+var codec := GeometryCodec.new()
+var geomap : GeoMap = null
+var heightmap : OSMHeightmap = null
+
+# Indexed by RoadMesher.RoadClass.
+const ROAD_COLORS = [Color(0.85, 0.5, 0.3), Color(0.9, 0.75, 0.4), Color(0.8, 0.8, 0.8), Color(0.6, 0.6, 0.6), Color(0.7, 0.6, 0.45)]
+
+# Untagged nodes too, ways reference them.
+func get_selector():
+	return "node, way[highway]"
 
 func import_begin():
 	tile_info = {}
-	node_pos = {}
+	node_geo = {}
+	geomap = null
+	heightmap = null
 	for child in self.get_children():
 		self.remove_child(child)
 
 func import_node(osm_dict : Dictionary, fa : StreamPeer):
-	node_pos[osm_dict["id"]] = osm_dict["pos_elevation"]
-	
+	node_geo[osm_dict["id"]] = osm_dict["pos_geo"]
+
 func import_way(osm_dict : Dictionary, fa : StreamPeer):
-	
-
-	if osm_dict.has("highway"):
-		var path : PackedVector3Array = []
-		for node_id in osm_dict["nodes"]:
-			if !node_pos.has(node_id):
-				continue
-			path.push_back(node_pos[node_id])
-			
-		if !tile_info.has(fa):
-			tile_info[fa] = []
-		tile_info[fa].push_back({"name" : osm_dict.get("name", str(osm_dict["id"])), "nodes": path})
+	var geo : PackedVector2Array = []
+	var ids : PackedInt64Array = []
+	for node_id in osm_dict["nodes"]:
+		if !node_geo.has(node_id):
+			continue
+		geo.push_back(node_geo[node_id])
+		ids.push_back(node_id)
+
+	if !tile_info.has(fa):
+		tile_info[fa] = []
+	tile_info[fa].push_back(mesher.road_info(osm_dict, geo, ids))
+
+func import_context(_geomap : GeoMap, _heightmap : OSMHeightmap):
+	geomap = _geomap
+	heightmap = _heightmap
 
 func import_finished():
 	for fa in tile_info:
-		var start = fa.get_position()
-		fa.put_var(tile_info[fa])
+		# Mesh once at import time, one surface per road class, and store the tile geometry quantized.
+		var surfaces := []
+		for surface in mesher.mesh_roads(tile_info[fa], geomap, heightmap):
+			surfaces.push_back({"road_class": surface["road_class"], "data": codec.encode_arrays(surface["arrays"])})
+			print_verbose("Road surface encoded: ", codec.get_last_stats())
+		fa.put_var({"surfaces": surfaces})
 
 func achild(parent, node, name):
 	node.name = name
 	parent.add_child (node, true)
 	node.set_owner(get_tree().edited_scene_root)
 	return node
-	
+
 func load_tile(fa : FileAccess):
-	var paths = fa.get_var()
-	for path in paths:
+	var stored = fa.get_var()
+
+	if stored is Dictionary:
+		for surface in stored["surfaces"]:
+			RenderUtil.area_poly(self, "Roads", codec.decode_arrays(surface["data"]), ROAD_COLORS[surface["road_class"]], true)
+		return
+
+	# Tiles imported before roads were meshed natively hold one path per way.
+	for path in stored:
 		# Path
 		var child : Path3D = achild(self, Path3D.new(), path["name"])
 		child.curve = Curve3D.new()
 		for node in path["nodes"]:
 			child.curve.add_point(node)
-			
+
 		var poly : CSGPolygon3D = achild(child, CSGPolygon3D.new(), "polygon")
 		poly.mode = CSGPolygon3D.MODE_PATH
 		poly.path_node = child.get_path()
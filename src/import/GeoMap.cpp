@@ -1,12 +1,241 @@
 #include "GeoMap.h"
 #include "stdio.h"
+#include <godot_cpp/classes/time.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GEOMAP_AVX2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GEOMAP_NEON
+#endif
 
 using namespace godot;
 
+/* Batch kernels */
+
+namespace {
+    /* Kernels write blocks of doubles that are then converted into Vector3s. */
+    const size_t KERNEL_BLOCK = 256;
+
+    void store_vectors(const double* x, const double* y, const double* z, size_t count, double scale, Vector3* out) {
+        for (size_t i = 0; i < count; i++)
+            out[i] = Vector3(static_cast<real_t>(x[i] * scale), static_cast<real_t>(y[i] * scale), static_cast<real_t>(z[i] * scale));
+    }
+
+    /* x = kx * (lon - lon0), z = kz * (lat0 - lat) */
+    void affine_kernel(const double* lon, const double* lat, size_t count, double lon0, double lat0, double kx, double kz, double* x, double* z) {
+        size_t i = 0;
+#if defined(GEOMAP_AVX2)
+        const __m256d vlon0 = _mm256_set1_pd(lon0), vlat0 = _mm256_set1_pd(lat0);
+        const __m256d vkx = _mm256_set1_pd(kx), vkz = _mm256_set1_pd(kz);
+        for (; i + 4 <= count; i += 4) {
+            _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(lon + i), vlon0), vkx));
+            _mm256_storeu_pd(z + i, _mm256_mul_pd(_mm256_sub_pd(vlat0, _mm256_loadu_pd(lat + i)), vkz));
+        }
+#elif defined(GEOMAP_NEON)
+        const float64x2_t vlon0 = vdupq_n_f64(lon0), vlat0 = vdupq_n_f64(lat0);
+        const float64x2_t vkx = vdupq_n_f64(kx), vkz = vdupq_n_f64(kz);
+        for (; i + 2 <= count; i += 2) {
+            vst1q_f64(x + i, vmulq_f64(vsubq_f64(vld1q_f64(lon + i), vlon0), vkx));
+            vst1q_f64(z + i, vmulq_f64(vsubq_f64(vlat0, vld1q_f64(lat + i)), vkz));
+        }
+#endif
+        for (; i < count; i++) {
+            x[i] = (lon[i] - lon0) * kx;
+            z[i] = (lat0 - lat[i]) * kz;
+        }
+    }
+
+    /* Cephes sin/cos: Cody-Waite reduction by pi/2 and minimax polynomials on [-pi/4, pi/4]. */
+    const double TWO_OVER_PI = 0.63661977236758134308;
+    const double PIO2_1 = 1.57079625129699707031e+00;
+    const double PIO2_2 = 7.54978941586159635335e-08;
+    const double PIO2_3 = 5.39030252995776476554e-15;
+    const double SIN_COEFFS[6] = { 1.58962301576546568060e-10, -2.50507477628578072866e-8, 2.75573136213857245213e-6,
+                                   -1.98412698295895385996e-4, 8.33333333332211858878e-3, -1.66666666666666307295e-1 };
+    const double COS_COEFFS[6] = { -1.13585365213876817300e-11, 2.08757008419747316778e-9, -2.75573141792967388112e-7,
+                                   2.48015872888517045348e-5, -1.38888888888730564116e-3, 4.16666666666665929218e-2 };
+
+#if defined(GEOMAP_AVX2)
+    void sincos_pd(__m256d x, __m256d& out_sin, __m256d& out_cos) {
+        const __m256d q = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(q, _mm256_set1_pd(PIO2_1)));
+        r = _mm256_sub_pd(r, _mm256_mul_pd(q, _mm256_set1_pd(PIO2_2)));
+        r = _mm256_sub_pd(r, _mm256_mul_pd(q, _mm256_set1_pd(PIO2_3)));
+        const __m256d r2 = _mm256_mul_pd(r, r);
+
+        __m256d ps = _mm256_set1_pd(SIN_COEFFS[0]), pc = _mm256_set1_pd(COS_COEFFS[0]);
+        for (int k = 1; k < 6; k++) {
+            ps = _mm256_add_pd(_mm256_mul_pd(ps, r2), _mm256_set1_pd(SIN_COEFFS[k]));
+            pc = _mm256_add_pd(_mm256_mul_pd(pc, r2), _mm256_set1_pd(COS_COEFFS[k]));
+        }
+        const __m256d s = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(r, r2), ps));
+        const __m256d c = _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), _mm256_mul_pd(r2, _mm256_set1_pd(0.5))),
+                                        _mm256_mul_pd(_mm256_mul_pd(r2, r2), pc));
+
+        // Quadrant: odd ones swap sin and cos, the sign follows bit 1 of q (sin) and q + 1 (cos).
+        const __m256i qi = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(q));
+        const __m256i one = _mm256_set1_epi64x(1), two = _mm256_set1_epi64x(2);
+        const __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(qi, one), one));
+        const __m256d sin_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(qi, two), 62));
+        const __m256d cos_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(qi, one), two), 62));
+        out_sin = _mm256_xor_pd(_mm256_blendv_pd(s, c, swap), sin_sign);
+        out_cos = _mm256_xor_pd(_mm256_blendv_pd(c, s, swap), cos_sign);
+    }
+#elif defined(GEOMAP_NEON)
+    void sincos_pd(float64x2_t x, float64x2_t& out_sin, float64x2_t& out_cos) {
+        const float64x2_t q = vrndnq_f64(vmulq_f64(x, vdupq_n_f64(TWO_OVER_PI)));
+        float64x2_t r = vsubq_f64(x, vmulq_f64(q, vdupq_n_f64(PIO2_1)));
+        r = vsubq_f64(r, vmulq_f64(q, vdupq_n_f64(PIO2_2)));
+        r = vsubq_f64(r, vmulq_f64(q, vdupq_n_f64(PIO2_3)));
+        const float64x2_t r2 = vmulq_f64(r, r);
+
+        float64x2_t ps = vdupq_n_f64(SIN_COEFFS[0]), pc = vdupq_n_f64(COS_COEFFS[0]);
+        for (int k = 1; k < 6; k++) {
+            ps = vaddq_f64(vmulq_f64(ps, r2), vdupq_n_f64(SIN_COEFFS[k]));
+            pc = vaddq_f64(vmulq_f64(pc, r2), vdupq_n_f64(COS_COEFFS[k]));
+        }
+        const float64x2_t s = vaddq_f64(r, vmulq_f64(vmulq_f64(r, r2), ps));
+        const float64x2_t c = vaddq_f64(vsubq_f64(vdupq_n_f64(1.0), vmulq_f64(r2, vdupq_n_f64(0.5))), vmulq_f64(vmulq_f64(r2, r2), pc));
+
+        const int64x2_t qi = vcvtq_s64_f64(q);
+        const int64x2_t one = vdupq_n_s64(1), two = vdupq_n_s64(2);
+        const uint64x2_t swap = vceqq_s64(vandq_s64(qi, one), one);
+        const uint64x2_t sin_sign = vshlq_n_u64(vreinterpretq_u64_s64(vandq_s64(qi, two)), 62);
+        const uint64x2_t cos_sign = vshlq_n_u64(vreinterpretq_u64_s64(vandq_s64(vaddq_s64(qi, one), two)), 62);
+        out_sin = vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(vbslq_f64(swap, c, s)), sin_sign));
+        out_cos = vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(vbslq_f64(swap, s, c)), cos_sign));
+    }
+#endif
+
+    /* Unit sphere position: (cos(lat) cos(lon), sin(lat), -cos(lat) sin(lon)). */
+    void sphere_kernel(const double* lon, const double* lat, size_t count, double* x, double* y, double* z) {
+        size_t i = 0;
+#if defined(GEOMAP_AVX2)
+        for (; i + 4 <= count; i += 4) {
+            __m256d sin_lat, cos_lat, sin_lon, cos_lon;
+            sincos_pd(_mm256_loadu_pd(lat + i), sin_lat, cos_lat);
+            sincos_pd(_mm256_loadu_pd(lon + i), sin_lon, cos_lon);
+            _mm256_storeu_pd(x + i, _mm256_mul_pd(cos_lat, cos_lon));
+            _mm256_storeu_pd(y + i, sin_lat);
+            _mm256_storeu_pd(z + i, _mm256_mul_pd(_mm256_sub_pd(_mm256_setzero_pd(), cos_lat), sin_lon));
+        }
+#elif defined(GEOMAP_NEON)
+        for (; i + 2 <= count; i += 2) {
+            float64x2_t sin_lat, cos_lat, sin_lon, cos_lon;
+            sincos_pd(vld1q_f64(lat + i), sin_lat, cos_lat);
+            sincos_pd(vld1q_f64(lon + i), sin_lon, cos_lon);
+            vst1q_f64(x + i, vmulq_f64(cos_lat, cos_lon));
+            vst1q_f64(y + i, sin_lat);
+            vst1q_f64(z + i, vmulq_f64(vnegq_f64(cos_lat), sin_lon));
+        }
+#endif
+        for (; i < count; i++) {
+            const double cos_lat = std::cos(lat[i]);
+            x[i] = cos_lat * std::cos(lon[i]);
+            y[i] = std::sin(lat[i]);
+            z[i] = -cos_lat * std::sin(lon[i]);
+        }
+    }
+
+    void to_radians_arrays(const PackedVector2Array& coords, std::vector<double>& lon, std::vector<double>& lat) {
+        const int64_t count = coords.size();
+        const Vector2* src = coords.ptr();
+        lon.resize(count);
+        lat.resize(count);
+        for (int64_t i = 0; i < count; i++) {
+            lon[i] = src[i].x;
+            lat[i] = src[i].y;
+        }
+    }
+}
+
 /* Base */
+void GeoMap::geo_to_world_batch_impl(const double* lon, const double* lat, size_t count, double scale, Vector3* out_pos, Vector3* out_up) {
+    for (size_t i = 0; i < count; i++) {
+        const GeoCoords coords(Longitude::radians(lon[i]), Latitude::radians(lat[i]));
+        if (out_pos)
+            out_pos[i] = geo_to_world_impl(coords) * static_cast<real_t>(scale);
+        if (out_up)
+            out_up[i] = geo_to_world_up(coords);
+    }
+}
+
+PackedVector3Array GeoMap::geo_to_world_batch(PackedVector2Array coords) {
+    std::vector<double> lon, lat;
+    to_radians_arrays(coords, lon, lat);
+    PackedVector3Array result;
+    result.resize(coords.size());
+    geo_to_world_batch(lon.data(), lat.data(), lon.size(), result.ptrw(), nullptr);
+    return result;
+}
+
+PackedVector3Array GeoMap::geo_to_world_up_batch(PackedVector2Array coords) {
+    std::vector<double> lon, lat;
+    to_radians_arrays(coords, lon, lat);
+    PackedVector3Array result;
+    result.resize(coords.size());
+    geo_to_world_batch(lon.data(), lat.data(), lon.size(), nullptr, result.ptrw());
+    return result;
+}
+
+Dictionary GeoMap::benchmark_batch(int point_count) {
+    Dictionary result;
+    ERR_FAIL_COND_V_MSG(point_count <= 0, result, "GeoMap: benchmark_batch needs a positive point count.");
+
+    // A spiral of points within a few degrees of (0, 0), deterministic between runs.
+    PackedVector2Array coords;
+    coords.resize(point_count);
+    for (int i = 0; i < point_count; i++) {
+        const double t = static_cast<double>(i) / point_count;
+        coords.set(i, Vector2(static_cast<real_t>(0.05 * t * std::cos(i * 0.7)), static_cast<real_t>(0.05 * t * std::sin(i * 0.7))));
+    }
+
+    Time* time = Time::get_singleton();
+    PackedVector3Array per_point_pos, per_point_up;
+    per_point_pos.resize(point_count);
+    per_point_up.resize(point_count);
+    const uint64_t per_point_start = time->get_ticks_usec();
+    for (int i = 0; i < point_count; i++) {
+        const GeoCoords c = GeoCoords::from_vector2_representation(coords[i]);
+        per_point_pos.set(i, geo_to_world(c));
+        per_point_up.set(i, geo_to_world_up(c));
+    }
+    const uint64_t per_point_usec = time->get_ticks_usec() - per_point_start;
+
+    std::vector<double> lon, lat;
+    PackedVector3Array batch_pos, batch_up;
+    batch_pos.resize(point_count);
+    batch_up.resize(point_count);
+    const uint64_t batch_start = time->get_ticks_usec();
+    to_radians_arrays(coords, lon, lat);
+    geo_to_world_batch(lon.data(), lat.data(), lon.size(), batch_pos.ptrw(), batch_up.ptrw());
+    const uint64_t batch_usec = time->get_ticks_usec() - batch_start;
+
+    double max_difference = 0.0;
+    for (int i = 0; i < point_count; i++) {
+        max_difference = std::max(max_difference, static_cast<double>(per_point_pos[i].distance_to(batch_pos[i])));
+        max_difference = std::max(max_difference, static_cast<double>(per_point_up[i].distance_to(batch_up[i])));
+    }
+
+    result["point_count"] = point_count;
+    result["per_point_usec"] = static_cast<int64_t>(per_point_usec);
+    result["batch_usec"] = static_cast<int64_t>(batch_usec);
+    result["speedup"] = batch_usec > 0 ? static_cast<double>(per_point_usec) / batch_usec : 0.0;
+    result["max_difference"] = max_difference;
+    return result;
+}
+
 void GeoMap::_bind_methods() {
     ClassDB::bind_method(D_METHOD("geo_to_world", "coords"), (Vector3(GeoMap::*)(Vector2))(&GeoMap::geo_to_world));
     ClassDB::bind_method(D_METHOD("geo_to_world_up", "coords"), (Vector3(GeoMap::*)(Vector2))(&GeoMap::geo_to_world_up));
+    ClassDB::bind_method(D_METHOD("geo_to_world_batch", "coords"), (PackedVector3Array(GeoMap::*)(PackedVector2Array))(&GeoMap::geo_to_world_batch));
+    ClassDB::bind_method(D_METHOD("geo_to_world_up_batch", "coords"), &GeoMap::geo_to_world_up_batch);
+    ClassDB::bind_method(D_METHOD("benchmark_batch", "point_count"), &GeoMap::benchmark_batch);
 
     ClassDB::bind_method(D_METHOD("set_scale_factor", "scale"), &GeoMap::set_scale_factor);
     ClassDB::bind_method(D_METHOD("get_scale_factor"), &GeoMap::get_scale_factor);
@@ -52,6 +281,25 @@ Vector3 EquirectangularGeoMap::geo_to_world_impl(GeoCoords coords) {
     return Vector3(world_coords.x, 0.0, world_coords.y);
 }
 
+void EquirectangularGeoMap::geo_to_world_batch_impl(const double* lon, const double* lat, size_t count, double scale, Vector3* out_pos, Vector3* out_up) {
+    if (out_up) {
+        for (size_t i = 0; i < count; i++)
+            out_up[i] = Vector3(0.0, 1.0, 0.0);
+    }
+    if (!out_pos)
+        return;
+
+    // Same terms as geocoords_to_flat_distance, folded into one factor per axis.
+    const double kz = LATITUDE_DEGREE_IN_METRES * 180.0 / Math_PI / UNIT_IN_METRES;
+    const double kx = kz * cos(geo_origin.lat.value);
+    double x[KERNEL_BLOCK], y[KERNEL_BLOCK] = {}, z[KERNEL_BLOCK];
+    for (size_t begin = 0; begin < count; begin += KERNEL_BLOCK) {
+        const size_t n = std::min(KERNEL_BLOCK, count - begin);
+        affine_kernel(lon + begin, lat + begin, n, geo_origin.lon.value, geo_origin.lat.value, kx, kz, x, z);
+        store_vectors(x, y, z, n, scale, out_pos + begin);
+    }
+}
+
 void EquirectangularGeoMap::_bind_methods() {
 }
 
@@ -75,5 +323,21 @@ godot::Vector3 SphereGeoMap::geo_to_world_up(GeoCoords coords) {
     return geo_to_world(coords).normalized();
 }
 
+void SphereGeoMap::geo_to_world_batch_impl(const double* lon, const double* lat, size_t count, double scale, Vector3* out_pos, Vector3* out_up) {
+    const double EARTH_RADIUS_METERS = 6371000.0;
+    // geo_to_world_up normalizes the scaled position, so a negative scale flips it.
+    const double up_sign = scale < 0.0 ? -1.0 : 1.0;
+
+    double x[KERNEL_BLOCK], y[KERNEL_BLOCK], z[KERNEL_BLOCK];
+    for (size_t begin = 0; begin < count; begin += KERNEL_BLOCK) {
+        const size_t n = std::min(KERNEL_BLOCK, count - begin);
+        sphere_kernel(lon + begin, lat + begin, n, x, y, z);
+        if (out_pos)
+            store_vectors(x, y, z, n, EARTH_RADIUS_METERS * scale, out_pos + begin);
+        if (out_up)
+            store_vectors(x, y, z, n, up_sign, out_up + begin);
+    }
+}
+
 void SphereGeoMap::_bind_methods() {
 }
\ No newline at end of file
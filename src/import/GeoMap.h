@@ -3,6 +3,9 @@
 #include "../util/Util.h"
 #include <godot_cpp/core/math.hpp>
 #include <godot_cpp/variant/vector2.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_vector2_array.hpp>
+#include <godot_cpp/variant/packed_vector3_array.hpp>
 #include <godot_cpp/classes/ref_counted.hpp>
 #include <godot_cpp/classes/resource.hpp>
 
@@ -165,6 +168,33 @@ public:
         return geo_to_world_up(GeoCoords::from_vector2_representation(vec));
     };
 
+    /**
+     * @brief Projects many points at once with a single dispatch to a projection-specific kernel.
+     * @param lon Longitudes in radians.
+     * @param lat Latitudes in radians.
+     * @param out_pos World space positions (scaled like geo_to_world), may be null.
+     * @param out_up UP vectors, may be null.
+     */
+    void geo_to_world_batch (const double* lon, const double* lat, size_t count, godot::Vector3* out_pos, godot::Vector3* out_up = nullptr) {
+        geo_to_world_batch_impl(lon, lat, count, scale_factor, out_pos, out_up);
+    }
+
+    /* Position and UP vector of one point, sharing the work where the projection allows it. */
+    void geo_to_world_and_up (GeoCoords coords, godot::Vector3& pos, godot::Vector3& up) {
+        const double lon = coords.lon.get_radians(), lat = coords.lat.get_radians();
+        geo_to_world_batch(&lon, &lat, 1, &pos, &up);
+    }
+
+    /* Batch versions of geo_to_world and geo_to_world_up for coordinates in their Vector2 representation. */
+    MAPSHADERS_DLL_SYMBOL godot::PackedVector3Array geo_to_world_batch (godot::PackedVector2Array coords);
+    MAPSHADERS_DLL_SYMBOL godot::PackedVector3Array geo_to_world_up_batch (godot::PackedVector2Array coords);
+
+    /**
+     * @brief Times the per-point projection against the batch one.
+     * @return Dictionary with "point_count", "per_point_usec", "batch_usec", "speedup" and "max_difference".
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary benchmark_batch (int point_count);
+
 
     /* Optional scale factor for your convenience if you're not using 1 unit = 1 m. */
     void set_scale_factor(double factor) {
@@ -178,6 +208,8 @@ public:
 
 protected:
     virtual godot::Vector3 geo_to_world_impl (GeoCoords) = 0;
+    /* Generic batch implementation calling geo_to_world_impl and geo_to_world_up per point. */
+    virtual void geo_to_world_batch_impl (const double* lon, const double* lat, size_t count, double scale, godot::Vector3* out_pos, godot::Vector3* out_up);
     static void _bind_methods();
 
 private:
@@ -233,6 +265,8 @@ public:
 
 protected:
     MAPSHADERS_DLL_SYMBOL virtual godot::Vector3 geo_to_world_impl (GeoCoords) override;
+    /* The projection is affine, so the batch is a vectorized multiply-add. */
+    virtual void geo_to_world_batch_impl (const double* lon, const double* lat, size_t count, double scale, godot::Vector3* out_pos, godot::Vector3* out_up) override;
     static void _bind_methods();
 };
 
@@ -247,6 +281,8 @@ public:
 
 protected:
     MAPSHADERS_DLL_SYMBOL virtual godot::Vector3 geo_to_world_impl (GeoCoords) override;
+    /* Computes sin/cos once per point for both the position and the UP vector. */
+    virtual void geo_to_world_batch_impl (const double* lon, const double* lat, size_t count, double scale, godot::Vector3* out_pos, godot::Vector3* out_up) override;
     static void _bind_methods();
 };
 
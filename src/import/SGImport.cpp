@@ -1,6 +1,7 @@
 #include "SGImport.h"
 #include "osm_parser/OSMParser.h"
 #include "elevation/ElevationParser.h"
+#include "elevation/ElevationMosaic.h"
 #include "coastline/CoastlineParser.h"
 #include <godot_cpp/classes/file_access.hpp>
 #include <godot_cpp/classes/ref.hpp>
@@ -24,7 +25,14 @@ void SGImport::import_elevation(bool) {
     for (int i = 0; i < this->parsers.size(); i++) {
         Ref<Parser> parser = this->parsers[i];
         Ref<ElevationParser> elevation_parser = Object::cast_to<ElevationParser>(*parser);
-        if (elevation_parser.is_valid()) {
+        if (elevation_parser.is_valid() && !elevation_parser->get_directory().is_empty()) {
+            auto mosaic = elevation_parser->import_mosaic();
+            DEMWindow bounds;
+            if (!this->geomap.is_valid() && mosaic->getBounds(bounds)) {
+                this->set_geo_map(godot::Ref<GeoMap>(memnew(EquirectangularGeoMap(bounds.min, bounds.max))));
+            }
+            this->heightmap = mosaic;
+        } else if (elevation_parser.is_valid()) {
             auto returned_grid = elevation_parser->import(this->geomap);
             if (!this->geomap.is_valid()) {
                 this->set_geo_map(returned_grid->get_geo_map());
@@ -44,6 +52,18 @@ void SGImport::import_coastline(bool) {
     }
 }
 
+void SGImport::load_tiles(bool) {
+    for (int i = 0; i < this->parsers.size(); i++) {
+        Ref<Parser> parser = this->parsers[i];
+        Ref<OSMParser> osm_parser = Object::cast_to<OSMParser>(parser.ptr());
+        if (osm_parser.is_valid())
+            osm_parser->load_tiles(false);
+        Ref<CoastlineParser> coastline_parser = Object::cast_to<CoastlineParser>(parser.ptr());
+        if (coastline_parser.is_valid() && coastline_parser->get_tilemap().is_valid())
+            coastline_parser->load_tiles(this->geomap);
+    }
+}
+
 void SGImport::reset_geo_info(bool) {
     this->geomap.unref();
     this->heightmap.unref();
@@ -53,6 +73,7 @@ void SGImport::_bind_methods() {
     ClassDB::bind_method(D_METHOD("import_osm", "plsrefactor"), &SGImport::import_osm);
     ClassDB::bind_method(D_METHOD("import_elevation", "plsrefactor"), &SGImport::import_elevation);
     ClassDB::bind_method(D_METHOD("import_coastline", "plsrefactor"), &SGImport::import_coastline);
+    ClassDB::bind_method(D_METHOD("load_tiles", "plsrefactor"), &SGImport::load_tiles);
     ClassDB::bind_method(D_METHOD("get_true"), &SGImport::get_true);
 
     ClassDB::bind_method(D_METHOD("get_geo_map"), &SGImport::get_geo_map);
@@ -69,6 +90,7 @@ void SGImport::_bind_methods() {
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "import_osm"), "import_osm", "get_true");
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "import_elevation"), "import_elevation", "get_true");
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "import_coastline"), "import_coastline", "get_true");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "load_tiles"), "load_tiles", "get_true");
     
     ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "parsers", PROPERTY_HINT_TYPE_STRING, vformat("%s/%s:%s", Variant::OBJECT, PROPERTY_HINT_RESOURCE_TYPE, "Parser"), PROPERTY_HINT_ARRAY_TYPE), "set_parsers", "get_parsers");
    // ADD_SIGNAL()
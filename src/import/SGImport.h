@@ -37,6 +37,8 @@ public:
     void import_osm(bool);
     void import_elevation(bool);
     void import_coastline(bool);
+    /* Loads the imported tiles of every parser: all OSM tiles and the finest tiled coastline layer. */
+    void load_tiles(bool);
 
     void reset_geo_info(bool);
 
@@ -1,4 +1,8 @@
 #include "TileMap.h"
+#include <cmath>
+#include <queue>
+#include <utility>
+#include <vector>
 
 using namespace godot;
 
@@ -8,14 +12,453 @@ godot::Vector2i TileMapBase::get_tile_geo(godot::Vector2 coords_vec2) {
 
 
 Vector2i EquirectangularTileMap::get_tile_geo(GeoCoords coords) {
-    /* Position in global world space (with origin (0,0)). */
-    Ref<EquirectangularGeoMap> originMap = memnew(EquirectangularGeoMap());
-    Vector3 global_world_pos = originMap->geo_to_world(coords);
-    
-    return Vector2i(std::round(global_world_pos.x / tile_size.x), std::round(global_world_pos.z / tile_size.y));
+    /* Position in global world space (with origin (0,0)), as EquirectangularGeoMap would project it. */
+    const double x = LATITUDE_DEGREE_IN_METRES * coords.lon.get_degrees() / UNIT_IN_METRES;
+    const double z = -LATITUDE_DEGREE_IN_METRES * coords.lat.get_degrees() / UNIT_IN_METRES;
+
+    return Vector2i(std::round(x / tile_size.x), std::round(z / tile_size.y));
 }
 
 godot::TypedArray<godot::Vector2i> EquirectangularTileMap::get_tiles_of_interest(GeoCoords coords, double elevation, godot::Vector3 front_vec)
 {
     return godot::TypedArray<godot::Vector2i>();
 }
+
+/* Quadkey */
+
+namespace {
+    /* atan(sinh(pi)), the latitude where the Web Mercator square ends. */
+    const double MERCATOR_MAX_LATITUDE = 1.4844222297453324;
+    const double EARTH_RADIUS_METERS = 6371000.0;
+    /* Upper bound on how many rings of tiles get_tiles_of_interest returns. */
+    const int MAX_INTEREST_RADIUS = 4;
+}
+
+int64_t QuadkeyTileMap::key_parent(int64_t key) {
+    const int z = key_zoom(key);
+    if (z == 0)
+        return INVALID_KEY;
+    return make_key(z - 1, key_x(key) >> 1, key_y(key) >> 1);
+}
+
+int64_t QuadkeyTileMap::key_child(int64_t key, int child) {
+    const int z = key_zoom(key);
+    if (z >= MAX_ZOOM || child < 0 || child > 3)
+        return INVALID_KEY;
+    return make_key(z + 1, (key_x(key) << 1) | (child & 1), (key_y(key) << 1) | (child >> 1));
+}
+
+int64_t QuadkeyTileMap::key_neighbour(int64_t key, int dx, int dy) {
+    const int z = key_zoom(key);
+    const int64_t n = int64_t(1) << z;
+    const int64_t y = key_y(key) + dy;
+    if (y < 0 || y >= n)
+        return INVALID_KEY;
+    const int64_t x = ((key_x(key) + dx) % n + n) % n;
+    return make_key(z, x, y);
+}
+
+String QuadkeyTileMap::key_to_quadkey(int64_t key) {
+    const int z = key_zoom(key);
+    const int64_t x = key_x(key), y = key_y(key);
+    String quadkey;
+    for (int level = z; level > 0; level--) {
+        const int64_t mask = int64_t(1) << (level - 1);
+        const char digit = '0' + ((x & mask) ? 1 : 0) + ((y & mask) ? 2 : 0);
+        quadkey += String::chr(digit);
+    }
+    return quadkey;
+}
+
+int64_t QuadkeyTileMap::quadkey_to_key(const String& quadkey) {
+    const int z = static_cast<int>(quadkey.length());
+    if (z > MAX_ZOOM)
+        return INVALID_KEY;
+
+    int64_t x = 0, y = 0;
+    for (int i = 0; i < z; i++) {
+        const int digit = quadkey[i] - '0';
+        if (digit < 0 || digit > 3)
+            return INVALID_KEY;
+        x = (x << 1) | (digit & 1);
+        y = (y << 1) | (digit >> 1);
+    }
+    return make_key(z, x, y);
+}
+
+void QuadkeyTileMap::key_bounds(int64_t key, GeoCoords& min_bounds, GeoCoords& max_bounds) {
+    const double n = static_cast<double>(int64_t(1) << key_zoom(key));
+    const double x = static_cast<double>(key_x(key)), y = static_cast<double>(key_y(key));
+    auto lon_of = [n](double tx) { return tx / n * 2.0 * Math_PI - Math_PI; };
+    auto lat_of = [n](double ty) { return std::atan(std::sinh(Math_PI * (1.0 - 2.0 * ty / n))); };
+
+    min_bounds = GeoCoords(Longitude::radians(lon_of(x)), Latitude::radians(lat_of(y + 1.0)));
+    max_bounds = GeoCoords(Longitude::radians(lon_of(x + 1.0)), Latitude::radians(lat_of(y)));
+}
+
+void QuadkeyTileMap::geo_to_tile(double lon, double lat, int zoom, int64_t& x, int64_t& y) {
+    const int64_t n = int64_t(1) << zoom;
+    lat = std::clamp(lat, -MERCATOR_MAX_LATITUDE, MERCATOR_MAX_LATITUDE);
+
+    const double fx = (lon / (2.0 * Math_PI) + 0.5) * n;
+    const double fy = (1.0 - std::asinh(std::tan(lat)) / Math_PI) * 0.5 * n;
+    x = std::clamp(static_cast<int64_t>(std::floor(fx)), int64_t(0), n - 1);
+    y = std::clamp(static_cast<int64_t>(std::floor(fy)), int64_t(0), n - 1);
+}
+
+void QuadkeyTileMap::get_tile_keys_batch(const double* lon, const double* lat, size_t count, int64_t* out_keys) const {
+    for (size_t i = 0; i < count; i++) {
+        int64_t x, y;
+        geo_to_tile(lon[i], lat[i], zoom, x, y);
+        out_keys[i] = make_key(zoom, x, y);
+    }
+}
+
+Vector2i QuadkeyTileMap::get_tile_geo(GeoCoords coords) {
+    int64_t x, y;
+    geo_to_tile(coords.lon.get_radians(), coords.lat.get_radians(), zoom, x, y);
+    return Vector2i(static_cast<int32_t>(x), static_cast<int32_t>(y));
+}
+
+TypedArray<Vector2i> QuadkeyTileMap::get_tiles_of_interest(GeoCoords coords, double elevation, Vector3 front_vec) {
+    int64_t x, y;
+    geo_to_tile(coords.lon.get_radians(), coords.lat.get_radians(), zoom, x, y);
+    const int64_t center = make_key(zoom, x, y);
+
+    // Ground size of a tile at this latitude against the distance to the horizon.
+    const double h = std::max(elevation, 0.0);
+    const double horizon = std::sqrt(h * (2.0 * EARTH_RADIUS_METERS + h));
+    const double tile_size = 2.0 * Math_PI * EARTH_RADIUS_METERS * std::cos(coords.lat.get_radians()) / static_cast<double>(int64_t(1) << zoom);
+    const int radius = tile_size > 0.0 ? std::clamp(static_cast<int>(std::ceil(horizon / tile_size)), 1, MAX_INTEREST_RADIUS) : 1;
+
+    // x wraps around the antimeridian, so a ring wider than the zoom level would visit the same tiles again.
+    const int64_t n = int64_t(1) << zoom;
+    const int dx_min = -static_cast<int>(std::min<int64_t>(radius, (n - 1) / 2));
+    const int dx_max = static_cast<int>(std::min<int64_t>(radius, n - 1 + dx_min));
+
+    TypedArray<Vector2i> tiles;
+    for (int dy = -radius; dy <= radius; dy++) {
+        for (int dx = dx_min; dx <= dx_max; dx++) {
+            const int64_t key = key_neighbour(center, dx, dy);
+            if (key != INVALID_KEY)
+                tiles.append(get_key_tile(key));
+        }
+    }
+    return tiles;
+}
+
+int64_t QuadkeyTileMap::get_tile_key(Vector2 coords) const {
+    int64_t x, y;
+    geo_to_tile(coords.x, coords.y, zoom, x, y);
+    return make_key(zoom, x, y);
+}
+
+PackedInt64Array QuadkeyTileMap::get_tile_keys(PackedVector2Array coords) const {
+    PackedInt64Array keys;
+    keys.resize(coords.size());
+    const Vector2* src = coords.ptr();
+    int64_t* dst = keys.ptrw();
+    for (int64_t i = 0; i < coords.size(); i++) {
+        int64_t x, y;
+        geo_to_tile(src[i].x, src[i].y, zoom, x, y);
+        dst[i] = make_key(zoom, x, y);
+    }
+    return keys;
+}
+
+void QuadkeyTileMap::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("set_zoom", "value"), &QuadkeyTileMap::set_zoom);
+    ClassDB::bind_method(D_METHOD("get_zoom"), &QuadkeyTileMap::get_zoom);
+    ClassDB::bind_method(D_METHOD("get_tile_key", "coords"), &QuadkeyTileMap::get_tile_key);
+    ClassDB::bind_method(D_METHOD("get_tile_keys", "coords"), &QuadkeyTileMap::get_tile_keys);
+
+    ClassDB::bind_static_method("QuadkeyTileMap", D_METHOD("make_key", "zoom", "x", "y"), &QuadkeyTileMap::make_key);
+    ClassDB::bind_static_method("QuadkeyTileMap", D_METHOD("key_zoom", "key"), &QuadkeyTileMap::key_zoom);
+    ClassDB::bind_static_method("QuadkeyTileMap", D_METHOD("get_key_tile", "key"), &QuadkeyTileMap::get_key_tile);
+    ClassDB::bind_static_method("QuadkeyTileMap", D_METHOD("key_parent", "key"), &QuadkeyTileMap::key_parent);
+    ClassDB::bind_static_method("QuadkeyTileMap", D_METHOD("key_child", "key", "child"), &QuadkeyTileMap::key_child);
+    ClassDB::bind_static_method("QuadkeyTileMap", D_METHOD("key_neighbour", "key", "dx", "dy"), &QuadkeyTileMap::key_neighbour);
+    ClassDB::bind_static_method("QuadkeyTileMap", D_METHOD("key_to_quadkey", "key"), &QuadkeyTileMap::key_to_quadkey);
+    ClassDB::bind_static_method("QuadkeyTileMap", D_METHOD("quadkey_to_key", "quadkey"), &QuadkeyTileMap::quadkey_to_key);
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "zoom", PROPERTY_HINT_RANGE, "0,29"), "set_zoom", "get_zoom");
+}
+
+/* Cube sphere */
+
+namespace {
+    struct Vec3d {
+        double x, y, z;
+
+        Vec3d operator+(const Vec3d& rhs) const {
+            return { x + rhs.x, y + rhs.y, z + rhs.z };
+        }
+        Vec3d operator-(const Vec3d& rhs) const {
+            return { x - rhs.x, y - rhs.y, z - rhs.z };
+        }
+        Vec3d operator*(double scalar) const {
+            return { x * scalar, y * scalar, z * scalar };
+        }
+        double dot(const Vec3d& rhs) const {
+            return x * rhs.x + y * rhs.y + z * rhs.z;
+        }
+        Vec3d cross(const Vec3d& rhs) const {
+            return { y * rhs.z - z * rhs.y, z * rhs.x - x * rhs.z, x * rhs.y - y * rhs.x };
+        }
+        double length() const {
+            return std::sqrt(dot(*this));
+        }
+        Vec3d normalized() const {
+            const double l = length();
+            return l > 0.0 ? *this * (1.0 / l) : *this;
+        }
+        Vector3 to_vector3() const {
+            return Vector3(static_cast<real_t>(x), static_cast<real_t>(y), static_cast<real_t>(z));
+        }
+    };
+
+    /* A point on a face is normal + u * axis_u + v * axis_v with u, v in [-1, 1]. */
+    struct CubeFace {
+        Vec3d normal, axis_u, axis_v;
+    };
+
+    const CubeFace CUBE_FACES[6] = {
+        { { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } },
+        { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+        { { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } },
+        { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+        { { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+        { { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1, 0 } },
+    };
+
+    /* Same convention as SphereGeoMap::geo_to_world_impl, on the unit sphere. */
+    Vec3d geo_to_unit(GeoCoords coords) {
+        const double lat = coords.lat.get_radians(), lon = coords.lon.get_radians();
+        return { std::cos(lat) * std::cos(lon), std::sin(lat), -std::cos(lat) * std::sin(lon) };
+    }
+
+    /* Tangent-adjusted face coordinates (s, t in [-1, 1]) to the unit sphere. */
+    Vec3d face_to_unit(int face, double s, double t) {
+        const CubeFace& f = CUBE_FACES[face];
+        return (f.normal + f.axis_u * std::tan(s * Math_PI / 4.0) + f.axis_v * std::tan(t * Math_PI / 4.0)).normalized();
+    }
+
+    void unit_to_face(const Vec3d& d, int& face, double& s, double& t) {
+        const double ax = std::abs(d.x), ay = std::abs(d.y), az = std::abs(d.z);
+        if (ax >= ay && ax >= az)
+            face = d.x >= 0.0 ? 0 : 1;
+        else if (ay >= az)
+            face = d.y >= 0.0 ? 2 : 3;
+        else
+            face = d.z >= 0.0 ? 4 : 5;
+
+        const CubeFace& f = CUBE_FACES[face];
+        const double w = d.dot(f.normal);
+        s = std::atan(d.dot(f.axis_u) / w) * 4.0 / Math_PI;
+        t = std::atan(d.dot(f.axis_v) / w) * 4.0 / Math_PI;
+    }
+
+    /* A tile on the unit sphere. */
+    struct TileShape {
+        Vec3d center;
+        Vec3d corners[4];
+        /* Largest angle between the centre and a corner. */
+        double angular_radius;
+        /* Chord length of one edge. */
+        double edge;
+    };
+
+    TileShape tile_shape(int64_t key) {
+        const int face = CubeSphereTileMap::key_face(key);
+        const double n = static_cast<double>(int64_t(1) << CubeSphereTileMap::key_zoom(key));
+        const double s0 = 2.0 * CubeSphereTileMap::key_x(key) / n - 1.0, s1 = s0 + 2.0 / n;
+        const double t0 = 2.0 * CubeSphereTileMap::key_y(key) / n - 1.0, t1 = t0 + 2.0 / n;
+
+        TileShape shape;
+        shape.center = face_to_unit(face, (s0 + s1) * 0.5, (t0 + t1) * 0.5);
+        shape.corners[0] = face_to_unit(face, s0, t0);
+        shape.corners[1] = face_to_unit(face, s1, t0);
+        shape.corners[2] = face_to_unit(face, s1, t1);
+        shape.corners[3] = face_to_unit(face, s0, t1);
+        shape.angular_radius = 0.0;
+        for (const Vec3d& corner : shape.corners)
+            shape.angular_radius = std::max(shape.angular_radius, std::acos(std::clamp(corner.dot(shape.center), -1.0, 1.0)));
+        shape.edge = (shape.corners[1] - shape.corners[0]).length();
+        return shape;
+    }
+
+    struct ViewPoint {
+        Vec3d position;
+        Vec3d front;
+        bool has_front;
+        double sphere_radius;
+    };
+
+    ViewPoint make_view_point(GeoCoords coords, double elevation, Vector3 front_vec, double sphere_radius) {
+        ViewPoint view;
+        view.position = geo_to_unit(coords) * (sphere_radius + elevation);
+        view.front = Vec3d{ front_vec.x, front_vec.y, front_vec.z }.normalized();
+        view.has_front = view.front.length() > 0.0;
+        view.sphere_radius = sphere_radius;
+        return view;
+    }
+
+    /* Lower bound of the distance from the viewpoint to any point of the tile. */
+    double tile_distance(const TileShape& tile, const ViewPoint& view) {
+        const double chord = 2.0 * view.sphere_radius * std::sin(tile.angular_radius * 0.5);
+        return std::max(0.0, (tile.center * view.sphere_radius - view.position).length() - chord);
+    }
+
+    /* Conservative: false only if the whole tile is beyond the horizon or behind the viewer. */
+    bool tile_visible(const TileShape& tile, const ViewPoint& view) {
+        const double d = view.position.length();
+        if (d > view.sphere_radius) {
+            const double horizon = std::acos(view.sphere_radius / d);
+            const double angle = std::acos(std::clamp(view.position.dot(tile.center) / d, -1.0, 1.0));
+            if (angle - tile.angular_radius > horizon)
+                return false;
+        }
+
+        if (!view.has_front || tile_distance(tile, view) == 0.0)
+            return true;
+        auto in_front = [&view](const Vec3d& p) {
+            return (p * view.sphere_radius - view.position).dot(view.front) >= 0.0;
+        };
+        if (in_front(tile.center))
+            return true;
+        for (const Vec3d& corner : tile.corners) {
+            if (in_front(corner))
+                return true;
+        }
+        return false;
+    }
+}
+
+int64_t CubeSphereTileMap::key_parent(int64_t key) {
+    const int z = key_zoom(key);
+    if (z == 0)
+        return INVALID_KEY;
+    return make_key(key_face(key), z - 1, key_x(key) >> 1, key_y(key) >> 1);
+}
+
+int64_t CubeSphereTileMap::key_child(int64_t key, int child) {
+    const int z = key_zoom(key);
+    if (z >= MAX_ZOOM || child < 0 || child > 3)
+        return INVALID_KEY;
+    return make_key(key_face(key), z + 1, (key_x(key) << 1) | (child & 1), (key_y(key) << 1) | (child >> 1));
+}
+
+int64_t CubeSphereTileMap::geo_to_key(GeoCoords coords, int zoom) {
+    int face;
+    double s, t;
+    unit_to_face(geo_to_unit(coords), face, s, t);
+
+    const int64_t n = int64_t(1) << zoom;
+    const int64_t x = std::clamp(static_cast<int64_t>(std::floor((s + 1.0) * 0.5 * n)), int64_t(0), n - 1);
+    const int64_t y = std::clamp(static_cast<int64_t>(std::floor((t + 1.0) * 0.5 * n)), int64_t(0), n - 1);
+    return make_key(face, zoom, x, y);
+}
+
+Vector2i CubeSphereTileMap::get_tile_geo(GeoCoords coords) {
+    const int64_t key = geo_to_key(coords, zoom);
+    return Vector2i(static_cast<int32_t>((int64_t(key_face(key)) << zoom) + key_x(key)), static_cast<int32_t>(key_y(key)));
+}
+
+TypedArray<Vector2i> CubeSphereTileMap::get_tiles_of_interest(GeoCoords coords, double elevation, Vector3 front_vec) {
+    const ViewPoint view = make_view_point(coords, elevation, front_vec, radius);
+
+    // Best-first descent: the nearest candidate is refined first, culled or distant subtrees are never expanded.
+    using Candidate = std::pair<double, int64_t>;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+    auto push = [&](int64_t key) {
+        const TileShape shape = tile_shape(key);
+        const double distance = tile_distance(shape, view);
+        if (distance <= view_distance && tile_visible(shape, view))
+            candidates.push({ distance, key });
+    };
+    for (int face = 0; face < 6; face++)
+        push(make_key(face, 0, 0, 0));
+
+    TypedArray<Vector2i> tiles;
+    while (!candidates.empty() && tiles.size() < max_tiles) {
+        const int64_t key = candidates.top().second;
+        candidates.pop();
+        if (key_zoom(key) == zoom) {
+            tiles.append(Vector2i(static_cast<int32_t>((int64_t(key_face(key)) << zoom) + key_x(key)), static_cast<int32_t>(key_y(key))));
+            continue;
+        }
+        for (int child = 0; child < 4; child++)
+            push(key_child(key, child));
+    }
+    return tiles;
+}
+
+PackedInt64Array CubeSphereTileMap::get_lod_tile_keys(Vector2 coords, double elevation, Vector3 front_vec) const {
+    const ViewPoint view = make_view_point(GeoCoords::from_vector2_representation(coords), elevation, front_vec, radius);
+
+    // Breadth-first, so coarse tiles are refined evenly; queued plus emitted keys never exceed max_tiles.
+    std::vector<int64_t> queue;
+    for (int face = 0; face < 6; face++) {
+        const int64_t key = make_key(face, 0, 0, 0);
+        if (tile_visible(tile_shape(key), view))
+            queue.push_back(key);
+    }
+
+    PackedInt64Array keys;
+    for (size_t head = 0; head < queue.size(); head++) {
+        const int64_t key = queue[head];
+        const TileShape shape = tile_shape(key);
+        const size_t pending = queue.size() - head - 1;
+        const bool split = key_zoom(key) < zoom &&
+                           tile_distance(shape, view) < lod_factor * shape.edge * radius &&
+                           static_cast<size_t>(keys.size()) + pending + 4 <= static_cast<size_t>(max_tiles);
+        if (!split) {
+            keys.append(key);
+            continue;
+        }
+        for (int child = 0; child < 4; child++) {
+            const int64_t child_key = key_child(key, child);
+            if (tile_visible(tile_shape(child_key), view))
+                queue.push_back(child_key);
+        }
+    }
+    return keys;
+}
+
+Transform3D CubeSphereTileMap::get_tile_transform(int64_t key) const {
+    const TileShape shape = tile_shape(key);
+    const Vec3d up = shape.center;
+    const Vec3d axis_u = CUBE_FACES[key_face(key)].axis_u;
+    const Vec3d x_axis = (axis_u - up * axis_u.dot(up)).normalized();
+    const Vec3d z_axis = x_axis.cross(up);
+
+    return Transform3D(Basis(x_axis.to_vector3(), up.to_vector3(), z_axis.to_vector3()), (up * radius).to_vector3());
+}
+
+void CubeSphereTileMap::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_tile_key", "coords"), &CubeSphereTileMap::get_tile_key);
+    ClassDB::bind_method(D_METHOD("get_lod_tile_keys", "coords", "elevation", "front_vec"), &CubeSphereTileMap::get_lod_tile_keys);
+    ClassDB::bind_method(D_METHOD("get_tile_transform", "key"), &CubeSphereTileMap::get_tile_transform);
+
+    ClassDB::bind_static_method("CubeSphereTileMap", D_METHOD("key_face", "key"), &CubeSphereTileMap::key_face);
+    ClassDB::bind_static_method("CubeSphereTileMap", D_METHOD("key_zoom", "key"), &CubeSphereTileMap::key_zoom);
+    ClassDB::bind_static_method("CubeSphereTileMap", D_METHOD("key_parent", "key"), &CubeSphereTileMap::key_parent);
+    ClassDB::bind_static_method("CubeSphereTileMap", D_METHOD("key_child", "key", "child"), &CubeSphereTileMap::key_child);
+
+    ClassDB::bind_method(D_METHOD("set_zoom", "value"), &CubeSphereTileMap::set_zoom);
+    ClassDB::bind_method(D_METHOD("get_zoom"), &CubeSphereTileMap::get_zoom);
+    ClassDB::bind_method(D_METHOD("set_radius", "value"), &CubeSphereTileMap::set_radius);
+    ClassDB::bind_method(D_METHOD("get_radius"), &CubeSphereTileMap::get_radius);
+    ClassDB::bind_method(D_METHOD("set_view_distance", "value"), &CubeSphereTileMap::set_view_distance);
+    ClassDB::bind_method(D_METHOD("get_view_distance"), &CubeSphereTileMap::get_view_distance);
+    ClassDB::bind_method(D_METHOD("set_lod_factor", "value"), &CubeSphereTileMap::set_lod_factor);
+    ClassDB::bind_method(D_METHOD("get_lod_factor"), &CubeSphereTileMap::get_lod_factor);
+    ClassDB::bind_method(D_METHOD("set_max_tiles", "value"), &CubeSphereTileMap::set_max_tiles);
+    ClassDB::bind_method(D_METHOD("get_max_tiles"), &CubeSphereTileMap::get_max_tiles);
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "zoom", PROPERTY_HINT_RANGE, "0,27"), "set_zoom", "get_zoom");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "radius"), "set_radius", "get_radius");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "view_distance"), "set_view_distance", "get_view_distance");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "lod_factor"), "set_lod_factor", "get_lod_factor");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_tiles"), "set_max_tiles", "get_max_tiles");
+}
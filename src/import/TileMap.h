@@ -1,6 +1,10 @@
 #ifndef TILEMAP_H
 #define TILEMAP_H
 #include <godot_cpp/classes/resource.hpp>
+#include <algorithm>
+#include <godot_cpp/variant/packed_int64_array.hpp>
+#include <godot_cpp/variant/transform3d.hpp>
+#include <godot_cpp/variant/typed_array.hpp>
 #include "GeoMap.h"
 
 class TileMapBase : public godot::Resource {
@@ -53,4 +57,193 @@ private:
     godot::Vector2 tile_size;
 };
 
+/**
+ * Web Mercator tile pyramid, i.e. the z/x/y scheme of slippy maps (x grows east, y grows south).
+ *
+ * Tiles are addressed by 64-bit keys packing zoom, x and y, so parents, children and neighbours are
+ * integer arithmetic and keys of different zoom levels never collide. get_tile_geo returns (x, y)
+ * at the configured zoom, which is what .sgdmap tile indices are built from.
+ */
+class QuadkeyTileMap : public TileMapBase {
+    GDCLASS(QuadkeyTileMap, TileMapBase);
+
+public:
+    /* Key layout: zoom in bits 58-62, x in bits 29-57, y in bits 0-28. */
+    static constexpr int MAX_ZOOM = 29;
+    static constexpr int64_t INVALID_KEY = -1;
+
+    QuadkeyTileMap(bool use_geo = false) : TileMapBase(use_geo), zoom(15) {}
+
+    static int64_t make_key(int zoom, int64_t x, int64_t y) {
+        return (static_cast<int64_t>(zoom) << 58) | (x << 29) | y;
+    }
+    static int key_zoom(int64_t key) {
+        return static_cast<int>(key >> 58);
+    }
+    static int64_t key_x(int64_t key) {
+        return (key >> 29) & TILE_MASK;
+    }
+    static int64_t key_y(int64_t key) {
+        return key & TILE_MASK;
+    }
+
+    /* @return The key of the tile one zoom level up, or INVALID_KEY at zoom 0. */
+    static int64_t key_parent(int64_t key);
+    /* @param child 0-3, bit 0 selects the east half and bit 1 the south half. @return INVALID_KEY at MAX_ZOOM. */
+    static int64_t key_child(int64_t key, int child);
+    /* Wraps around the antimeridian. @return INVALID_KEY past the poles. */
+    static int64_t key_neighbour(int64_t key, int dx, int dy);
+
+    /* Bing Maps style quadkey string ("" for the zoom 0 tile). */
+    static godot::String key_to_quadkey(int64_t key);
+    static int64_t quadkey_to_key(const godot::String& quadkey);
+
+    /* Geo bounds of a tile. */
+    static void key_bounds(int64_t key, GeoCoords& min_bounds, GeoCoords& max_bounds);
+
+    /* Tile containing the point at the given zoom. Latitudes past the Mercator limit are clamped. */
+    static void geo_to_tile(double lon, double lat, int zoom, int64_t& x, int64_t& y);
+
+    /* Assigns tile keys at the configured zoom to many points (radians) without allocating. */
+    void get_tile_keys_batch(const double* lon, const double* lat, size_t count, int64_t* out_keys) const;
+
+    virtual godot::Vector2i get_tile_geo(GeoCoords) override;
+
+    /* Tiles around coords, out to the horizon distance from the given elevation (bounded). */
+    virtual godot::TypedArray<godot::Vector2i> get_tiles_of_interest(GeoCoords coords, double elevation, godot::Vector3 front_vec) override;
+
+    int64_t get_tile_key(godot::Vector2 coords) const;
+    godot::PackedInt64Array get_tile_keys(godot::PackedVector2Array coords) const;
+    static godot::Vector2i get_key_tile(int64_t key) {
+        return godot::Vector2i(static_cast<int32_t>(key_x(key)), static_cast<int32_t>(key_y(key)));
+    }
+
+    void set_zoom(int value) {
+        zoom = std::clamp(value, 0, MAX_ZOOM);
+    }
+    int get_zoom() const {
+        return zoom;
+    }
+
+protected:
+    static void _bind_methods();
+
+private:
+    static constexpr int64_t TILE_MASK = (int64_t(1) << 29) - 1;
+
+    int zoom;
+};
+
+/**
+ * Six-face quadtree over a cube projected onto the sphere, to pair with SphereGeoMap.
+ *
+ * Face coordinates are tangent-adjusted (u = tan(s * pi / 4)), which keeps tile areas within about
+ * 1.4x of each other over the whole globe, unlike a planar grid. Each tile has a local frame on the
+ * sphere so tile geometry can be stored relative to it and keep float precision at planet scale.
+ *
+ * Keys pack face (bits 59-61), zoom (bits 54-58), x (bits 27-53) and y (bits 0-26). get_tile_geo
+ * returns (face * 2^zoom + x, y) at the configured zoom, i.e. the six faces side by side.
+ */
+class CubeSphereTileMap : public TileMapBase {
+    GDCLASS(CubeSphereTileMap, TileMapBase);
+
+public:
+    static constexpr int MAX_ZOOM = 27;
+    static constexpr int64_t INVALID_KEY = -1;
+
+    CubeSphereTileMap(bool use_geo = false) : TileMapBase(use_geo), zoom(13), radius(6371000.0), view_distance(20000.0), lod_factor(2.0), max_tiles(256) {}
+
+    static int64_t make_key(int face, int zoom, int64_t x, int64_t y) {
+        return (static_cast<int64_t>(face) << 59) | (static_cast<int64_t>(zoom) << 54) | (x << 27) | y;
+    }
+    static int key_face(int64_t key) {
+        return static_cast<int>((key >> 59) & 7);
+    }
+    static int key_zoom(int64_t key) {
+        return static_cast<int>((key >> 54) & 31);
+    }
+    static int64_t key_x(int64_t key) {
+        return (key >> 27) & TILE_MASK;
+    }
+    static int64_t key_y(int64_t key) {
+        return key & TILE_MASK;
+    }
+    static int64_t key_parent(int64_t key);
+    /* @param child 0-3, bit 0 selects +x and bit 1 selects +y. */
+    static int64_t key_child(int64_t key, int child);
+
+    /* Tile containing the point at the given zoom. */
+    static int64_t geo_to_key(GeoCoords coords, int zoom);
+
+    virtual godot::Vector2i get_tile_geo(GeoCoords) override;
+
+    /**
+     * Tiles at the configured zoom that pass horizon and backface culling and lie within view_distance,
+     * nearest first, at most max_tiles.
+     * @param front_vec Viewing direction in world space; a zero vector disables backface culling.
+     */
+    virtual godot::TypedArray<godot::Vector2i> get_tiles_of_interest(GeoCoords coords, double elevation, godot::Vector3 front_vec) override;
+
+    /**
+     * Visible tiles of mixed zoom: a tile is split while the camera is closer than lod_factor times its
+     * edge length, down to the configured zoom, never returning more than max_tiles keys.
+     */
+    godot::PackedInt64Array get_lod_tile_keys(godot::Vector2 coords, double elevation, godot::Vector3 front_vec) const;
+
+    /* Local frame of a tile: origin at its centre on the sphere, Y along the surface normal. */
+    godot::Transform3D get_tile_transform(int64_t key) const;
+
+    int64_t get_tile_key(godot::Vector2 coords) const {
+        return geo_to_key(GeoCoords::from_vector2_representation(coords), zoom);
+    }
+
+    void set_zoom(int value) {
+        zoom = std::clamp(value, 0, MAX_ZOOM);
+    }
+    int get_zoom() const {
+        return zoom;
+    }
+
+    /* Sphere radius in world units, i.e. the SphereGeoMap radius times its scale. */
+    void set_radius(double value) {
+        radius = value;
+    }
+    double get_radius() const {
+        return radius;
+    }
+
+    void set_view_distance(double value) {
+        view_distance = value;
+    }
+    double get_view_distance() const {
+        return view_distance;
+    }
+
+    void set_lod_factor(double value) {
+        lod_factor = value;
+    }
+    double get_lod_factor() const {
+        return lod_factor;
+    }
+
+    void set_max_tiles(int value) {
+        max_tiles = std::max(value, 1);
+    }
+    int get_max_tiles() const {
+        return max_tiles;
+    }
+
+protected:
+    static void _bind_methods();
+
+private:
+    static constexpr int64_t TILE_MASK = (int64_t(1) << 27) - 1;
+
+    int zoom;
+    double radius;
+    double view_distance;
+    double lod_factor;
+    int max_tiles;
+};
+
 #endif // TILEMAP_H
\ No newline at end of file
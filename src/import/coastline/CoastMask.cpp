@@ -0,0 +1,242 @@
+#include "CoastMask.h"
+#include "../GeoMap.h"
+#include "../../util/Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace godot;
+
+namespace {
+    const int BAND = 64;
+    const double INF = std::numeric_limits<double>::infinity();
+
+    /* Polygon edge in cell coordinates, cell centres being at integers. */
+    struct Edge {
+        double x0, y0, x1, y1;
+    };
+
+    /**
+     * Squared distance transform of one line (Felzenszwalb and Huttenlocher): d[q] = min over p of f[p] + ((q - p) * spacing)^2.
+     * v and z are scratch space of n and n + 1 entries.
+     */
+    void distance_transform(const double* f, int n, double spacing, double* d, int* v, double* z) {
+        int k = -1;
+        for (int q = 0; q < n; q++) {
+            if (f[q] == INF)
+                continue;
+            const double xq = q * spacing;
+            double s = -INF;
+            while (k >= 0) {
+                const double xv = v[k] * spacing;
+                s = ((f[q] + xq * xq) - (f[v[k]] + xv * xv)) / (2.0 * (xq - xv));
+                if (s > z[k])
+                    break;
+                k--;
+            }
+            k++;
+            v[k] = q;
+            z[k] = k == 0 ? -INF : s;
+            z[k + 1] = INF;
+        }
+        if (k < 0) {
+            std::fill(d, d + n, INF);
+            return;
+        }
+
+        k = 0;
+        for (int q = 0; q < n; q++) {
+            const double xq = q * spacing;
+            while (z[k + 1] < xq)
+                k++;
+            const double dx = xq - v[k] * spacing;
+            d[q] = dx * dx + f[v[k]];
+        }
+    }
+
+    /* Squared distance from every cell to the nearest cell of the given kind. */
+    std::vector<double> squared_distances(const std::vector<uint8_t>& land, uint8_t target, int width, int height, double cell_width, double cell_height) {
+        std::vector<double> squared(land.size());
+        parallel_for_ranges(static_cast<size_t>(height), [&](size_t begin, size_t end, size_t) {
+            std::vector<double> f(width);
+            std::vector<int> v(width);
+            std::vector<double> z(width + 1);
+            for (size_t row = begin; row < end; row++) {
+                const size_t base = row * width;
+                for (int col = 0; col < width; col++)
+                    f[col] = land[base + col] == target ? 0.0 : INF;
+                distance_transform(f.data(), width, cell_width, squared.data() + base, v.data(), z.data());
+            }
+        }, 16);
+
+        parallel_for_ranges(static_cast<size_t>(width), [&](size_t begin, size_t end, size_t) {
+            std::vector<double> f(height), d(height);
+            std::vector<int> v(height);
+            std::vector<double> z(height + 1);
+            for (size_t col = begin; col < end; col++) {
+                for (int row = 0; row < height; row++)
+                    f[row] = squared[static_cast<size_t>(row) * width + col];
+                distance_transform(f.data(), height, cell_height, d.data(), v.data(), z.data());
+                for (int row = 0; row < height; row++)
+                    squared[static_cast<size_t>(row) * width + col] = d[row];
+            }
+        }, 16);
+        return squared;
+    }
+}
+
+bool CoastMask::build(const ShapefilePolygons& polygons, double min_lon, double min_lat, double max_lon, double max_lat,
+                      double resolution, bool polygons_are_land, bool with_distance) {
+    width = height = 0;
+    land.clear();
+    distances.clear();
+    if (!(resolution > 0.0) || !(max_lon > min_lon) || !(max_lat > min_lat))
+        return false;
+
+    const double cos_latitude = std::max(std::cos(0.5 * (min_lat + max_lat) * Math_PI / 180.0), 1e-6);
+    cell_lat = resolution / LATITUDE_DEGREE_IN_METRES;
+    cell_lon = cell_lat / cos_latitude;
+    const double columns = std::ceil((max_lon - min_lon) / cell_lon), rows = std::ceil((max_lat - min_lat) / cell_lat);
+    if (columns > MAX_SIZE || rows > MAX_SIZE) {
+        WARN_PRINT("Coast mask of " + String::num_int64(static_cast<int64_t>(columns)) + "x" + String::num_int64(static_cast<int64_t>(rows)) +
+                   " cells is too large; use a coarser resolution.");
+        return false;
+    }
+    this->min_lon = min_lon;
+    this->max_lat = max_lat;
+    width = static_cast<int>(columns);
+    height = static_cast<int>(rows);
+
+    // Edges go into every band of rows they span, so each band only scans its own.
+    std::vector<Edge> edges;
+    const int band_count = (height + BAND - 1) / BAND;
+    std::vector<std::vector<uint32_t>> band_edges(band_count);
+    for (size_t r = 0; r < polygons.ring_count(); r++) {
+        for (uint32_t i = polygons.ring_offsets[r]; i + 1 < polygons.ring_offsets[r + 1]; i++) {
+            const Edge e = { (polygons.lon[i] - min_lon) / cell_lon - 0.5, (max_lat - polygons.lat[i]) / cell_lat - 0.5,
+                             (polygons.lon[i + 1] - min_lon) / cell_lon - 0.5, (max_lat - polygons.lat[i + 1]) / cell_lat - 0.5 };
+            const double y_min = std::min(e.y0, e.y1), y_max = std::max(e.y0, e.y1);
+            if (y_max < 0.0 || y_min > height - 1 || y_min == y_max)
+                continue;
+            const int first = std::max(0, static_cast<int>(std::floor(y_min)) / BAND);
+            const int last = std::min(band_count - 1, static_cast<int>(std::floor(y_max)) / BAND);
+            for (int b = first; b <= last; b++)
+                band_edges[b].push_back(static_cast<uint32_t>(edges.size()));
+            edges.push_back(e);
+        }
+    }
+
+    const uint8_t inside = polygons_are_land ? 1 : 0;
+    land.assign(static_cast<size_t>(width) * height, 1 - inside);
+    parallel_for(static_cast<size_t>(band_count), [&](size_t band, size_t) {
+        std::vector<double> crossings;
+        const int row_end = std::min(height, static_cast<int>(band + 1) * BAND);
+        for (int row = static_cast<int>(band) * BAND; row < row_end; row++) {
+            crossings.clear();
+            for (uint32_t i : band_edges[band]) {
+                const Edge& e = edges[i];
+                if ((e.y0 <= row) != (e.y1 <= row))
+                    crossings.push_back(e.x0 + (row - e.y0) * (e.x1 - e.x0) / (e.y1 - e.y0));
+            }
+            std::sort(crossings.begin(), crossings.end());
+            uint8_t* dst = land.data() + static_cast<size_t>(row) * width;
+            for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+                const int begin = static_cast<int>(std::max(0.0, std::ceil(crossings[k])));
+                const int end = static_cast<int>(std::min<double>(width, std::ceil(crossings[k + 1])));
+                for (int col = begin; col < end; col++)
+                    dst[col] = inside;
+            }
+        }
+    });
+
+    if (with_distance)
+        compute_distances(resolution, resolution);
+    return true;
+}
+
+void CoastMask::compute_distances(double cell_width, double cell_height) {
+    const std::vector<double> to_water = squared_distances(land, 0, width, height, cell_width, cell_height);
+    const std::vector<double> to_land = squared_distances(land, 1, width, height, cell_width, cell_height);
+
+    // Without any cell of the other kind, the distance is at least the size of the area.
+    const double far = width * cell_width + height * cell_height;
+    distances.resize(land.size());
+    parallel_for_ranges(land.size(), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            const double squared = land[i] ? to_water[i] : to_land[i];
+            const double distance = squared == INF ? far : std::sqrt(squared);
+            distances[i] = static_cast<float>(land[i] ? distance : -distance);
+        }
+    }, 65536);
+}
+
+bool CoastMask::cell_of(const Vector2& geo, int& col, int& row) const {
+    if (land.empty())
+        return false;
+    const GeoCoords coords = GeoCoords::from_vector2_representation(geo);
+    const double x = std::floor((coords.lon.get_degrees() - min_lon) / cell_lon);
+    const double y = std::floor((max_lat - coords.lat.get_degrees()) / cell_lat);
+    if (!(x >= 0.0 && x < width && y >= 0.0 && y < height))
+        return false;
+    col = static_cast<int>(x);
+    row = static_cast<int>(y);
+    return true;
+}
+
+bool CoastMask::is_land(const Vector2& geo) const {
+    int col, row;
+    return cell_of(geo, col, row) && land[static_cast<size_t>(row) * width + col] != 0;
+}
+
+double CoastMask::get_distance(const Vector2& geo) const {
+    int col, row;
+    if (distances.empty() || !cell_of(geo, col, row))
+        return 0.0;
+    return distances[static_cast<size_t>(row) * width + col];
+}
+
+Vector2 CoastMask::get_min_geo() const {
+    return GeoCoords(Longitude::degrees(min_lon), Latitude::degrees(max_lat - height * cell_lat)).to_vector2_representation();
+}
+
+Vector2 CoastMask::get_max_geo() const {
+    return GeoCoords(Longitude::degrees(min_lon + width * cell_lon), Latitude::degrees(max_lat)).to_vector2_representation();
+}
+
+Ref<Image> CoastMask::get_mask_image(bool mipmaps) const {
+    if (land.empty())
+        return Ref<Image>();
+    PackedByteArray bytes;
+    bytes.resize(static_cast<int64_t>(land.size()));
+    uint8_t* dst = bytes.ptrw();
+    for (size_t i = 0; i < land.size(); i++)
+        dst[i] = land[i] ? 255 : 0;
+    Ref<Image> image = Image::create_from_data(width, height, false, Image::FORMAT_L8, bytes);
+    if (mipmaps)
+        image->generate_mipmaps();
+    return image;
+}
+
+Ref<Image> CoastMask::get_distance_image(bool mipmaps) const {
+    if (distances.empty())
+        return Ref<Image>();
+    PackedByteArray bytes;
+    bytes.resize(static_cast<int64_t>(distances.size() * sizeof(float)));
+    std::memcpy(bytes.ptrw(), distances.data(), bytes.size());
+    Ref<Image> image = Image::create_from_data(width, height, false, Image::FORMAT_RF, bytes);
+    if (mipmaps)
+        image->generate_mipmaps();
+    return image;
+}
+
+void CoastMask::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_width"), &CoastMask::get_width);
+    ClassDB::bind_method(D_METHOD("get_height"), &CoastMask::get_height);
+    ClassDB::bind_method(D_METHOD("is_land", "geo"), &CoastMask::is_land);
+    ClassDB::bind_method(D_METHOD("get_distance", "geo"), &CoastMask::get_distance);
+    ClassDB::bind_method(D_METHOD("get_min_geo"), &CoastMask::get_min_geo);
+    ClassDB::bind_method(D_METHOD("get_max_geo"), &CoastMask::get_max_geo);
+    ClassDB::bind_method(D_METHOD("get_mask_image", "mipmaps"), &CoastMask::get_mask_image, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("get_distance_image", "mipmaps"), &CoastMask::get_distance_image, DEFVAL(false));
+}
@@ -0,0 +1,79 @@
+#ifndef COAST_MASK_H
+#define COAST_MASK_H
+#include "Shapefile.h"
+#include "../../util/Util.h"
+#include <godot_cpp/classes/image.hpp>
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Land/water raster of an area, rasterized from coastline polygons.
+ *
+ * Cells are square on the ground: resolution metres north to south and, at the middle latitude of the
+ * area, west to east. Row 0 is the northmost. A cell is land if its centre is; the signed distance is
+ * from a cell centre to the nearest centre of the other kind in metres, positive on land.
+ */
+class CoastMask : public godot::RefCounted {
+    GDCLASS(CoastMask, godot::RefCounted);
+public:
+    /* Largest width or height of the raster. */
+    static constexpr int MAX_SIZE = 16384;
+
+    /**
+     * Rasterizes polygons (degrees) with an even-odd scanline fill, rows in parallel.
+     * @param polygons_are_land Whether the polygons are land (e.g. land_polygons.shp) or water.
+     * @param with_distance Whether to also compute the signed distance field.
+     * @return false if the area is empty or the raster would be larger than MAX_SIZE.
+     */
+    bool build(const ShapefilePolygons& polygons, double min_lon, double min_lat, double max_lon, double max_lat,
+               double resolution, bool polygons_are_land, bool with_distance);
+
+    int get_width() const {
+        return width;
+    }
+    int get_height() const {
+        return height;
+    }
+    const uint8_t* get_land() const {
+        return land.data();
+    }
+    /* Null if the mask was built without distances. */
+    const float* get_distances() const {
+        return distances.empty() ? nullptr : distances.data();
+    }
+
+    /* Whether the point (Vector2 geo representation) is on land; points outside the area are water. */
+    MAPSHADERS_DLL_SYMBOL bool is_land(const godot::Vector2& geo) const;
+    /* Signed distance to the coast at the point in metres, 0 outside the area or without distances. */
+    MAPSHADERS_DLL_SYMBOL double get_distance(const godot::Vector2& geo) const;
+
+    /* Geo bounds in the Vector2 representation: (min lon, min lat) and (max lon, max lat). */
+    MAPSHADERS_DLL_SYMBOL godot::Vector2 get_min_geo() const;
+    MAPSHADERS_DLL_SYMBOL godot::Vector2 get_max_geo() const;
+
+    /* Land as 255 and water as 0 in a width x height FORMAT_L8 image. */
+    MAPSHADERS_DLL_SYMBOL godot::Ref<godot::Image> get_mask_image(bool mipmaps = true) const;
+    /* Signed distances in a width x height FORMAT_RF image, null without distances. */
+    MAPSHADERS_DLL_SYMBOL godot::Ref<godot::Image> get_distance_image(bool mipmaps = false) const;
+
+protected:
+    static void _bind_methods();
+
+private:
+    /* Cell of a point, false if it lies outside the area. */
+    bool cell_of(const godot::Vector2& geo, int& col, int& row) const;
+    void compute_distances(double cell_width, double cell_height);
+
+    int width = 0;
+    int height = 0;
+    /* Degrees. */
+    double min_lon = 0.0, max_lat = 0.0;
+    double cell_lon = 0.0, cell_lat = 0.0;
+    std::vector<uint8_t> land;
+    std::vector<float> distances;
+};
+
+#endif // COAST_MASK_H
@@ -0,0 +1,520 @@
+#include "CoastlineGeometry.h"
+#include "../GeoMap.h"
+#include "../../util/Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace {
+    struct Point {
+        double x, y;
+
+        bool operator==(const Point& other) const {
+            return x == other.x && y == other.y;
+        }
+    };
+    /* Open ring: the first point is not repeated at the end. */
+    using Ring = std::vector<Point>;
+    /* Outer ring followed by its holes. */
+    using Polygon = std::vector<Ring>;
+
+    double cross(Point o, Point a, Point b) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+
+    double signed_area(const Ring& ring) {
+        double area = 0.0;
+        for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+            area += ring[j].x * ring[i].y - ring[i].x * ring[j].y;
+        return 0.5 * area;
+    }
+
+    /* Even-odd test. */
+    bool contains(const Ring& ring, Point p) {
+        bool inside = false;
+        for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+            const Point a = ring[j], b = ring[i];
+            if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y))
+                inside = !inside;
+        }
+        return inside;
+    }
+
+    void push_unique(Ring& ring, Point p) {
+        if (ring.empty() || !(ring.back() == p))
+            ring.push_back(p);
+    }
+
+    Polygon read_polygon(const ShapefilePolygons& in, size_t polygon) {
+        Polygon rings;
+        for (uint32_t r = in.polygon_offsets[polygon]; r < in.polygon_offsets[polygon + 1]; r++) {
+            Ring ring;
+            for (uint32_t i = in.ring_offsets[r]; i < in.ring_offsets[r + 1]; i++)
+                push_unique(ring, { in.lon[i], in.lat[i] });
+            if (ring.size() > 1 && ring.front() == ring.back())
+                ring.pop_back();
+            if (ring.size() >= 3)
+                rings.push_back(std::move(ring));
+            else if (r == in.polygon_offsets[polygon])
+                return Polygon(); // without its outer ring there is no polygon
+        }
+        return rings;
+    }
+
+    void append_polygon(const Polygon& polygon, ShapefilePolygons& out) {
+        for (const Ring& ring : polygon) {
+            for (const Point& p : ring) {
+                out.lon.push_back(p.x);
+                out.lat.push_back(p.y);
+            }
+            out.lon.push_back(ring[0].x);
+            out.lat.push_back(ring[0].y);
+            out.ring_offsets.push_back(static_cast<uint32_t>(out.lon.size()));
+        }
+        out.polygon_offsets.push_back(static_cast<uint32_t>(out.ring_count()));
+    }
+
+    /* Runs process(polygon, results) on every polygon of in in parallel and appends the results to out, in input order. */
+    template <typename F>
+    void process_polygons(const ShapefilePolygons& in, ShapefilePolygons& out, F process) {
+        std::vector<std::vector<Polygon>> results(in.polygon_count());
+        parallel_for(in.polygon_count(), [&](size_t p, size_t) {
+            Polygon polygon = read_polygon(in, p);
+            if (!polygon.empty())
+                process(std::move(polygon), results[p]);
+        });
+        for (const auto& polygons : results)
+            for (const Polygon& polygon : polygons)
+                append_polygon(polygon, out);
+    }
+
+    /* Clipping */
+
+    struct Box {
+        double min_x, min_y, max_x, max_y;
+
+        bool outside(Point p) const {
+            return p.x < min_x || p.x > max_x || p.y < min_y || p.y > max_y;
+        }
+        bool on_same_edge(Point a, Point b) const {
+            return (a.x == min_x && b.x == min_x) || (a.x == max_x && b.x == max_x) || (a.y == min_y && b.y == min_y) || (a.y == max_y && b.y == max_y);
+        }
+        /* Moves a point computed on the boundary exactly onto it. */
+        Point snap(Point p) const {
+            const double eps_x = 1e-12 * (max_x - min_x), eps_y = 1e-12 * (max_y - min_y);
+            p.x = std::clamp(p.x, min_x, max_x);
+            p.y = std::clamp(p.y, min_y, max_y);
+            if (p.x - min_x <= eps_x)
+                p.x = min_x;
+            else if (max_x - p.x <= eps_x)
+                p.x = max_x;
+            if (p.y - min_y <= eps_y)
+                p.y = min_y;
+            else if (max_y - p.y <= eps_y)
+                p.y = max_y;
+            return p;
+        }
+        Point corner(int i) const {
+            switch (i & 3) {
+                case 0: return { min_x, min_y };
+                case 1: return { max_x, min_y };
+                case 2: return { max_x, max_y };
+                default: return { min_x, max_y };
+            }
+        }
+        /* Position of a boundary point, counter-clockwise from the min corner: edge index plus the fraction along the edge. */
+        double boundary_position(Point p) const {
+            const double to_edge[4] = { std::abs(p.y - min_y), std::abs(p.x - max_x), std::abs(p.y - max_y), std::abs(p.x - min_x) };
+            const int edge = static_cast<int>(std::min_element(to_edge, to_edge + 4) - to_edge);
+            double position;
+            switch (edge) {
+                case 0: position = (p.x - min_x) / (max_x - min_x); break;
+                case 1: position = 1.0 + (p.y - min_y) / (max_y - min_y); break;
+                case 2: position = 2.0 + (max_x - p.x) / (max_x - min_x); break;
+                default: position = 3.0 + (max_y - p.y) / (max_y - min_y); break;
+            }
+            return position >= 4.0 ? 0.0 : position;
+        }
+    };
+
+    double ccw_distance(double from, double to) {
+        return to >= from ? to - from : to - from + 4.0;
+    }
+
+    /* Appends the corners passed going counter-clockwise along the boundary between two boundary positions. */
+    void walk_boundary(const Box& box, double from, double to, Ring& ring) {
+        const double end = from + ccw_distance(from, to);
+        for (int c = static_cast<int>(std::floor(from)) + 1; c < end; c++)
+            push_unique(ring, box.corner(c));
+    }
+
+    /**
+     * Liang-Barsky clip of the segment a-b.
+     * @return false if it misses the box, otherwise t0 <= t1 bound the part inside.
+     */
+    bool clip_segment(const Box& box, Point a, Point b, double& t0, double& t1) {
+        const double p[4] = { a.x - b.x, b.x - a.x, a.y - b.y, b.y - a.y };
+        const double q[4] = { a.x - box.min_x, box.max_x - a.x, a.y - box.min_y, box.max_y - a.y };
+        t0 = 0.0;
+        t1 = 1.0;
+        for (int k = 0; k < 4; k++) {
+            if (p[k] == 0.0) {
+                if (q[k] < 0.0)
+                    return false;
+                continue;
+            }
+            const double t = q[k] / p[k];
+            if (p[k] < 0.0) {
+                if (t > t1)
+                    return false;
+                t0 = std::max(t0, t);
+            } else {
+                if (t < t0)
+                    return false;
+                t1 = std::min(t1, t);
+            }
+        }
+        return true;
+    }
+
+    /* Point at t along a-b; points cut at the boundary are snapped onto it. */
+    Point point_at(const Box& box, Point a, Point b, double t) {
+        if (t == 0.0)
+            return a;
+        if (t == 1.0)
+            return b;
+        return box.snap({ a.x + t * (b.x - a.x), a.y + t * (b.y - a.y) });
+    }
+
+    /* Part of a ring inside the box, from where it enters to where it leaves. */
+    struct Fragment {
+        Ring points;
+        double entry, exit;
+    };
+
+    void finish_fragment(const Box& box, Fragment& fragment, std::vector<Fragment>& fragments) {
+        // A fragment only running along the boundary adds nothing the walk along the boundary does not.
+        bool along_boundary = true;
+        for (size_t i = 1; i < fragment.points.size() && along_boundary; i++)
+            along_boundary = box.on_same_edge(fragment.points[i - 1], fragment.points[i]);
+        if (fragment.points.size() >= 2 && !along_boundary) {
+            fragment.entry = box.boundary_position(fragment.points.front());
+            fragment.exit = box.boundary_position(fragment.points.back());
+            fragments.push_back(std::move(fragment));
+        }
+        fragment = Fragment();
+    }
+
+    /* Cuts a ring into fragments; a ring that never leaves the box is added to inside whole. */
+    void cut_ring(const Box& box, const Ring& ring, std::vector<Fragment>& fragments, Polygon& inside) {
+        const size_t n = ring.size();
+        const auto start = std::find_if(ring.begin(), ring.end(), [&](Point p) { return box.outside(p); });
+        if (start == ring.end()) {
+            inside.push_back(ring);
+            return;
+        }
+
+        // Starting outside, every fragment is finished by the time the walk is back at the start.
+        const size_t first = start - ring.begin();
+        Fragment fragment;
+        for (size_t k = 0; k < n; k++) {
+            const Point a = ring[(first + k) % n], b = ring[(first + k + 1) % n];
+            double t0, t1;
+            if (!clip_segment(box, a, b, t0, t1))
+                continue;
+            if (fragment.points.empty())
+                fragment.points.push_back(point_at(box, a, b, t0));
+            push_unique(fragment.points, point_at(box, a, b, t1));
+            if (t1 < 1.0)
+                finish_fragment(box, fragment, fragments);
+        }
+    }
+
+    /* Joins fragments into rings: from where a fragment leaves, the boundary is followed counter-clockwise to the next entry. */
+    void join_fragments(const Box& box, const std::vector<Fragment>& fragments, Polygon& outers) {
+        std::multimap<double, size_t> entries;
+        for (size_t i = 0; i < fragments.size(); i++)
+            entries.emplace(fragments[i].entry, i);
+
+        while (!entries.empty()) {
+            const size_t first = entries.begin()->second;
+            entries.erase(entries.begin());
+            Ring ring;
+            size_t current = first;
+            for (;;) {
+                const Fragment& fragment = fragments[current];
+                for (const Point& p : fragment.points)
+                    push_unique(ring, p);
+
+                auto next = entries.lower_bound(fragment.exit);
+                if (next == entries.end())
+                    next = entries.begin();
+                if (next == entries.end() ||
+                    ccw_distance(fragment.exit, fragments[first].entry) <= ccw_distance(fragment.exit, next->first)) {
+                    walk_boundary(box, fragment.exit, fragments[first].entry, ring);
+                    break;
+                }
+                walk_boundary(box, fragment.exit, next->first, ring);
+                current = next->second;
+                entries.erase(next);
+            }
+
+            if (ring.size() > 1 && ring.front() == ring.back())
+                ring.pop_back();
+            if (ring.size() >= 3 && signed_area(ring) > 0.0)
+                outers.push_back(std::move(ring));
+        }
+    }
+
+    /* Makes a polygon of every outer ring, with the holes it contains. */
+    void assemble(Polygon& outers, Polygon& holes, std::vector<Polygon>& results) {
+        const size_t base = results.size();
+        std::vector<double> areas;
+        for (Ring& outer : outers) {
+            areas.push_back(signed_area(outer));
+            results.push_back(Polygon{ std::move(outer) });
+        }
+        for (Ring& hole : holes) {
+            // Islands in lakes make outer rings nest, so the hole goes to the smallest one around it.
+            size_t best = outers.size();
+            for (size_t o = 0; o < outers.size(); o++)
+                if ((best == outers.size() || areas[o] < areas[best]) && contains(results[base + o][0], hole[0]))
+                    best = o;
+            if (best < outers.size())
+                results[base + best].push_back(std::move(hole));
+        }
+    }
+
+    void clip_polygon(const Box& box, Polygon polygon, std::vector<Polygon>& results) {
+        // Work with a counter-clockwise outer ring, so the polygon is on the left of all its rings.
+        const bool clockwise = signed_area(polygon[0]) < 0.0;
+        if (clockwise)
+            for (Ring& ring : polygon)
+                std::reverse(ring.begin(), ring.end());
+
+        std::vector<Fragment> fragments;
+        Polygon inside;
+        for (const Ring& ring : polygon)
+            cut_ring(box, ring, fragments, inside);
+
+        Polygon outers, holes;
+        join_fragments(box, fragments, outers);
+        if (fragments.empty()) {
+            // Nothing crosses the boundary, so the boundary is either all inside the polygon or all outside it.
+            const Point probe = { 0.5 * (box.min_x + box.max_x), box.min_y + 1e-9 * (box.max_y - box.min_y) };
+            bool covered = false;
+            for (const Ring& ring : polygon)
+                covered ^= contains(ring, probe);
+            if (covered)
+                outers.push_back({ box.corner(0), box.corner(1), box.corner(2), box.corner(3) });
+        }
+        for (Ring& ring : inside)
+            (signed_area(ring) > 0.0 ? outers : holes).push_back(std::move(ring));
+
+        const size_t base = results.size();
+        assemble(outers, holes, results);
+        if (clockwise)
+            for (size_t p = base; p < results.size(); p++)
+                for (Ring& ring : results[p])
+                    std::reverse(ring.begin(), ring.end());
+    }
+
+    /* Simplification */
+
+    double segment_distance_squared(Point p, Point a, Point b) {
+        const double dx = b.x - a.x, dy = b.y - a.y;
+        const double length_squared = dx * dx + dy * dy;
+        double t = length_squared > 0.0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / length_squared : 0.0;
+        t = std::clamp(t, 0.0, 1.0);
+        const double ex = a.x + t * dx - p.x, ey = a.y + t * dy - p.y;
+        return ex * ex + ey * ey;
+    }
+
+    bool on_segment(Point p, Point a, Point b) {
+        return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) && std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y);
+    }
+
+    bool segments_intersect(Point a, Point b, Point c, Point d) {
+        const double d1 = cross(c, d, a), d2 = cross(c, d, b), d3 = cross(a, b, c), d4 = cross(a, b, d);
+        if (((d1 > 0.0 && d2 < 0.0) || (d1 < 0.0 && d2 > 0.0)) && ((d3 > 0.0 && d4 < 0.0) || (d3 < 0.0 && d4 > 0.0)))
+            return true;
+        return (d1 == 0.0 && on_segment(a, c, d)) || (d2 == 0.0 && on_segment(b, c, d)) ||
+               (d3 == 0.0 && on_segment(c, a, b)) || (d4 == 0.0 && on_segment(d, a, b));
+    }
+
+    /**
+     * Douglas-Peucker over the rings of one polygon.
+     * Points are scaled so that distances are in degrees of latitude everywhere; index size() of a ring is its first point again.
+     */
+    class PolygonSimplifier {
+    public:
+        PolygonSimplifier(Polygon& polygon, double tolerance) : polygon(polygon), tolerance_squared(tolerance * tolerance) {
+            double min_y = polygon[0][0].y, max_y = min_y;
+            for (const Point& p : polygon[0]) {
+                min_y = std::min(min_y, p.y);
+                max_y = std::max(max_y, p.y);
+            }
+            const double x_scale = std::cos(0.5 * (min_y + max_y) * Math_PI / 180.0);
+            for (const Ring& ring : polygon) {
+                Ring ring_scaled(ring);
+                for (Point& p : ring_scaled)
+                    p.x *= x_scale;
+                scaled.push_back(std::move(ring_scaled));
+            }
+        }
+
+        void simplify(std::vector<Polygon>& results) {
+            keep.resize(polygon.size());
+            for (size_t r = 0; r < polygon.size(); r++)
+                simplify_ring(r);
+            // A collapsed outer ring takes its holes with it.
+            if (kept_count(0) < 3)
+                return;
+            for (size_t r = 1; r < polygon.size(); r++)
+                if (kept_count(r) < 3)
+                    keep[r].clear();
+            while (refine_crossings()) {
+            }
+
+            Polygon simplified;
+            for (size_t r = 0; r < polygon.size(); r++) {
+                if (keep[r].empty())
+                    continue;
+                Ring ring;
+                for (size_t i = 0; i < polygon[r].size(); i++)
+                    if (keep[r][i])
+                        ring.push_back(polygon[r][i]);
+                simplified.push_back(std::move(ring));
+            }
+            results.push_back(std::move(simplified));
+        }
+
+    private:
+        struct Segment {
+            size_t ring, from, to;
+            double min_x, min_y, max_x, max_y;
+        };
+
+        Point at(size_t r, size_t i) const {
+            return scaled[r][i % scaled[r].size()];
+        }
+
+        size_t kept_count(size_t r) const {
+            return keep[r].empty() ? 0 : std::count(keep[r].begin(), keep[r].end() - 1, 1);
+        }
+
+        /* Point between from and to farthest from the segment joining them. */
+        size_t farthest(size_t r, size_t from, size_t to, double& distance_squared) const {
+            size_t best = from;
+            distance_squared = -1.0;
+            for (size_t i = from + 1; i < to; i++) {
+                const double d = segment_distance_squared(at(r, i), at(r, from), at(r, to));
+                if (d > distance_squared) {
+                    distance_squared = d;
+                    best = i;
+                }
+            }
+            return best;
+        }
+
+        void simplify_ring(size_t r) {
+            const size_t n = scaled[r].size();
+            keep[r].assign(n + 1, 0);
+            keep[r][0] = keep[r][n] = 1;
+
+            // The point farthest from the first one splits the ring into two open lines.
+            size_t split = 0;
+            double split_distance = -1.0;
+            for (size_t i = 1; i < n; i++) {
+                const double dx = at(r, i).x - at(r, 0).x, dy = at(r, i).y - at(r, 0).y;
+                if (dx * dx + dy * dy > split_distance) {
+                    split_distance = dx * dx + dy * dy;
+                    split = i;
+                }
+            }
+            if (split == 0)
+                return;
+            keep[r][split] = 1;
+
+            std::vector<std::pair<size_t, size_t>> stack = { { 0, split }, { split, n } };
+            while (!stack.empty()) {
+                const auto [from, to] = stack.back();
+                stack.pop_back();
+                double distance_squared;
+                const size_t i = farthest(r, from, to, distance_squared);
+                if (i != from && distance_squared > tolerance_squared) {
+                    keep[r][i] = 1;
+                    stack.push_back({ from, i });
+                    stack.push_back({ i, to });
+                }
+            }
+        }
+
+        /* Puts back the farthest dropped point of every simplified segment that crosses another. @return Whether a point was put back. */
+        bool refine_crossings() {
+            std::vector<Segment> segments;
+            for (size_t r = 0; r < polygon.size(); r++) {
+                if (keep[r].empty())
+                    continue;
+                size_t from = 0;
+                for (size_t i = 1; i < keep[r].size(); i++) {
+                    if (!keep[r][i])
+                        continue;
+                    const Point a = at(r, from), b = at(r, i);
+                    segments.push_back({ r, from, i, std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.x, b.x), std::max(a.y, b.y) });
+                    from = i;
+                }
+            }
+
+            // Sweep along x over the segment boxes.
+            std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) { return a.min_x < b.min_x; });
+            std::vector<uint8_t> crossing(segments.size(), 0);
+            for (size_t i = 0; i < segments.size(); i++) {
+                const Segment& s = segments[i];
+                for (size_t j = i + 1; j < segments.size() && segments[j].min_x <= s.max_x; j++) {
+                    const Segment& t = segments[j];
+                    if (t.min_y > s.max_y || t.max_y < s.min_y || adjacent(s, t))
+                        continue;
+                    if (segments_intersect(at(s.ring, s.from), at(s.ring, s.to), at(t.ring, t.from), at(t.ring, t.to)))
+                        crossing[i] = crossing[j] = 1;
+                }
+            }
+
+            bool refined = false;
+            for (size_t i = 0; i < segments.size(); i++) {
+                if (!crossing[i] || segments[i].to - segments[i].from < 2)
+                    continue;
+                double distance_squared;
+                keep[segments[i].ring][farthest(segments[i].ring, segments[i].from, segments[i].to, distance_squared)] = 1;
+                refined = true;
+            }
+            return refined;
+        }
+
+        bool adjacent(const Segment& s, const Segment& t) const {
+            if (s.ring != t.ring)
+                return false;
+            const size_t n = scaled[s.ring].size();
+            return s.to % n == t.from % n || t.to % n == s.from % n;
+        }
+
+        Polygon& polygon;
+        Polygon scaled;
+        std::vector<std::vector<uint8_t>> keep;
+        double tolerance_squared;
+    };
+}
+
+void clipPolygons(const ShapefilePolygons& in, double min_lon, double min_lat, double max_lon, double max_lat, ShapefilePolygons& out) {
+    const Box box = { min_lon, min_lat, max_lon, max_lat };
+    process_polygons(in, out, [&](Polygon polygon, std::vector<Polygon>& results) {
+        clip_polygon(box, std::move(polygon), results);
+    });
+}
+
+void simplifyPolygons(const ShapefilePolygons& in, double tolerance, ShapefilePolygons& out) {
+    const double tolerance_degrees = tolerance / LATITUDE_DEGREE_IN_METRES;
+    process_polygons(in, out, [&](Polygon polygon, std::vector<Polygon>& results) {
+        PolygonSimplifier(polygon, tolerance_degrees).simplify(results);
+    });
+}
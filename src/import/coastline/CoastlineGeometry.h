@@ -0,0 +1,28 @@
+#ifndef COASTLINE_GEOMETRY_H
+#define COASTLINE_GEOMETRY_H
+#include "Shapefile.h"
+
+/**
+ * Clipping and simplification of decoded coastline polygons, done before they are handed to scripts.
+ *
+ * Both take polygons as produced by Shapefile (rings closed, outer rings and holes of opposite
+ * orientation, degrees) and append polygons of the same form to out. Polygons are processed in parallel.
+ */
+
+/**
+ * Clips polygons to a rectangle.
+ * Rings crossing the rectangle are cut at its edges and joined along its boundary (Weiler-Atherton),
+ * so a polygon may split into several; every output polygon is an outer ring followed by its holes.
+ */
+void clipPolygons(const ShapefilePolygons& in, double min_lon, double min_lat, double max_lon, double max_lat, ShapefilePolygons& out);
+
+/**
+ * Simplifies polygons with Douglas-Peucker, refining again wherever the simplified rings of a polygon
+ * would cross each other, so rings stay simple and holes stay inside their outer ring.
+ * Rings that collapse below the tolerance are dropped, along with the holes of a collapsed outer ring.
+ *
+ * @param tolerance Maximum distance of a removed point from the simplified ring, in metres.
+ */
+void simplifyPolygons(const ShapefilePolygons& in, double tolerance, ShapefilePolygons& out);
+
+#endif // COASTLINE_GEOMETRY_H
@@ -1,65 +1,17 @@
 #include "CoastlineParser.h"
+#include "ShapefileIndex.h"
+#include "CoastlineGeometry.h"
+#include "CoastlineTiles.h"
+#include "CoastMask.h"
+#include "../../util/Parallel.h"
+#include <algorithm>
 #include <fstream>
 #include <godot_cpp/classes/node.hpp>
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/classes/project_settings.hpp>
 
-#pragma pack(push, 1) // Ensures that the structs are packed with no padding
-const double R = 6378137.0; // Earth radius in meters for Mercator
-
 using namespace godot;
 
-struct ShapefileHeader {
-    int32_t fileCode;       
-    int32_t unused[5];      
-    int32_t fileLength;     
-    int32_t version;        
-    int32_t shapeType;      
-    double xMin, yMin, xMax, yMax;
-    double zMin, zMax, mMin, mMax;
-};
-
-struct RecordHeader {
-    int32_t recordNumber;   
-    int32_t contentLength;  
-};
-
-#pragma pack(pop)
-
-void swapEndian(int32_t& value) {
-    value = ((value >> 24) & 0xFF) | 
-            ((value << 8) & 0xFF0000) | 
-            ((value >> 8) & 0xFF00) | 
-            ((value << 24) & 0xFF000000);
-}
-
-bool intersects(double xMin1, double yMin1, double xMax1, double yMax1,
-                double xMin2, double yMin2, double xMax2, double yMax2) {
-    return !(xMax1 < xMin2 || xMin1 > xMax2 || yMax1 < yMin2 || yMin1 > yMax2);
-}
-
-std::pair<double, double> readShapefilePoint(std::ifstream& shpFile, const ShapefileFormat format) {
-    double x, y;
-
-    shpFile.read(reinterpret_cast<char*>(&x), sizeof(double));
-    shpFile.read(reinterpret_cast<char*>(&y), sizeof(double));
-
-    double longitude, latitude;
-    switch (format) {
-        case ShapefileFormat::WGS84:
-            longitude = x;
-            latitude = y;
-            break;
-        case ShapefileFormat::MERCATOR:
-            // Convert Mercator coordinates (X, Y) to WGS84 (Longitude, Latitude)
-            longitude = (x / R) * (180.0 / Math_PI); // Convert to degrees
-            latitude = (std::atan(std::sinh(y / R))) * (180.0 / Math_PI); // Convert to degrees
-            break;
-    }
-
-    return {longitude, latitude};
-}
-
 ShapefileFormat getShapefileFormat(const godot::String& prjFilename) {
     std::ifstream prjFile(ProjectSettings::get_singleton()->globalize_path(prjFilename).ascii());
     if (!prjFile) {
@@ -79,108 +31,56 @@ ShapefileFormat getShapefileFormat(const godot::String& prjFilename) {
     return ShapefileFormat::UNKNOWN;
 }
 
-TypedArray<Array> readShapefile(const std::string& shpFileName, const std::string& shxFileName, ShapefileFormat format,
-                   double queryXMin, double queryYMin, double queryXMax, double queryYMax) {
-
-    std::ifstream shpFile(shpFileName, std::ios::binary);
-    std::ifstream shxFile(shxFileName, std::ios::binary);
-    TypedArray<Array> polygons;
-    if (!shpFile || !shxFile) {
+bool readShapefile(const String& shpFileName, const String& shxFileName, ShapefileFormat format,
+                   double queryXMin, double queryYMin, double queryXMax, double queryYMax, ShapefilePolygons& polygons) {
+    Shapefile shapefile;
+    if (!shapefile.open(shpFileName, shxFileName)) {
         WARN_PRINT("Unable to open coastline shapefiles.");
-        return polygons;
+        return false;
     }
 
-    ShapefileHeader header;
-    shpFile.read(reinterpret_cast<char*>(&header), sizeof(header));
-    swapEndian(header.fileCode);
-    swapEndian(header.fileLength);
-
-    // Read through the .shx file to find relevant records
-    shxFile.seekg(100u); // Skip the header
-    while (shxFile) {
-        int32_t offset, contentLength;
-        shxFile.read(reinterpret_cast<char*>(&offset), sizeof(offset));
-        shxFile.read(reinterpret_cast<char*>(&contentLength), sizeof(contentLength));
-
-        if (shxFile.gcount() == 0) break; // End of file
-
-        swapEndian(offset);
-        swapEndian(contentLength);
-
-        shpFile.seekg(static_cast<unsigned int>(offset * 2)); // Offsets in .shx are in 16-bit words
-
-        RecordHeader recordHeader;
-        shpFile.read(reinterpret_cast<char*>(&recordHeader), sizeof(recordHeader));
-        swapEndian(recordHeader.recordNumber);
-        swapEndian(recordHeader.contentLength);
-
-        int32_t shapeType;
-        shpFile.read(reinterpret_cast<char*>(&shapeType), sizeof(shapeType));
-
-        if (shapeType == 1) { // Point
-            auto [x, y] = readShapefilePoint(shpFile, format);
+    ShapefileIndex index;
+    loadShapefileIndex(shpFileName, shapefile, index);
+    shapefile.read_polygons(format, queryXMin, queryYMin, queryXMax, queryYMax, polygons, &index);
+    return true;
+}
 
-            if (x >= queryXMin && x <= queryXMax && y >= queryYMin && y <= queryYMax) {
-                //std::cout << "Point Record #" << recordHeader.recordNumber 
-                //          << ": (" << x << ", " << y << ")" << std::endl;
+namespace {
+    /* Flat points in radians, converted in parallel chunks. */
+    void to_radians(const ShapefilePolygons& polygons, std::vector<double>& lon, std::vector<double>& lat) {
+        lon.resize(polygons.lon.size());
+        lat.resize(polygons.lat.size());
+        parallel_for_ranges(lon.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                lon[i] = Longitude::degrees(polygons.lon[i]).get_radians();
+                lat[i] = Latitude::degrees(polygons.lat[i]).get_radians();
             }
-        } else if (shapeType == 5) { // Polygon (for example)
-            auto [shapeXMin, shapeYMin] = readShapefilePoint(shpFile, format);
-            auto [shapeXMax, shapeYMax] = readShapefilePoint(shpFile, format);
-
-            if (intersects(queryXMin, queryYMin, queryXMax, queryYMax, 
-                           shapeXMin, shapeYMin, shapeXMax, shapeYMax)) {
-                //std::cout << "Polygon Record #" << recordHeader.recordNumber 
-                //          << " intersects with query box." << std::endl;
-                // Read the full polygon data if needed
-		
-                // Number of parts and points
-                int32_t numParts, numPoints;
-                shpFile.read(reinterpret_cast<char*>(&numParts), sizeof(numParts));
-                shpFile.read(reinterpret_cast<char*>(&numPoints), sizeof(numPoints));
-
-                // Read parts array
-                std::vector<int32_t> parts(numParts);
-                shpFile.read(reinterpret_cast<char*>(parts.data()), numParts * sizeof(int32_t));
-
-                // Read points array
-                std::vector<std::pair<double, double>> points(numPoints);
-                for (int i = 0; i < numPoints; ++i) {
-                    auto [x, y] = readShapefilePoint(shpFile, format);
-                    points[i] = {x, y};
-                }
-
-                // Output the polygon data
-
-                //std::cout << "Polygon Record #" << recordHeader.recordNumber << " has " 
-                //        << numParts << " parts and " << numPoints << " points." << std::endl;
-
-                TypedArray<PackedVector2Array> polygon;
-    
-                for (int i = 0; i < numParts; ++i) {
-                    int start = parts[i];
-                    int end = (i == numParts - 1) ? numPoints : parts[i + 1];
-                    //std::cout << "  Part " << i + 1 << ":\n";
-
-                    PackedVector2Array part;
-                    for (int j = start; j < end; ++j) {
-                        part.append(GeoCoords(Longitude::degrees(points[j].first), Latitude::degrees(points[j].second)).to_vector2_representation());
-                    }
-
-                    polygon.append(part);
-                }
+        }, 4096);
+    }
 
-                polygons.append(polygon);
+    /* Rings of the flat world points nested like polygons_geo: an Array of Arrays of PackedVector3Array. */
+    Array nest_world(const ShapefilePolygons& polygons, const PackedVector3Array& points_world) {
+        Array polygons_world;
+        const Vector3* src = points_world.ptr();
+        for (size_t p = 0; p < polygons.polygon_count(); p++) {
+            Array polygon_world;
+            for (uint32_t r = polygons.polygon_offsets[p]; r < polygons.polygon_offsets[p + 1]; r++) {
+                PackedVector3Array ring;
+                ring.resize(polygons.ring_offsets[r + 1] - polygons.ring_offsets[r]);
+                std::copy(src + polygons.ring_offsets[r], src + polygons.ring_offsets[r + 1], ring.ptrw());
+                polygon_world.append(ring);
             }
-        } else {
-	    //std::cout << "Shape type " << shapeType << " intersects with query box." << std::endl;
-	}
+            polygons_world.append(polygon_world);
+        }
+        return polygons_world;
     }
 
-    shpFile.close();
-    shxFile.close();
-
-    return polygons;
+    PackedInt32Array to_packed(const std::vector<uint32_t>& values) {
+        PackedInt32Array packed;
+        packed.resize(values.size());
+        std::copy(values.begin(), values.end(), packed.ptrw());
+        return packed;
+    }
 }
 
 void CoastlineParser::import(godot::Ref<GeoMap> geomap)
@@ -194,58 +94,182 @@ void CoastlineParser::import(godot::Ref<GeoMap> geomap)
         minCorner += origin;
         maxCorner += origin;
     }
-    const auto polygons_geo = readShapefile(ProjectSettings::get_singleton()->globalize_path(shpFilename).utf8().get_data(), ProjectSettings::get_singleton()->globalize_path(shxFilename).utf8().get_data(), getShapefileFormat(prjFilename), minCorner.x, minCorner.y, maxCorner.x, maxCorner.y);
-    const auto shader_nodes = this->get_shader_nodes();
-    
-    WARN_PRINT("Imported " + String::num_int64(polygons_geo.size()) + " polygons.");
-    WARN_PRINT("Shader nodes size: " + String::num_int64(shader_nodes.size()));
-
-    for (int i = 0; i < shader_nodes.size(); i++)
-        Object::cast_to<Node>(shader_nodes[i])->call("import_polygons_geo", polygons_geo, geomap);
-
-    // Check if we need to map points to world space
-    bool is_need_for_world = false;
-    {
-        for (int i = 0; i < shader_nodes.size(); i++) {
-            if (Object::cast_to<Node>(shader_nodes[i])->has_method("import_polygons_world")) {
-                is_need_for_world = true;
-                break;
+    ShapefilePolygons polygons;
+    if (tilemap.is_valid()) {
+        // The layer is streamed with load_tile / load_tiles instead; the shapefile is only read when the layer is outdated.
+        const CoastlineTileSettings settings = { tilemap->get_zoom(), lod_count, minCorner.x, minCorner.y, maxCorner.x, maxCorner.y, resolution };
+        if (isCoastlineTilesCurrent(shpFilename, settings)) {
+            CoastlineTileReader reader;
+            if (mask_resolution > 0.0 && reader.open(shpFilename)) {
+                // The finest tiles together hold every polygon of the query box. They are read unsimplified, like the
+                // polygons the mask is built from below, so the mask does not depend on whether the layer was current.
+                const PackedInt64Array& keys = reader.get_keys();
+                for (int64_t i = 0; i < keys.size(); i++)
+                    if (QuadkeyTileMap::key_zoom(keys[i]) == settings.zoom)
+                        reader.read(keys[i], polygons, true);
+                build_mask(polygons, minCorner, maxCorner, geomap);
             }
+            return;
         }
+        readShapefile(shpFilename, shxFilename, getShapefileFormat(prjFilename), minCorner.x, minCorner.y, maxCorner.x, maxCorner.y, polygons);
+        writeCoastlineTiles(shpFilename, polygons, settings);
+        build_mask(polygons, minCorner, maxCorner, geomap);
+        return;
     }
 
-    if (is_need_for_world) {
-        if (!geomap.is_valid()) {
-            ERR_PRINT("GeoMap is null but Coastline shader uses world space.");
-            return;
-        }
+    readShapefile(shpFilename, shxFilename, getShapefileFormat(prjFilename), minCorner.x, minCorner.y, maxCorner.x, maxCorner.y, polygons);
+    if (clip_to_bounds) {
+        ShapefilePolygons clipped;
+        clipPolygons(polygons, minCorner.x, minCorner.y, maxCorner.x, maxCorner.y, clipped);
+        polygons = std::move(clipped);
+    }
+    // Before simplification, so the mask follows the coast as closely as its resolution allows.
+    build_mask(polygons, minCorner, maxCorner, geomap);
+    if (resolution > 0.0) {
+        ShapefilePolygons simplified;
+        simplifyPolygons(polygons, resolution, simplified);
+        polygons = std::move(simplified);
+    }
+    WARN_PRINT("Imported " + String::num_int64(polygons.polygon_count()) + " polygons.");
+    deliver(polygons, geomap);
+}
 
-        Array polygons_world;
-        for (int i = 0; i < polygons_geo.size(); i++) {
-            Array polygon = polygons_geo[i];
-            Array polygon_world;
+bool CoastlineParser::load_tile(int64_t key, godot::Ref<GeoMap> geomap) {
+    ShapefilePolygons polygons;
+    if (!readCoastlineTile(shpFilename, key, polygons))
+        return false;
+    deliver(polygons, geomap);
+    return true;
+}
 
-            for (int j = 0; j < polygon.size(); j++) {
-                PackedVector2Array part = polygon[j];
-                PackedVector3Array part_world;
-                for (int k = 0; k < part.size(); k++) {
-                    const Vector2 point = part[k];
-                    part_world.append(geomap->geo_to_world(GeoCoords::from_vector2_representation(point)));
-                }
+int64_t CoastlineParser::load_tiles(godot::Ref<GeoMap> geomap) {
+    if (tilemap.is_null())
+        return 0;
+    CoastlineTileReader reader;
+    if (!reader.open(shpFilename)) {
+        WARN_PRINT("No coastline tiles for " + shpFilename + "; import first.");
+        return 0;
+    }
 
-                polygon_world.append(part_world);
-            }
-            polygons_world.append(polygon_world);
-        }
+    // Only the finest level; the coarser ones cover the same ground. Shader nodes replace what they have on every
+    // import_polygons_* call, so all tiles go out together.
+    int64_t loaded = 0;
+    ShapefilePolygons polygons;
+    const PackedInt64Array& keys = reader.get_keys();
+    for (int64_t i = 0; i < keys.size(); i++)
+        if (QuadkeyTileMap::key_zoom(keys[i]) == tilemap->get_zoom() && reader.read(keys[i], polygons))
+            loaded++;
+    if (loaded > 0)
+        deliver(polygons, geomap);
+    return loaded;
+}
+
+void CoastlineParser::build_mask(const ShapefilePolygons& polygons, const Vector2& min_corner, const Vector2& max_corner, godot::Ref<GeoMap> geomap) {
+    coast_mask.unref();
+    if (mask_resolution <= 0.0)
+        return;
+    Ref<CoastMask> mask;
+    mask.instantiate();
+    if (!mask->build(polygons, min_corner.x, min_corner.y, max_corner.x, max_corner.y, mask_resolution, polygons_are_land, mask_distance))
+        return;
+    coast_mask = mask;
+
+    const auto shader_nodes = this->get_shader_nodes();
+    for (int i = 0; i < shader_nodes.size(); i++)
+        if (Object::cast_to<Node>(shader_nodes[i])->has_method("import_coast_mask"))
+            Object::cast_to<Node>(shader_nodes[i])->call("import_coast_mask", coast_mask, geomap);
+}
+
+PackedInt64Array CoastlineParser::get_tile_keys() const {
+    return readCoastlineTileKeys(shpFilename);
+}
+
+void CoastlineParser::deliver(const ShapefilePolygons& polygons, godot::Ref<GeoMap> geomap) {
+    const auto shader_nodes = this->get_shader_nodes();
+
+    // Check which representations the shader nodes need; each is built once for all of them.
+    bool is_need_for_geo = false, is_need_for_world = false, is_need_for_flat = false;
+    for (int i = 0; i < shader_nodes.size(); i++) {
+        const Node* node = Object::cast_to<Node>(shader_nodes[i]);
+        is_need_for_geo = is_need_for_geo || node->has_method("import_polygons_geo");
+        is_need_for_world = is_need_for_world || node->has_method("import_polygons_world");
+        is_need_for_flat = is_need_for_flat || node->has_method("import_polygons_flat");
+    }
+
+    if (is_need_for_geo) {
+        const auto polygons_geo = polygons.to_godot();
+        for (int i = 0; i < shader_nodes.size(); i++)
+            if (Object::cast_to<Node>(shader_nodes[i])->has_method("import_polygons_geo"))
+                Object::cast_to<Node>(shader_nodes[i])->call("import_polygons_geo", polygons_geo, geomap);
+    }
+
+    if (is_need_for_world && !geomap.is_valid()) {
+        ERR_PRINT("GeoMap is null but Coastline shader uses world space.");
+        is_need_for_world = false;
+    }
+    if (!is_need_for_world && !is_need_for_flat)
+        return;
+
+    std::vector<double> lon, lat;
+    to_radians(polygons, lon, lat);
+
+    // All points are projected at once, in parallel chunks, straight into the packed array.
+    PackedVector3Array points_world;
+    if (geomap.is_valid()) {
+        points_world.resize(lon.size());
+        Vector3* dst = points_world.ptrw();
+        GeoMap* map = geomap.ptr();
+        parallel_for_ranges(lon.size(), [&](size_t begin, size_t end, size_t) {
+            map->geo_to_world_batch(lon.data() + begin, lat.data() + begin, end - begin, dst + begin, nullptr);
+        }, 4096);
+    }
+
+    if (is_need_for_world) {
+        const Array polygons_world = nest_world(polygons, points_world);
+        for (int i = 0; i < shader_nodes.size(); i++)
+            if (Object::cast_to<Node>(shader_nodes[i])->has_method("import_polygons_world"))
+                Object::cast_to<Node>(shader_nodes[i])->call("import_polygons_world", polygons_world);
+    }
 
+    if (is_need_for_flat) {
+        PackedVector2Array points_geo;
+        points_geo.resize(lon.size());
+        Vector2* dst = points_geo.ptrw();
+        for (size_t i = 0; i < lon.size(); i++)
+            dst[i] = Vector2(static_cast<real_t>(lon[i]), static_cast<real_t>(lat[i]));
+
+        Dictionary flat;
+        flat["points_geo"] = points_geo;
+        flat["points_world"] = points_world;
+        flat["ring_offsets"] = to_packed(polygons.ring_offsets);
+        flat["polygon_offsets"] = to_packed(polygons.polygon_offsets);
         for (int i = 0; i < shader_nodes.size(); i++)
-            Object::cast_to<Node>(shader_nodes[i])->call("import_polygons_world", polygons_world);
+            if (Object::cast_to<Node>(shader_nodes[i])->has_method("import_polygons_flat"))
+                Object::cast_to<Node>(shader_nodes[i])->call("import_polygons_flat", flat, geomap);
     }
 }
 
 void CoastlineParser::_bind_methods() {
     ClassDB::bind_method(D_METHOD("set_size_in_degrees", "value"), &CoastlineParser::set_size_in_degrees);
     ClassDB::bind_method(D_METHOD("get_size_in_degrees"), &CoastlineParser::get_size_in_degrees);
+    ClassDB::bind_method(D_METHOD("set_clip_to_bounds", "value"), &CoastlineParser::set_clip_to_bounds);
+    ClassDB::bind_method(D_METHOD("get_clip_to_bounds"), &CoastlineParser::get_clip_to_bounds);
+    ClassDB::bind_method(D_METHOD("set_resolution", "value"), &CoastlineParser::set_resolution);
+    ClassDB::bind_method(D_METHOD("get_resolution"), &CoastlineParser::get_resolution);
+    ClassDB::bind_method(D_METHOD("set_tilemap", "value"), &CoastlineParser::set_tilemap);
+    ClassDB::bind_method(D_METHOD("get_tilemap"), &CoastlineParser::get_tilemap);
+    ClassDB::bind_method(D_METHOD("set_lod_count", "value"), &CoastlineParser::set_lod_count);
+    ClassDB::bind_method(D_METHOD("get_lod_count"), &CoastlineParser::get_lod_count);
+    ClassDB::bind_method(D_METHOD("load_tile", "key", "geomap"), &CoastlineParser::load_tile, DEFVAL(nullptr));
+    ClassDB::bind_method(D_METHOD("load_tiles", "geomap"), &CoastlineParser::load_tiles, DEFVAL(nullptr));
+    ClassDB::bind_method(D_METHOD("get_tile_keys"), &CoastlineParser::get_tile_keys);
+    ClassDB::bind_method(D_METHOD("set_mask_resolution", "value"), &CoastlineParser::set_mask_resolution);
+    ClassDB::bind_method(D_METHOD("get_mask_resolution"), &CoastlineParser::get_mask_resolution);
+    ClassDB::bind_method(D_METHOD("set_mask_distance", "value"), &CoastlineParser::set_mask_distance);
+    ClassDB::bind_method(D_METHOD("get_mask_distance"), &CoastlineParser::get_mask_distance);
+    ClassDB::bind_method(D_METHOD("set_polygons_are_land", "value"), &CoastlineParser::set_polygons_are_land);
+    ClassDB::bind_method(D_METHOD("get_polygons_are_land"), &CoastlineParser::get_polygons_are_land);
+    ClassDB::bind_method(D_METHOD("get_coast_mask"), &CoastlineParser::get_coast_mask);
     ClassDB::bind_method(D_METHOD("set_shp_filename", "value"), &CoastlineParser::set_shp_filename);
     ClassDB::bind_method(D_METHOD("get_shp_filename"), &CoastlineParser::get_shp_filename);
     ClassDB::bind_method(D_METHOD("set_shx_filename", "value"), &CoastlineParser::set_shx_filename);
@@ -254,6 +278,13 @@ void CoastlineParser::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_prj_filename"), &CoastlineParser::get_prj_filename);
 
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "size_in_degrees"), "set_size_in_degrees", "get_size_in_degrees");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "clip_to_bounds"), "set_clip_to_bounds", "get_clip_to_bounds");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "resolution", PROPERTY_HINT_RANGE, "0,10000,0.1,or_greater,suffix:m"), "set_resolution", "get_resolution");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "tilemap", PROPERTY_HINT_RESOURCE_TYPE, "QuadkeyTileMap"), "set_tilemap", "get_tilemap");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "lod_count", PROPERTY_HINT_RANGE, "1,8"), "set_lod_count", "get_lod_count");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "mask_resolution", PROPERTY_HINT_RANGE, "0,10000,0.1,or_greater,suffix:m"), "set_mask_resolution", "get_mask_resolution");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "mask_distance"), "set_mask_distance", "get_mask_distance");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "polygons_are_land"), "set_polygons_are_land", "get_polygons_are_land");
     ADD_PROPERTY(PropertyInfo(Variant::STRING, "shp_filename", PROPERTY_HINT_FILE, "*.shp"), "set_shp_filename", "get_shp_filename");
     ADD_PROPERTY(PropertyInfo(Variant::STRING, "shx_filename", PROPERTY_HINT_FILE, "*.shx"), "set_shx_filename", "get_shx_filename");
     ADD_PROPERTY(PropertyInfo(Variant::STRING, "prj_filename", PROPERTY_HINT_FILE, "*.prj"), "set_prj_filename", "get_prj_filename");
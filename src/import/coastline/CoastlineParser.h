@@ -2,12 +2,9 @@
 #define COASTLINE_PARSER_H
 #include "../GeoMap.h"
 #include "../Parser.h"
-
-enum class ShapefileFormat {
-    UNKNOWN,
-    WGS84,
-    MERCATOR
-};
+#include "../TileMap.h"
+#include "CoastMask.h"
+#include "Shapefile.h"
 
 class CoastlineParser : public Parser {
     GDCLASS(CoastlineParser, Parser);
@@ -22,6 +19,35 @@ public:
      */
     void import(godot::Ref<GeoMap> geomap = nullptr);
 
+    /**
+     * Passes the polygons of one tile of the coastline layer to the shader nodes, like import does.
+     * @param key QuadkeyTileMap key; LOD l has the tiles of the tilemap zoom minus l.
+     * @return false if the layer has no polygons in this tile.
+     */
+    bool load_tile(int64_t key, godot::Ref<GeoMap> geomap = nullptr);
+    /**
+     * Passes the tiles of the finest level to the shader nodes in one call, reading the layer index once.
+     * SGImport::load_tiles calls this with the tiles of the OSM parsers.
+     * @return Number of tiles loaded; 0 without a tilemap.
+     */
+    int64_t load_tiles(godot::Ref<GeoMap> geomap = nullptr);
+    /* Keys of the tiles with polygons in the coastline layer. */
+    godot::PackedInt64Array get_tile_keys() const;
+
+    /* With a tilemap, import writes a tiled coastline layer next to the shapefile instead of passing polygons on; load_tiles passes them on. */
+    void set_tilemap(const godot::Ref<QuadkeyTileMap>& value) {
+        tilemap = value;
+    }
+    godot::Ref<QuadkeyTileMap> get_tilemap() const {
+        return tilemap;
+    }
+    void set_lod_count(int value) {
+        lod_count = std::max(value, 1);
+    }
+    int get_lod_count() const {
+        return lod_count;
+    }
+
     void set_size_in_degrees(double value) {
         size_in_degrees = value;
     }
@@ -29,6 +55,45 @@ public:
         return size_in_degrees;
     }
 
+    void set_clip_to_bounds(bool value) {
+        clip_to_bounds = value;
+    }
+    bool get_clip_to_bounds() {
+        return clip_to_bounds;
+    }
+    void set_resolution(double value) {
+        resolution = value;
+    }
+    double get_resolution() {
+        return resolution;
+    }
+
+    /* Cell size of the land/water mask built on import in metres; 0 builds no mask. */
+    void set_mask_resolution(double value) {
+        mask_resolution = value;
+    }
+    double get_mask_resolution() const {
+        return mask_resolution;
+    }
+    /* Whether the mask also gets a signed distance field. */
+    void set_mask_distance(bool value) {
+        mask_distance = value;
+    }
+    bool get_mask_distance() const {
+        return mask_distance;
+    }
+    /* Whether the shapefile holds land polygons rather than water polygons. */
+    void set_polygons_are_land(bool value) {
+        polygons_are_land = value;
+    }
+    bool get_polygons_are_land() const {
+        return polygons_are_land;
+    }
+    /* Mask of the last import, also passed to shader nodes with an import_coast_mask(mask, geomap) method. */
+    godot::Ref<CoastMask> get_coast_mask() const {
+        return coast_mask;
+    }
+
     void set_shp_filename(const godot::String& value) {
         shpFilename = value;
     }
@@ -54,8 +119,21 @@ protected:
     static void _bind_methods();
 
 private:
+    /* Passes polygons to the shader nodes in every form they ask for. */
+    void deliver(const ShapefilePolygons& polygons, godot::Ref<GeoMap> geomap);
+    void build_mask(const ShapefilePolygons& polygons, const godot::Vector2& min_corner, const godot::Vector2& max_corner, godot::Ref<GeoMap> geomap);
 
     double size_in_degrees;
+    /* Whether polygons are cut to the imported area instead of being passed on whole. */
+    bool clip_to_bounds = true;
+    /* Simplification tolerance in metres; 0 keeps every point. */
+    double resolution = 0.0;
+    godot::Ref<QuadkeyTileMap> tilemap;
+    int lod_count = 3;
+    double mask_resolution = 0.0;
+    bool mask_distance = true;
+    bool polygons_are_land = true;
+    godot::Ref<CoastMask> coast_mask;
 
     godot::String shpFilename;
     godot::String shxFilename;
@@ -0,0 +1,249 @@
+#include "CoastlineTiles.h"
+#include "CoastlineGeometry.h"
+#include "../TileMap.h"
+#include <algorithm>
+#include <utility>
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/variant/packed_float64_array.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+
+using namespace godot;
+
+namespace {
+    const double FORMAT_VERSION = 2.0;
+    /* More tiles than this at the finest level means the zoom does not suit the query box. */
+    const int64_t MAX_TILES = 65536;
+
+    PackedFloat64Array make_header(const String& shp_filename, const CoastlineTileSettings& settings) {
+        PackedFloat64Array header;
+        header.push_back(FORMAT_VERSION);
+        header.push_back(settings.zoom);
+        header.push_back(settings.lod_count);
+        header.push_back(settings.min_lon);
+        header.push_back(settings.min_lat);
+        header.push_back(settings.max_lon);
+        header.push_back(settings.max_lat);
+        header.push_back(settings.resolution);
+        header.push_back(static_cast<double>(FileAccess::get_modified_time(shp_filename)));
+        return header;
+    }
+
+    /* Tile bounds in degrees (min lon, min lat, max lon, max lat). */
+    void tile_bounds(int64_t key, double bounds[4]) {
+        GeoCoords min_bounds, max_bounds;
+        QuadkeyTileMap::key_bounds(key, min_bounds, max_bounds);
+        bounds[0] = min_bounds.lon.get_degrees();
+        bounds[1] = min_bounds.lat.get_degrees();
+        bounds[2] = max_bounds.lon.get_degrees();
+        bounds[3] = max_bounds.lat.get_degrees();
+    }
+
+    /* Range of tiles at a zoom level meeting the query box; y grows south. */
+    void tile_range(const CoastlineTileSettings& settings, int zoom, int64_t& min_x, int64_t& min_y, int64_t& max_x, int64_t& max_y) {
+        const double to_radians = Math_PI / 180.0;
+        QuadkeyTileMap::geo_to_tile(settings.min_lon * to_radians, settings.max_lat * to_radians, zoom, min_x, min_y);
+        QuadkeyTileMap::geo_to_tile(settings.max_lon * to_radians, settings.min_lat * to_radians, zoom, max_x, max_y);
+    }
+
+    template <typename T, typename Packed>
+    Packed to_packed(const std::vector<T>& values) {
+        Packed packed;
+        packed.resize(values.size());
+        std::copy(values.begin(), values.end(), packed.ptrw());
+        return packed;
+    }
+
+    void store_index(const Ref<FileAccess>& file, std::vector<std::pair<int64_t, int64_t>>& index) {
+        std::sort(index.begin(), index.end());
+        PackedInt64Array keys, offsets;
+        for (const auto& [key, offset] : index) {
+            keys.push_back(key);
+            offsets.push_back(offset);
+        }
+        file->store_var(keys);
+        file->store_var(offsets);
+    }
+
+    void store_tile(const Ref<FileAccess>& file, const ShapefilePolygons& polygons) {
+        file->store_var(to_packed<double, PackedFloat64Array>(polygons.lon));
+        file->store_var(to_packed<double, PackedFloat64Array>(polygons.lat));
+        file->store_var(to_packed<uint32_t, PackedInt32Array>(polygons.ring_offsets));
+        file->store_var(to_packed<uint32_t, PackedInt32Array>(polygons.polygon_offsets));
+    }
+}
+
+String coastlineTilesPath(const String& shp_filename) {
+    return shp_filename.get_basename() + ".sgdmap";
+}
+
+bool writeCoastlineTiles(const String& shp_filename, const ShapefilePolygons& polygons, const CoastlineTileSettings& settings) {
+    const int coarsest = std::max(0, settings.zoom - std::max(settings.lod_count, 1) + 1);
+    int64_t min_x, min_y, max_x, max_y;
+    tile_range(settings, settings.zoom, min_x, min_y, max_x, max_y);
+    if ((max_x - min_x + 1) * (max_y - min_y + 1) > MAX_TILES) {
+        WARN_PRINT("Too many coastline tiles at zoom " + String::num_int64(settings.zoom) + " for the imported area.");
+        return false;
+    }
+
+    const String path = coastlineTilesPath(shp_filename);
+    const String temporary_path = path + ".tmp";
+    Ref<FileAccess> file = FileAccess::open(temporary_path, FileAccess::WRITE);
+    if (file.is_null() || !file->is_open()) {
+        WARN_PRINT("Could not write coastline tiles " + path);
+        return false;
+    }
+    file->store_64(0);
+    file->store_var(make_header(shp_filename, settings));
+
+    // Tiles of the current level with their polygons clipped but not yet simplified, which is what their children are cut from.
+    std::vector<std::pair<int64_t, ShapefilePolygons>> level;
+    tile_range(settings, coarsest, min_x, min_y, max_x, max_y);
+    for (int64_t y = min_y; y <= max_y; y++) {
+        for (int64_t x = min_x; x <= max_x; x++) {
+            level.emplace_back(QuadkeyTileMap::make_key(coarsest, x, y), ShapefilePolygons());
+            double bounds[4];
+            tile_bounds(level.back().first, bounds);
+            clipPolygons(polygons, bounds[0], bounds[1], bounds[2], bounds[3], level.back().second);
+        }
+    }
+
+    std::vector<std::pair<int64_t, int64_t>> index, exact_index;
+    for (int zoom = coarsest; zoom <= settings.zoom && !level.empty(); zoom++) {
+        const int lod = settings.zoom - zoom;
+        std::vector<std::pair<int64_t, ShapefilePolygons>> next_level;
+        for (auto& [key, clipped] : level) {
+            if (clipped.polygon_count() == 0)
+                continue;
+
+            index.emplace_back(key, static_cast<int64_t>(file->get_position()));
+            if (settings.resolution > 0.0) {
+                ShapefilePolygons simplified;
+                simplifyPolygons(clipped, settings.resolution * static_cast<double>(int64_t(1) << lod), simplified);
+                store_tile(file, simplified);
+                if (zoom == settings.zoom) {
+                    exact_index.emplace_back(key, static_cast<int64_t>(file->get_position()));
+                    store_tile(file, clipped);
+                }
+            } else {
+                store_tile(file, clipped);
+            }
+
+            if (zoom == settings.zoom)
+                continue;
+            for (int child = 0; child < 4; child++) {
+                const int64_t child_key = QuadkeyTileMap::key_child(key, child);
+                double bounds[4];
+                tile_bounds(child_key, bounds);
+                if (bounds[2] < settings.min_lon || bounds[0] > settings.max_lon || bounds[3] < settings.min_lat || bounds[1] > settings.max_lat)
+                    continue;
+                next_level.emplace_back(child_key, ShapefilePolygons());
+                clipPolygons(clipped, bounds[0], bounds[1], bounds[2], bounds[3], next_level.back().second);
+            }
+        }
+        level = std::move(next_level);
+    }
+
+    const int64_t index_offset = static_cast<int64_t>(file->get_position());
+    store_index(file, index);
+    store_index(file, exact_index);
+    file->seek(0);
+    file->store_64(static_cast<uint64_t>(index_offset));
+    file->close();
+
+    if (DirAccess::rename_absolute(temporary_path, path) != OK) {
+        WARN_PRINT("Could not replace coastline tiles " + path);
+        DirAccess::remove_absolute(temporary_path);
+        return false;
+    }
+    return true;
+}
+
+bool isCoastlineTilesCurrent(const String& shp_filename, const CoastlineTileSettings& settings) {
+    const String path = coastlineTilesPath(shp_filename);
+    if (!FileAccess::file_exists(path))
+        return false;
+    Ref<FileAccess> file = FileAccess::open(path, FileAccess::READ);
+    if (file.is_null() || !file->is_open() || file->get_64() == 0)
+        return false;
+    const PackedFloat64Array header = file->get_var();
+    return header == make_header(shp_filename, settings);
+}
+
+bool CoastlineTileReader::open(const String& shp_filename) {
+    file.unref();
+    keys.clear();
+    offsets.clear();
+    exact_keys.clear();
+    exact_offsets.clear();
+
+    const String path = coastlineTilesPath(shp_filename);
+    if (!FileAccess::file_exists(path))
+        return false;
+    Ref<FileAccess> opened = FileAccess::open(path, FileAccess::READ);
+    if (opened.is_null() || !opened->is_open())
+        return false;
+
+    const int64_t index_offset = static_cast<int64_t>(opened->get_64());
+    if (index_offset <= 0 || static_cast<uint64_t>(index_offset) >= opened->get_length())
+        return false;
+    opened->seek(index_offset);
+    PackedInt64Array index_keys = opened->get_var();
+    PackedInt64Array index_offsets = opened->get_var();
+    PackedInt64Array index_exact_keys = opened->get_var();
+    PackedInt64Array index_exact_offsets = opened->get_var();
+    if (index_keys.size() != index_offsets.size() || index_exact_keys.size() != index_exact_offsets.size()) {
+        WARN_PRINT("Corrupted coastline tiles " + path);
+        return false;
+    }
+    file = opened;
+    keys = index_keys;
+    offsets = index_offsets;
+    exact_keys = index_exact_keys;
+    exact_offsets = index_exact_offsets;
+    return true;
+}
+
+bool CoastlineTileReader::read(int64_t key, ShapefilePolygons& out, bool exact) {
+    if (file.is_null())
+        return false;
+    // Without simplification the tiles are exact already and there is no second copy.
+    const bool use_exact = exact && !exact_keys.is_empty();
+    const PackedInt64Array& index_keys = use_exact ? exact_keys : keys;
+    const int64_t* begin = index_keys.ptr();
+    const int64_t* found = std::lower_bound(begin, begin + index_keys.size(), key);
+    if (found == begin + index_keys.size() || *found != key)
+        return false;
+
+    file->seek((use_exact ? exact_offsets : offsets)[found - begin]);
+    const PackedFloat64Array lon = file->get_var();
+    const PackedFloat64Array lat = file->get_var();
+    const PackedInt32Array ring_offsets = file->get_var();
+    const PackedInt32Array polygon_offsets = file->get_var();
+    if (lon.size() != lat.size() || ring_offsets.is_empty() || polygon_offsets.is_empty() ||
+        ring_offsets[ring_offsets.size() - 1] != lon.size() || polygon_offsets[polygon_offsets.size() - 1] != ring_offsets.size() - 1) {
+        WARN_PRINT("Corrupted coastline tile " + String::num_int64(key));
+        return false;
+    }
+
+    // Offsets in the file start at 0, so they are rebased onto what out already holds.
+    const uint32_t point_base = static_cast<uint32_t>(out.lon.size()), ring_base = static_cast<uint32_t>(out.ring_count());
+    out.lon.insert(out.lon.end(), lon.ptr(), lon.ptr() + lon.size());
+    out.lat.insert(out.lat.end(), lat.ptr(), lat.ptr() + lat.size());
+    for (int64_t i = 1; i < ring_offsets.size(); i++)
+        out.ring_offsets.push_back(point_base + static_cast<uint32_t>(ring_offsets[i]));
+    for (int64_t i = 1; i < polygon_offsets.size(); i++)
+        out.polygon_offsets.push_back(ring_base + static_cast<uint32_t>(polygon_offsets[i]));
+    return true;
+}
+
+PackedInt64Array readCoastlineTileKeys(const String& shp_filename) {
+    CoastlineTileReader reader;
+    reader.open(shp_filename);
+    return reader.get_keys();
+}
+
+bool readCoastlineTile(const String& shp_filename, int64_t key, ShapefilePolygons& out) {
+    CoastlineTileReader reader;
+    return reader.open(shp_filename) && reader.read(key, out);
+}
@@ -0,0 +1,74 @@
+#ifndef COASTLINE_TILES_H
+#define COASTLINE_TILES_H
+#include "Shapefile.h"
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/variant/packed_int64_array.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+/**
+ * Coastline layer of a .sgdmap: polygons clipped to QuadkeyTileMap tiles at several levels of detail.
+ * LOD l holds the tiles of zoom - l, simplified with resolution * 2^l. With a resolution, the tiles of LOD 0 are
+ * also stored unsimplified, so that the coast mask comes out the same as when built from the shapefile.
+ *
+ * Layout (Godot variants as written by FileAccess::store_var):
+ *   index offset   int64, position of the index, which is written last
+ *   header         PackedFloat64Array: format version, zoom, LOD count, query box (min lon, min lat, max lon, max lat in degrees),
+ *                  resolution, modification time of the shapefile
+ *   tiles          per tile with polygons: PackedFloat64Array lon and lat (degrees), PackedInt32Array ring and polygon offsets
+ *   index          PackedInt64Array tile keys (ascending), PackedInt64Array tile offsets
+ *   exact index    the same for the unsimplified LOD 0 tiles; empty without a resolution
+ */
+struct CoastlineTileSettings {
+    int zoom;
+    int lod_count;
+    double min_lon, min_lat, max_lon, max_lat;
+    /* Simplification tolerance of LOD 0 in metres; 0 keeps every point. */
+    double resolution;
+};
+
+/* Path of the coastline layer made from a shapefile. */
+godot::String coastlineTilesPath(const godot::String& shp_filename);
+
+/**
+ * Clips the polygons to every tile meeting the query box and writes the layer.
+ * Each zoom level is clipped from the tiles of the level above, so every polygon is cut only near where it is.
+ * @return false if the layer could not be written or would have too many tiles.
+ */
+bool writeCoastlineTiles(const godot::String& shp_filename, const ShapefilePolygons& polygons, const CoastlineTileSettings& settings);
+
+/* @return Whether the layer was written from the current shapefile with these settings. */
+bool isCoastlineTilesCurrent(const godot::String& shp_filename, const CoastlineTileSettings& settings);
+
+/* Reads many tiles of a layer, opening it and reading its index only once. */
+class CoastlineTileReader {
+public:
+    /* @return false if there is no readable layer for the shapefile. */
+    bool open(const godot::String& shp_filename);
+
+    /* Keys of the tiles stored in the layer, ascending. */
+    const godot::PackedInt64Array& get_keys() const {
+        return keys;
+    }
+
+    /**
+     * Appends the polygons of a tile to out.
+     * @param exact Read the unsimplified copy of a LOD 0 tile.
+     * @return false if the layer has no such tile.
+     */
+    bool read(int64_t key, ShapefilePolygons& out, bool exact = false);
+
+private:
+    godot::Ref<godot::FileAccess> file;
+    godot::PackedInt64Array keys;
+    godot::PackedInt64Array offsets;
+    godot::PackedInt64Array exact_keys;
+    godot::PackedInt64Array exact_offsets;
+};
+
+/* Keys of the tiles stored in the layer, empty if there is none. */
+godot::PackedInt64Array readCoastlineTileKeys(const godot::String& shp_filename);
+
+/* Appends the polygons of a tile to out. @return false if the layer has no such tile. */
+bool readCoastlineTile(const godot::String& shp_filename, int64_t key, ShapefilePolygons& out);
+
+#endif // COASTLINE_TILES_H
@@ -0,0 +1,254 @@
+#include "Shapefile.h"
+#include "ShapefileIndex.h"
+#include "../../util/Parallel.h"
+#include "../GeoMap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <godot_cpp/variant/packed_vector2_array.hpp>
+
+using namespace godot;
+
+namespace {
+    const double MERCATOR_RADIUS = 6378137.0; // Earth radius in meters for Mercator
+    const size_t FILE_HEADER_SIZE = 100;
+    const size_t RECORD_HEADER_SIZE = 8;
+    const int32_t FILE_CODE = 9994;
+
+    // Offsets in the content of a polygon record.
+    const size_t POLYGON_BOX = 4;
+    const size_t POLYGON_PART_COUNT = 36;
+    const size_t POLYGON_POINT_COUNT = 40;
+    const size_t POLYGON_PARTS = 44;
+
+    uint32_t swap_bytes(uint32_t value) {
+        return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+    }
+
+    template <typename T>
+    T read_little(const uint8_t* data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    bool intersects(double xMin1, double yMin1, double xMax1, double yMax1,
+                    double xMin2, double yMin2, double xMax2, double yMax2) {
+        return !(xMax1 < xMin2 || xMin1 > xMax2 || yMax1 < yMin2 || yMin1 > yMax2);
+    }
+
+    bool is_polygon(int32_t shape_type) {
+        return shape_type == Shapefile::SHAPE_POLYGON || shape_type == Shapefile::SHAPE_POLYGON_Z || shape_type == Shapefile::SHAPE_POLYGON_M;
+    }
+}
+
+void ShapefilePolygons::clear() {
+    lon.clear();
+    lat.clear();
+    ring_offsets.assign(1, 0);
+    polygon_offsets.assign(1, 0);
+}
+
+TypedArray<Array> ShapefilePolygons::to_godot() const {
+    TypedArray<Array> polygons;
+    for (size_t p = 0; p < polygon_count(); p++) {
+        TypedArray<PackedVector2Array> polygon;
+        for (uint32_t r = polygon_offsets[p]; r < polygon_offsets[p + 1]; r++) {
+            PackedVector2Array ring;
+            ring.resize(ring_offsets[r + 1] - ring_offsets[r]);
+            Vector2* dst = ring.ptrw();
+            for (uint32_t i = ring_offsets[r]; i < ring_offsets[r + 1]; i++)
+                *dst++ = GeoCoords(Longitude::degrees(lon[i]), Latitude::degrees(lat[i])).to_vector2_representation();
+            polygon.append(ring);
+        }
+        polygons.append(polygon);
+    }
+    return polygons;
+}
+
+bool Shapefile::open(const String& shp_filename, const String& shx_filename) {
+    record_offsets.clear();
+    record_sizes.clear();
+
+    FileBytes shx;
+    if (!shp.open(shp_filename, MappedFile::RANDOM) || !shx.open(shx_filename))
+        return false;
+    if (shp.size() < FILE_HEADER_SIZE || shx.size() < FILE_HEADER_SIZE ||
+        swap_bytes(read_little<uint32_t>(shp.data())) != static_cast<uint32_t>(FILE_CODE))
+        return false;
+
+    // The index is pairs of big-endian (offset, content length) in 16-bit words; swap it all at once.
+    const size_t count = (shx.size() - FILE_HEADER_SIZE) / 8;
+    std::vector<uint32_t> words(2 * count);
+    std::memcpy(words.data(), shx.data() + FILE_HEADER_SIZE, words.size() * sizeof(uint32_t));
+    for (uint32_t& word : words)
+        word = swap_bytes(word);
+
+    record_offsets.resize(count);
+    record_sizes.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const uint64_t offset = static_cast<uint64_t>(words[2 * i]) * 2 + RECORD_HEADER_SIZE;
+        const uint64_t size = static_cast<uint64_t>(words[2 * i + 1]) * 2;
+        if (offset + size > shp.size()) {
+            record_offsets.clear();
+            record_sizes.clear();
+            return false;
+        }
+        record_offsets[i] = static_cast<uint32_t>(offset);
+        record_sizes[i] = static_cast<uint32_t>(size);
+    }
+    return true;
+}
+
+const uint8_t* Shapefile::record_content(size_t record, size_t& size) const {
+    if (record >= record_offsets.size())
+        return nullptr;
+    size = record_sizes[record];
+    return shp.data() + record_offsets[record];
+}
+
+int32_t Shapefile::get_shape_type(size_t record) const {
+    size_t size;
+    const uint8_t* content = record_content(record, size);
+    return content != nullptr && size >= 4 ? read_little<int32_t>(content) : 0;
+}
+
+bool Shapefile::get_record_bounds(size_t record, double bounds[4]) const {
+    size_t size;
+    const uint8_t* content = record_content(record, size);
+    if (content == nullptr || size < POLYGON_PARTS || !is_polygon(read_little<int32_t>(content)))
+        return false;
+    std::memcpy(bounds, content + POLYGON_BOX, 4 * sizeof(double));
+    return true;
+}
+
+bool Shapefile::polygon_layout(size_t record, const uint8_t*& content, int32_t& part_count, int32_t& point_count) const {
+    size_t size;
+    content = record_content(record, size);
+    if (content == nullptr || size < POLYGON_PARTS || !is_polygon(read_little<int32_t>(content)))
+        return false;
+
+    part_count = read_little<int32_t>(content + POLYGON_PART_COUNT);
+    point_count = read_little<int32_t>(content + POLYGON_POINT_COUNT);
+    const size_t points_offset = POLYGON_PARTS + 4 * static_cast<size_t>(std::max(0, part_count));
+    return part_count > 0 && point_count >= 0 && points_offset + 16 * static_cast<size_t>(point_count) <= size;
+}
+
+void Shapefile::decode_into(const uint8_t* content, int32_t part_count, int32_t point_count, ShapefileFormat format,
+                            double* lon, double* lat, uint32_t* ring_ends, uint32_t first_point) {
+    const uint8_t* points = content + POLYGON_PARTS + 4 * static_cast<size_t>(part_count);
+    for (int32_t i = 0; i < point_count; i++) {
+        std::memcpy(&lon[i], points + 16 * static_cast<size_t>(i), sizeof(double));
+        std::memcpy(&lat[i], points + 16 * static_cast<size_t>(i) + 8, sizeof(double));
+    }
+    to_degrees(format, lon, lat, point_count);
+
+    // Malformed part indices could decrease; ends never go back, so broken parts become empty rings instead of wrapping.
+    int32_t previous_end = 0;
+    for (int32_t part = 0; part < part_count; part++) {
+        const int32_t end = part + 1 < part_count ? read_little<int32_t>(content + POLYGON_PARTS + 4 * (part + 1)) : point_count;
+        previous_end = std::max(previous_end, std::min(end, point_count));
+        ring_ends[part] = first_point + static_cast<uint32_t>(previous_end);
+    }
+}
+
+bool Shapefile::decode_polygon(size_t record, ShapefileFormat format, ShapefilePolygons& out) const {
+    const uint8_t* content;
+    int32_t part_count, point_count;
+    if (!polygon_layout(record, content, part_count, point_count))
+        return false;
+
+    const size_t base = out.lon.size(), ring_base = out.ring_offsets.size();
+    out.lon.resize(base + point_count);
+    out.lat.resize(base + point_count);
+    out.ring_offsets.resize(ring_base + part_count);
+    decode_into(content, part_count, point_count, format, out.lon.data() + base, out.lat.data() + base,
+                out.ring_offsets.data() + ring_base, static_cast<uint32_t>(base));
+    out.polygon_offsets.push_back(static_cast<uint32_t>(out.ring_count()));
+    return true;
+}
+
+void Shapefile::decode_polygons(const std::vector<uint32_t>& records, ShapefileFormat format, ShapefilePolygons& out) const {
+    struct Slot {
+        const uint8_t* content;
+        int32_t part_count;
+        int32_t point_count;
+        size_t first_point;
+        size_t first_ring;
+    };
+
+    // Sizes first: they give every record its place in the flat arrays.
+    std::vector<Slot> slots;
+    slots.reserve(records.size());
+    size_t point_total = out.lon.size(), ring_total = out.ring_count();
+    for (uint32_t record : records) {
+        Slot slot;
+        if (!polygon_layout(record, slot.content, slot.part_count, slot.point_count))
+            continue;
+        slot.first_point = point_total;
+        slot.first_ring = ring_total;
+        point_total += slot.point_count;
+        ring_total += slot.part_count;
+        slots.push_back(slot);
+    }
+
+    out.lon.resize(point_total);
+    out.lat.resize(point_total);
+    out.ring_offsets.resize(ring_total + 1);
+    const size_t polygon_base = out.polygon_offsets.size();
+    out.polygon_offsets.resize(polygon_base + slots.size());
+    for (size_t i = 0; i < slots.size(); i++)
+        out.polygon_offsets[polygon_base + i] = static_cast<uint32_t>(slots[i].first_ring + slots[i].part_count);
+
+    parallel_for(slots.size(), [&](size_t i, size_t) {
+        const Slot& slot = slots[i];
+        decode_into(slot.content, slot.part_count, slot.point_count, format, out.lon.data() + slot.first_point, out.lat.data() + slot.first_point,
+                    out.ring_offsets.data() + slot.first_ring + 1, static_cast<uint32_t>(slot.first_point));
+    }, 16);
+}
+
+void Shapefile::read_polygons(ShapefileFormat format, double min_lon, double min_lat, double max_lon, double max_lat, ShapefilePolygons& out,
+                              const ShapefileIndex* index) const {
+    std::vector<uint32_t> records;
+    if (index != nullptr && !index->empty()) {
+        // Both projections are monotonic, so the query converts to a rectangle in file coordinates.
+        double x[2] = { min_lon, max_lon }, y[2] = { min_lat, max_lat };
+        from_degrees(format, x, y, 2);
+        index->query(x[0], y[0], x[1], y[1], records);
+    } else {
+        for (size_t record = 0; record < get_record_count(); record++) {
+            double bounds[4];
+            if (!get_record_bounds(record, bounds))
+                continue;
+            // Both projections are monotonic, so the converted corners bound the converted record.
+            double x[2] = { bounds[0], bounds[2] }, y[2] = { bounds[1], bounds[3] };
+            to_degrees(format, x, y, 2);
+            if (intersects(min_lon, min_lat, max_lon, max_lat, x[0], y[0], x[1], y[1]))
+                records.push_back(static_cast<uint32_t>(record));
+        }
+    }
+    decode_polygons(records, format, out);
+}
+
+void Shapefile::to_degrees(ShapefileFormat format, double* x, double* y, size_t count) {
+    if (format != ShapefileFormat::MERCATOR)
+        return;
+    const double degrees_per_radian = 180.0 / Math_PI;
+    const double inverse_radius = 1.0 / MERCATOR_RADIUS;
+    for (size_t i = 0; i < count; i++)
+        x[i] = x[i] * inverse_radius * degrees_per_radian;
+    for (size_t i = 0; i < count; i++)
+        y[i] = std::atan(std::sinh(y[i] * inverse_radius)) * degrees_per_radian;
+}
+
+void Shapefile::from_degrees(ShapefileFormat format, double* x, double* y, size_t count) {
+    if (format != ShapefileFormat::MERCATOR)
+        return;
+    const double radians_per_degree = Math_PI / 180.0;
+    // Latitudes are kept off the poles, where Mercator is infinite.
+    const double max_latitude = 89.999999;
+    for (size_t i = 0; i < count; i++)
+        x[i] = x[i] * radians_per_degree * MERCATOR_RADIUS;
+    for (size_t i = 0; i < count; i++)
+        y[i] = std::asinh(std::tan(std::max(-max_latitude, std::min(max_latitude, y[i])) * radians_per_degree)) * MERCATOR_RADIUS;
+}
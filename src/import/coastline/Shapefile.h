@@ -0,0 +1,105 @@
+#ifndef SHAPEFILE_H
+#define SHAPEFILE_H
+#include "../../util/MappedFile.h"
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <godot_cpp/variant/typed_array.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ShapefileIndex;
+
+enum class ShapefileFormat {
+    UNKNOWN,
+    WGS84,
+    MERCATOR
+};
+
+/**
+ * Polygons decoded into flat arrays.
+ * Ring i has the points [ring_offsets[i], ring_offsets[i + 1]), polygon i the rings
+ * [polygon_offsets[i], polygon_offsets[i + 1]). Coordinates are in degrees, one array per axis.
+ */
+struct ShapefilePolygons {
+    std::vector<double> lon;
+    std::vector<double> lat;
+    std::vector<uint32_t> ring_offsets = { 0 };
+    std::vector<uint32_t> polygon_offsets = { 0 };
+
+    size_t polygon_count() const {
+        return polygon_offsets.size() - 1;
+    }
+    size_t ring_count() const {
+        return ring_offsets.size() - 1;
+    }
+    void clear();
+
+    /* Array of polygons, each an Array of PackedVector2Array rings in the Vector2 geo representation. */
+    godot::TypedArray<godot::Array> to_godot() const;
+};
+
+/**
+ * Read-only view of an ESRI shapefile (.shp with its .shx index).
+ *
+ * Both files are mapped; the big-endian .shx index is converted in one pass on open and records are
+ * decoded straight from the mapped .shp. Only polygon records (Polygon, PolygonZ, PolygonM) are decoded.
+ */
+class Shapefile {
+public:
+    enum ShapeType {
+        SHAPE_POLYGON = 5,
+        SHAPE_POLYGON_Z = 15,
+        SHAPE_POLYGON_M = 25,
+    };
+
+    /* @return Whether both files could be opened and the index matches the .shp. */
+    bool open(const godot::String& shp_filename, const godot::String& shx_filename);
+
+    size_t get_record_count() const {
+        return record_offsets.size();
+    }
+    /* Shape type of a record, 0 if the record is invalid. */
+    int32_t get_shape_type(size_t record) const;
+    /**
+     * Bounding box of a polygon record in file coordinates (min x, min y, max x, max y).
+     * @return false if the record is not a valid polygon.
+     */
+    bool get_record_bounds(size_t record, double bounds[4]) const;
+
+    /* Appends a polygon record to out, converted to degrees. @return false if it is not a valid polygon. */
+    bool decode_polygon(size_t record, ShapefileFormat format, ShapefilePolygons& out) const;
+    /**
+     * Appends polygon records to out in the given order, skipping invalid ones.
+     * Sizes are read first, so every record is decoded in parallel straight into its place in out.
+     */
+    void decode_polygons(const std::vector<uint32_t>& records, ShapefileFormat format, ShapefilePolygons& out) const;
+
+    /**
+     * Appends all polygon records whose bounding box meets the query rectangle (degrees), in file order.
+     * @param index Index of this file; without one every record is checked.
+     */
+    void read_polygons(ShapefileFormat format, double min_lon, double min_lat, double max_lon, double max_lat, ShapefilePolygons& out,
+                       const ShapefileIndex* index = nullptr) const;
+
+    /* Converts file coordinates to degrees in place; a pass per axis that the compiler can vectorize. */
+    static void to_degrees(ShapefileFormat format, double* x, double* y, size_t count);
+    /* Converts degrees to file coordinates in place. */
+    static void from_degrees(ShapefileFormat format, double* x, double* y, size_t count);
+
+private:
+    /* Content of a record (after its header), or null if it does not fit into the .shp. */
+    const uint8_t* record_content(size_t record, size_t& size) const;
+    /* Content, part and point counts of a polygon record. @return false if it is not a valid polygon. */
+    bool polygon_layout(size_t record, const uint8_t*& content, int32_t& part_count, int32_t& point_count) const;
+    /* Decodes a valid polygon record into lon/lat and the ends of its rings, first_point being the index of lon[0]. */
+    static void decode_into(const uint8_t* content, int32_t part_count, int32_t point_count, ShapefileFormat format,
+                            double* lon, double* lat, uint32_t* ring_ends, uint32_t first_point);
+
+    FileBytes shp;
+    /* Byte offsets and sizes of the record contents, from the .shx. */
+    std::vector<uint32_t> record_offsets;
+    std::vector<uint32_t> record_sizes;
+};
+
+#endif // SHAPEFILE_H
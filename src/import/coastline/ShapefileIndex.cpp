@@ -0,0 +1,298 @@
+#include "ShapefileIndex.h"
+#include "Shapefile.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+
+using namespace godot;
+
+namespace {
+    const uint32_t SGIDX_VERSION = 1;
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t node_size;
+        uint64_t source_size;
+        uint64_t source_mtime;
+        uint32_t item_count;
+        uint32_t node_count;
+        uint32_t level_count;
+        uint32_t reserved;
+    };
+
+    /* Header fields identifying the .shp. @return false if it is missing. */
+    bool make_key(const String& shp_filename, Header& header) {
+        Ref<FileAccess> source = FileAccess::open(shp_filename, FileAccess::READ);
+        if (source.is_null() || !source->is_open())
+            return false;
+
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "SGIX", 4);
+        header.version = SGIDX_VERSION;
+        header.byte_order = BYTE_ORDER_MARK;
+        header.node_size = ShapefileIndex::NODE_SIZE;
+        header.source_size = source->get_length();
+        header.source_mtime = FileAccess::get_modified_time(shp_filename);
+        return true;
+    }
+
+    size_t boxes_offset(uint32_t level_count) {
+        return (sizeof(Header) + level_count * sizeof(uint32_t) + 7) / 8 * 8;
+    }
+
+    /* Position of (x, y) on a 16 bit Hilbert curve (from "Fast Hilbert curve generation" by rawrunprotected). */
+    uint32_t hilbert(uint32_t x, uint32_t y) {
+        uint32_t a = x ^ y;
+        uint32_t b = 0xFFFF ^ a;
+        uint32_t c = 0xFFFF ^ (x | y);
+        uint32_t d = x & (y ^ 0xFFFF);
+
+        uint32_t A = a | (b >> 1);
+        uint32_t B = (a >> 1) ^ a;
+        uint32_t C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+        uint32_t D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+        a = A; b = B; c = C; d = D;
+        A = (a & (a >> 2)) ^ (b & (b >> 2));
+        B = (a & (b >> 2)) ^ (b & ((a ^ b) >> 2));
+        C ^= (a & (c >> 2)) ^ (b & (d >> 2));
+        D ^= (b & (c >> 2)) ^ ((a ^ b) & (d >> 2));
+
+        a = A; b = B; c = C; d = D;
+        A = (a & (a >> 4)) ^ (b & (b >> 4));
+        B = (a & (b >> 4)) ^ (b & ((a ^ b) >> 4));
+        C ^= (a & (c >> 4)) ^ (b & (d >> 4));
+        D ^= (b & (c >> 4)) ^ ((a ^ b) & (d >> 4));
+
+        a = A; b = B; c = C; d = D;
+        C ^= (a & (c >> 8)) ^ (b & (d >> 8));
+        D ^= (b & (c >> 8)) ^ ((a ^ b) & (d >> 8));
+
+        a = C ^ (C >> 1);
+        b = D ^ (D >> 1);
+
+        uint32_t i0 = x ^ y;
+        uint32_t i1 = b | (0xFFFF ^ (i0 | a));
+
+        i0 = (i0 | (i0 << 8)) & 0x00FF00FF;
+        i0 = (i0 | (i0 << 4)) & 0x0F0F0F0F;
+        i0 = (i0 | (i0 << 2)) & 0x33333333;
+        i0 = (i0 | (i0 << 1)) & 0x55555555;
+
+        i1 = (i1 | (i1 << 8)) & 0x00FF00FF;
+        i1 = (i1 | (i1 << 4)) & 0x0F0F0F0F;
+        i1 = (i1 | (i1 << 2)) & 0x33333333;
+        i1 = (i1 | (i1 << 1)) & 0x55555555;
+
+        return (i1 << 1) | i0;
+    }
+}
+
+void ShapefileIndex::clear() {
+    level_bounds.clear();
+    owned_boxes.clear();
+    owned_indices.clear();
+    mapping.close();
+    boxes = nullptr;
+    indices = nullptr;
+    item_count = 0;
+    node_count = 0;
+}
+
+void ShapefileIndex::build(const Shapefile& shapefile) {
+    clear();
+
+    std::vector<double> items;
+    std::vector<uint32_t> records;
+    double extent[4] = { std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(),
+                         -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+    for (size_t record = 0; record < shapefile.get_record_count(); record++) {
+        double bounds[4];
+        if (!shapefile.get_record_bounds(record, bounds))
+            continue;
+        items.insert(items.end(), bounds, bounds + 4);
+        records.push_back(static_cast<uint32_t>(record));
+        extent[0] = std::min(extent[0], bounds[0]);
+        extent[1] = std::min(extent[1], bounds[1]);
+        extent[2] = std::max(extent[2], bounds[2]);
+        extent[3] = std::max(extent[3], bounds[3]);
+    }
+    item_count = static_cast<uint32_t>(records.size());
+    if (item_count == 0)
+        return;
+
+    // Level sizes, leaves first.
+    uint32_t n = item_count;
+    node_count = n;
+    level_bounds.push_back(node_count);
+    do {
+        n = (n + NODE_SIZE - 1) / NODE_SIZE;
+        node_count += n;
+        level_bounds.push_back(node_count);
+    } while (n != 1);
+
+    // Leaves in Hilbert order of their centres.
+    const double width = std::max(extent[2] - extent[0], 1e-300), height = std::max(extent[3] - extent[1], 1e-300);
+    std::vector<uint32_t> hilbert_values(item_count), order(item_count);
+    for (uint32_t i = 0; i < item_count; i++) {
+        const double* box = &items[4 * i];
+        const uint32_t x = static_cast<uint32_t>(0xFFFF * ((box[0] + box[2]) / 2 - extent[0]) / width);
+        const uint32_t y = static_cast<uint32_t>(0xFFFF * ((box[1] + box[3]) / 2 - extent[1]) / height);
+        hilbert_values[i] = hilbert(std::min<uint32_t>(x, 0xFFFF), std::min<uint32_t>(y, 0xFFFF));
+    }
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return hilbert_values[a] < hilbert_values[b];
+    });
+
+    owned_boxes.resize(4 * static_cast<size_t>(node_count));
+    owned_indices.resize(node_count);
+    for (uint32_t i = 0; i < item_count; i++) {
+        std::memcpy(&owned_boxes[4 * static_cast<size_t>(i)], &items[4 * static_cast<size_t>(order[i])], 4 * sizeof(double));
+        owned_indices[i] = records[order[i]];
+    }
+
+    // Every run of NODE_SIZE nodes of a level gets a parent in the next one.
+    uint32_t write = item_count;
+    for (size_t level = 0, read = 0; level + 1 < level_bounds.size(); level++) {
+        while (read < level_bounds[level]) {
+            const uint32_t first_child = static_cast<uint32_t>(read);
+            double* parent = &owned_boxes[4 * static_cast<size_t>(write)];
+            std::memcpy(parent, &owned_boxes[4 * read], 4 * sizeof(double));
+            for (uint32_t j = 0; j < NODE_SIZE && read < level_bounds[level]; j++, read++) {
+                const double* child = &owned_boxes[4 * read];
+                parent[0] = std::min(parent[0], child[0]);
+                parent[1] = std::min(parent[1], child[1]);
+                parent[2] = std::max(parent[2], child[2]);
+                parent[3] = std::max(parent[3], child[3]);
+            }
+            owned_indices[write++] = first_child;
+        }
+    }
+
+    boxes = owned_boxes.data();
+    indices = owned_indices.data();
+}
+
+bool ShapefileIndex::load(const String& path, const String& shp_filename, size_t record_count) {
+    clear();
+    Header expected;
+    if (!FileAccess::file_exists(path) || !make_key(shp_filename, expected))
+        return false;
+    if (!mapping.open(MappedFile::native_path(path), MappedFile::RANDOM) || mapping.size() < sizeof(Header))
+        return false;
+
+    Header header;
+    std::memcpy(&header, mapping.data(), sizeof(header));
+    const size_t offset = boxes_offset(header.level_count);
+    const size_t size = offset + static_cast<size_t>(header.node_count) * (4 * sizeof(double) + sizeof(uint32_t));
+    if (std::memcmp(header.magic, expected.magic, 4) != 0 || header.version != expected.version || header.byte_order != expected.byte_order ||
+        header.node_size != expected.node_size || header.source_size != expected.source_size || header.source_mtime != expected.source_mtime ||
+        header.item_count > record_count || header.level_count == 0 || header.node_count < header.item_count || size != mapping.size()) {
+        clear();
+        return false;
+    }
+
+    level_bounds.resize(header.level_count);
+    std::memcpy(level_bounds.data(), mapping.data() + sizeof(Header), header.level_count * sizeof(uint32_t));
+    if (level_bounds.back() != header.node_count) {
+        clear();
+        return false;
+    }
+    item_count = header.item_count;
+    node_count = header.node_count;
+    boxes = reinterpret_cast<const double*>(mapping.data() + offset);
+    indices = reinterpret_cast<const uint32_t*>(mapping.data() + offset + static_cast<size_t>(node_count) * 4 * sizeof(double));
+    return true;
+}
+
+bool ShapefileIndex::save(const String& path, const String& shp_filename) const {
+    Header header;
+    if (!make_key(shp_filename, header))
+        return false;
+    header.item_count = item_count;
+    header.node_count = node_count;
+    header.level_count = static_cast<uint32_t>(level_bounds.size());
+
+    const size_t offset = boxes_offset(header.level_count);
+    const size_t boxes_size = static_cast<size_t>(node_count) * 4 * sizeof(double);
+    PackedByteArray bytes;
+    bytes.resize(static_cast<int64_t>(offset + boxes_size + static_cast<size_t>(node_count) * sizeof(uint32_t)));
+    uint8_t* dst = bytes.ptrw();
+    std::memset(dst, 0, bytes.size());
+    std::memcpy(dst, &header, sizeof(header));
+    if (!level_bounds.empty())
+        std::memcpy(dst + sizeof(header), level_bounds.data(), level_bounds.size() * sizeof(uint32_t));
+    if (node_count > 0) {
+        std::memcpy(dst + offset, boxes, boxes_size);
+        std::memcpy(dst + offset + boxes_size, indices, static_cast<size_t>(node_count) * sizeof(uint32_t));
+    }
+
+    // Write next to the index and rename, so indices still mapping an outdated file keep their data.
+    const String temporary_path = path + ".tmp";
+    Ref<FileAccess> file = FileAccess::open(temporary_path, FileAccess::WRITE);
+    if (file.is_null() || !file->is_open()) {
+        WARN_PRINT("Could not write shapefile index " + path);
+        return false;
+    }
+    file->store_buffer(bytes);
+    file->close();
+    if (DirAccess::rename_absolute(temporary_path, path) != OK) {
+        WARN_PRINT("Could not replace shapefile index " + path);
+        DirAccess::remove_absolute(temporary_path);
+        return false;
+    }
+    return true;
+}
+
+void ShapefileIndex::query(double min_x, double min_y, double max_x, double max_y, std::vector<uint32_t>& records) const {
+    if (empty())
+        return;
+
+    const size_t first = records.size();
+    std::vector<uint32_t> stack;
+    uint32_t node = node_count - 1;
+    size_t level = level_bounds.size() - 1;
+    std::vector<size_t> stack_levels;
+    while (true) {
+        // node is the first of a run of siblings on level; the run ends with NODE_SIZE nodes or the level.
+        const uint32_t end = std::min(node + NODE_SIZE, level_bounds[level]);
+        for (uint32_t i = node; i < end; i++) {
+            const double* box = boxes + 4 * static_cast<size_t>(i);
+            if (max_x < box[0] || min_x > box[2] || max_y < box[1] || min_y > box[3])
+                continue;
+            if (i < item_count) {
+                records.push_back(indices[i]);
+            } else {
+                stack.push_back(indices[i]);
+                stack_levels.push_back(level - 1);
+            }
+        }
+        if (stack.empty())
+            break;
+        node = stack.back();
+        level = stack_levels.back();
+        stack.pop_back();
+        stack_levels.pop_back();
+    }
+    std::sort(records.begin() + first, records.end());
+}
+
+String shapefileIndexPath(const String& shp_filename) {
+    return shp_filename + ".sgidx";
+}
+
+void loadShapefileIndex(const String& shp_filename, const Shapefile& shapefile, ShapefileIndex& index) {
+    const String path = shapefileIndexPath(shp_filename);
+    if (index.load(path, shp_filename, shapefile.get_record_count()))
+        return;
+    index.build(shapefile);
+    index.save(path, shp_filename);
+}
@@ -0,0 +1,67 @@
+#ifndef SHAPEFILE_INDEX_H
+#define SHAPEFILE_INDEX_H
+#include "../../util/MappedFile.h"
+#include <godot_cpp/variant/string.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Shapefile;
+
+/**
+ * Packed Hilbert R-tree over the bounding boxes of the polygon records of a shapefile.
+ *
+ * Records are sorted by the Hilbert value of their box centre and packed bottom up into nodes of
+ * NODE_SIZE children, so a query only visits nodes whose box meets the query box.
+ * Nodes are stored level by level from the leaves (one per record) to the root: a box
+ * (min x, min y, max x, max y, in file coordinates) and an index per node, which is the record number
+ * for leaves and the position of the first child for the nodes above.
+ *
+ * .sgidx: the index saved next to the .shp (<shp>.sgidx), used in place from a mapping.
+ *   header     magic "SGIX", version, byte order mark, node size, .shp size and modification time,
+ *              item, node and level counts
+ *   levels     level_count uint32: end of every level in the node array
+ *   boxes      node_count * 4 float64, from an 8 byte boundary
+ *   indices    node_count uint32
+ */
+class ShapefileIndex {
+public:
+    static constexpr uint32_t NODE_SIZE = 16;
+
+    /* Builds the index in memory. */
+    void build(const Shapefile& shapefile);
+    /* Maps a saved index. @return false if it is missing or was not made from this .shp. */
+    bool load(const godot::String& path, const godot::String& shp_filename, size_t record_count);
+    /* @return Whether the index could be written. */
+    bool save(const godot::String& path, const godot::String& shp_filename) const;
+
+    bool empty() const {
+        return node_count == 0;
+    }
+    size_t get_item_count() const {
+        return item_count;
+    }
+
+    /* Appends the records whose box meets the query box (file coordinates), in ascending order. */
+    void query(double min_x, double min_y, double max_x, double max_y, std::vector<uint32_t>& records) const;
+
+private:
+    void clear();
+
+    std::vector<uint32_t> level_bounds;
+    std::vector<double> owned_boxes;
+    std::vector<uint32_t> owned_indices;
+    MappedFile mapping;
+    const double* boxes = nullptr;
+    const uint32_t* indices = nullptr;
+    uint32_t item_count = 0;
+    uint32_t node_count = 0;
+};
+
+/* Path of the index saved next to a shapefile. */
+godot::String shapefileIndexPath(const godot::String& shp_filename);
+
+/* Maps the saved index of a shapefile; if there is no valid one, builds it and saves it. */
+void loadShapefileIndex(const godot::String& shp_filename, const Shapefile& shapefile, ShapefileIndex& index);
+
+#endif // SHAPEFILE_INDEX_H
@@ -0,0 +1,435 @@
+#include "BinaryDEM.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include "../../util/MappedFile.h"
+#include "../../util/Parallel.h"
+
+using namespace godot;
+
+RasterWindow RasterWindow::covering(const GeoCoords& top_left, double cellsize, int nrows, int ncols, const DEMWindow* window) {
+    RasterWindow result;
+    if (nrows <= 0 || ncols <= 0 || cellsize <= 0.0)
+        return result;
+    if (window == nullptr) {
+        result.rows = nrows;
+        result.cols = ncols;
+        return result;
+    }
+
+    const double left = top_left.lon.get_degrees(), top = top_left.lat.get_degrees();
+    const double col_begin = std::floor((window->min.lon.get_degrees() - left) / cellsize) - 1.0;
+    const double col_end = std::ceil((window->max.lon.get_degrees() - left) / cellsize) + 1.0;
+    const double row_begin = std::floor((top - window->max.lat.get_degrees()) / cellsize) - 1.0;
+    const double row_end = std::ceil((top - window->min.lat.get_degrees()) / cellsize) + 1.0;
+    if (col_end < 0.0 || row_end < 0.0 || col_begin > ncols - 1 || row_begin > nrows - 1)
+        return result;
+
+    result.col = static_cast<int>(std::max(0.0, col_begin));
+    result.row = static_cast<int>(std::max(0.0, row_begin));
+    result.cols = static_cast<int>(std::min<double>(ncols - 1, col_end)) - result.col + 1;
+    result.rows = static_cast<int>(std::min<double>(nrows - 1, row_end)) - result.row + 1;
+    return result;
+}
+
+namespace {
+    bool host_is_big_endian() {
+        const uint16_t probe = 1;
+        uint8_t first;
+        std::memcpy(&first, &probe, 1);
+        return first == 0;
+    }
+
+    template <typename T>
+    T load(const uint8_t* p, bool swap) {
+        uint8_t bytes[sizeof(T)];
+        if (swap) {
+            for (size_t i = 0; i < sizeof(T); i++)
+                bytes[i] = p[sizeof(T) - 1 - i];
+        } else {
+            std::memcpy(bytes, p, sizeof(T));
+        }
+        T value;
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    /* Converts count samples, stride bytes apart, to float. NaN (float rasters) becomes nodata. */
+    template <typename T>
+    void convert_samples(const uint8_t* src, size_t stride, bool swap, int count, float nodata, float* dst) {
+        for (int i = 0; i < count; i++) {
+            const float value = static_cast<float>(load<T>(src + i * stride, swap));
+            dst[i] = value == value ? value : nodata;
+        }
+    }
+
+    Ref<ElevationGrid> make_grid(const GeoCoords& top_left, double cellsize, double nodata_value, const RasterWindow& window, std::vector<float>&& raster) {
+        Ref<ElevationGrid> grid = memnew(ElevationGrid);
+        grid->setNcols(window.cols);
+        grid->setNrows(window.rows);
+        grid->setCellsize(cellsize);
+        grid->setNodataValue(nodata_value);
+        grid->setTopLeftGeo(top_left + GeoCoords(Longitude::degrees(window.col * cellsize), Latitude::degrees(-window.row * cellsize)));
+        grid->setRaster(std::move(raster), window.cols);
+        return grid;
+    }
+
+    /* Parses the south west corner from an SRTM file name such as N50E019 or s12w077. */
+    bool parse_hgt_name(const String& filename, GeoCoords& south_west) {
+        const String name = filename.get_file().get_basename().to_upper();
+        if (name.length() < 7)
+            return false;
+        const char32_t ns = name[0], ew = name[3];
+        const String lat = name.substr(1, 2), lon = name.substr(4, 3);
+        if ((ns != 'N' && ns != 'S') || (ew != 'E' && ew != 'W') || !lat.is_valid_int() || !lon.is_valid_int())
+            return false;
+        south_west = GeoCoords(Longitude::degrees((ew == 'W' ? -1.0 : 1.0) * lon.to_int()),
+                               Latitude::degrees((ns == 'S' ? -1.0 : 1.0) * lat.to_int()));
+        return true;
+    }
+
+    /* Minimal reader of the first image file directory of a classic (not Big) TIFF. */
+    class TiffDirectory {
+    public:
+        struct Entry {
+            uint16_t type = 0;
+            uint32_t count = 0;
+            size_t offset = 0; // of the first value in the file
+        };
+
+        bool parse(const uint8_t* file_data, size_t file_size) {
+            data = file_data;
+            size = file_size;
+            if (size < 8)
+                return false;
+            if (data[0] == 'I' && data[1] == 'I')
+                swap = host_is_big_endian();
+            else if (data[0] == 'M' && data[1] == 'M')
+                swap = !host_is_big_endian();
+            else
+                return false;
+            if (load<uint16_t>(data + 2, swap) != 42)
+                return false;
+
+            const size_t ifd = load<uint32_t>(data + 4, swap);
+            if (ifd + 2 > size)
+                return false;
+            const uint16_t entry_count = load<uint16_t>(data + ifd, swap);
+            if (ifd + 2 + entry_count * 12ull > size)
+                return false;
+
+            for (uint16_t i = 0; i < entry_count; i++) {
+                const uint8_t* p = data + ifd + 2 + i * 12;
+                Entry entry;
+                entry.type = load<uint16_t>(p + 2, swap);
+                entry.count = load<uint32_t>(p + 4, swap);
+                const size_t bytes = type_size(entry.type) * static_cast<size_t>(entry.count);
+                entry.offset = bytes <= 4 ? static_cast<size_t>(p + 8 - data) : load<uint32_t>(p + 8, swap);
+                if (type_size(entry.type) == 0 || entry.offset + bytes > size)
+                    continue;
+                entries.emplace_back(load<uint16_t>(p, swap), entry);
+            }
+            return true;
+        }
+
+        const Entry* find(uint16_t tag) const {
+            for (const auto& entry : entries)
+                if (entry.first == tag)
+                    return &entry.second;
+            return nullptr;
+        }
+
+        double number(uint16_t tag, uint32_t index, double fallback) const {
+            const Entry* entry = find(tag);
+            if (entry == nullptr || index >= entry->count)
+                return fallback;
+            const uint8_t* p = data + entry->offset + index * type_size(entry->type);
+            switch (entry->type) {
+                case 1: return p[0];
+                case 3: return load<uint16_t>(p, swap);
+                case 4: return load<uint32_t>(p, swap);
+                case 6: return static_cast<int8_t>(p[0]);
+                case 8: return load<int16_t>(p, swap);
+                case 9: return load<int32_t>(p, swap);
+                case 11: return load<float>(p, swap);
+                case 12: return load<double>(p, swap);
+                default: return fallback;
+            }
+        }
+
+        String text(uint16_t tag) const {
+            const Entry* entry = find(tag);
+            if (entry == nullptr || entry->type != 2)
+                return String();
+            const char* chars = reinterpret_cast<const char*>(data + entry->offset);
+            return String(std::string(chars, strnlen(chars, entry->count)).c_str());
+        }
+
+        /* Value of a key in the GeoKeyDirectoryTag, or fallback. Only keys stored inline are supported. */
+        int geo_key(uint16_t key, int fallback) const {
+            const Entry* entry = find(34735);
+            if (entry == nullptr)
+                return fallback;
+            const uint32_t key_count = static_cast<uint32_t>(number(34735, 3, 0));
+            for (uint32_t i = 1; i <= key_count && i * 4 + 3 < entry->count; i++) {
+                if (number(34735, i * 4, 0) == key && number(34735, i * 4 + 1, -1) == 0)
+                    return static_cast<int>(number(34735, i * 4 + 3, fallback));
+            }
+            return fallback;
+        }
+
+        bool needs_swap() const {
+            return swap;
+        }
+
+    private:
+        static size_t type_size(uint16_t type) {
+            switch (type) {
+                case 1: case 2: case 6: case 7: return 1;
+                case 3: case 8: return 2;
+                case 4: case 9: case 11: return 4;
+                case 5: case 10: case 12: return 8;
+                default: return 0;
+            }
+        }
+
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        bool swap = false;
+        std::vector<std::pair<uint16_t, Entry>> entries;
+    };
+
+    enum TiffTag : uint16_t {
+        IMAGE_WIDTH = 256,
+        IMAGE_LENGTH = 257,
+        BITS_PER_SAMPLE = 258,
+        COMPRESSION = 259,
+        STRIP_OFFSETS = 273,
+        SAMPLES_PER_PIXEL = 277,
+        ROWS_PER_STRIP = 278,
+        PLANAR_CONFIGURATION = 284,
+        TILE_WIDTH = 322,
+        SAMPLE_FORMAT = 339,
+        MODEL_PIXEL_SCALE = 33550,
+        MODEL_TIEPOINT = 33922,
+        MODEL_TRANSFORMATION = 34264,
+        GDAL_NODATA = 42113,
+    };
+
+    enum GeoKey : uint16_t {
+        GT_MODEL_TYPE = 1024,
+        GT_RASTER_TYPE = 1025,
+    };
+
+    struct TiffLayout {
+        int width = 0;
+        int height = 0;
+        int bits = 0;
+        int sample_format = 1;
+        int samples_per_pixel = 1;
+        bool planar = false;
+        int rows_per_strip = 0;
+        double cellsize = 0.0;
+        /* Position of the first sample. */
+        GeoCoords top_left;
+    };
+
+    /* Reads and validates the image layout and georeferencing, warning about what we cannot load. */
+    bool read_tiff_layout(const TiffDirectory& dir, const String& filename, TiffLayout& layout) {
+        layout.width = static_cast<int>(dir.number(IMAGE_WIDTH, 0, 0));
+        layout.height = static_cast<int>(dir.number(IMAGE_LENGTH, 0, 0));
+        layout.bits = static_cast<int>(dir.number(BITS_PER_SAMPLE, 0, 1));
+        layout.sample_format = static_cast<int>(dir.number(SAMPLE_FORMAT, 0, 1));
+        layout.samples_per_pixel = static_cast<int>(dir.number(SAMPLES_PER_PIXEL, 0, 1));
+        layout.planar = dir.number(PLANAR_CONFIGURATION, 0, 1) == 2;
+        layout.rows_per_strip = static_cast<int>(std::min<double>(layout.height, dir.number(ROWS_PER_STRIP, 0, layout.height)));
+
+        if (dir.number(COMPRESSION, 0, 1) != 1 || dir.find(TILE_WIDTH) != nullptr) {
+            WARN_PRINT("GeoTIFF " + filename + " is compressed or tiled; only uncompressed striped files are supported.");
+            return false;
+        }
+        if (layout.width <= 0 || layout.height <= 0 || layout.rows_per_strip <= 0 || layout.bits % 8 != 0 || dir.find(STRIP_OFFSETS) == nullptr) {
+            WARN_PRINT("GeoTIFF " + filename + " has an invalid image directory.");
+            return false;
+        }
+        if (dir.geo_key(GT_MODEL_TYPE, 2) != 2) {
+            WARN_PRINT("GeoTIFF " + filename + " is not in geographic coordinates; reproject it to longitude/latitude first.");
+            return false;
+        }
+
+        // Georeferencing: pixel scale and tie point, or an affine transformation without rotation.
+        double scale_x, scale_y, origin_x, origin_y;
+        if (dir.find(MODEL_PIXEL_SCALE) && dir.find(MODEL_TIEPOINT)) {
+            scale_x = dir.number(MODEL_PIXEL_SCALE, 0, 0);
+            scale_y = dir.number(MODEL_PIXEL_SCALE, 1, 0);
+            origin_x = dir.number(MODEL_TIEPOINT, 3, 0) - dir.number(MODEL_TIEPOINT, 0, 0) * scale_x;
+            origin_y = dir.number(MODEL_TIEPOINT, 4, 0) + dir.number(MODEL_TIEPOINT, 1, 0) * scale_y;
+        } else if (dir.find(MODEL_TRANSFORMATION)) {
+            scale_x = dir.number(MODEL_TRANSFORMATION, 0, 0);
+            scale_y = -dir.number(MODEL_TRANSFORMATION, 5, 0);
+            origin_x = dir.number(MODEL_TRANSFORMATION, 3, 0);
+            origin_y = dir.number(MODEL_TRANSFORMATION, 7, 0);
+        } else {
+            WARN_PRINT("GeoTIFF " + filename + " has no georeferencing tags.");
+            return false;
+        }
+        if (scale_x <= 0.0 || scale_y <= 0.0) {
+            WARN_PRINT("GeoTIFF " + filename + " has an unsupported pixel scale.");
+            return false;
+        }
+        if (std::abs(scale_x - scale_y) > 1e-9 * scale_x)
+            WARN_PRINT("GeoTIFF " + filename + " has non-square pixels; using the horizontal pixel size.");
+
+        // topLeftGeo is a sample centre (see ElevationGrid::setTopLeftGeo), so PixelIsArea rasters move half a cell inwards.
+        const bool pixel_is_area = dir.geo_key(GT_RASTER_TYPE, 1) == 1;
+        layout.cellsize = scale_x;
+        layout.top_left = GeoCoords(Longitude::degrees(origin_x + (pixel_is_area ? 0.5 * scale_x : 0.0)),
+                                    Latitude::degrees(origin_y - (pixel_is_area ? 0.5 * scale_y : 0.0)));
+        return true;
+    }
+
+    /* Reads the tile position from the name and the sample count from the size of a .hgt file. */
+    bool read_hgt_layout(const String& filename, uint64_t file_size, GeoCoords& top_left, int& samples) {
+        GeoCoords south_west;
+        if (!parse_hgt_name(filename, south_west)) {
+            WARN_PRINT("Cannot tell the position of SRTM tile " + filename + " from its name (expected e.g. N50E019.hgt).");
+            return false;
+        }
+        // Square tiles of big endian int16; the edge rows and columns are shared with the neighbours.
+        samples = static_cast<int>(std::lround(std::sqrt(file_size / 2.0)));
+        if (samples < 2 || static_cast<uint64_t>(samples) * samples * 2 != file_size) {
+            WARN_PRINT("SRTM tile " + filename + " has an unexpected size of " + String::num_uint64(file_size) + " bytes.");
+            return false;
+        }
+        top_left = south_west + GeoCoords(Longitude::zero(), Latitude::degrees(1.0));
+        return true;
+    }
+}
+
+Ref<ElevationGrid> loadHGT(const String& filename, const DEMWindow* window) {
+    FileBytes file;
+    if (!file.open(filename, MappedFile::RANDOM)) {
+        WARN_PRINT("Could not open file " + filename);
+        return Ref<ElevationGrid>(memnew(ElevationGrid));
+    }
+
+    GeoCoords top_left;
+    int samples = 0;
+    if (!read_hgt_layout(filename, file.size(), top_left, samples))
+        return Ref<ElevationGrid>(memnew(ElevationGrid));
+    const double cellsize = 1.0 / (samples - 1);
+    const double nodata_value = -32768.0;
+
+    const RasterWindow w = RasterWindow::covering(top_left, cellsize, samples, samples, window);
+    std::vector<float> raster(static_cast<size_t>(w.rows) * w.cols);
+    const uint8_t* data = file.data();
+    const bool swap = !host_is_big_endian();
+    parallel_for(w.rows, [&](size_t r, size_t) {
+        const uint8_t* src = data + ((w.row + r) * samples + w.col) * 2;
+        convert_samples<int16_t>(src, 2, swap, w.cols, static_cast<float>(nodata_value), raster.data() + r * w.cols);
+    }, 64);
+
+    return make_grid(top_left, cellsize, nodata_value, w, std::move(raster));
+}
+
+Ref<ElevationGrid> loadGeoTIFF(const String& filename, const DEMWindow* window) {
+    FileBytes file;
+    if (!file.open(filename, MappedFile::RANDOM)) {
+        WARN_PRINT("Could not open file " + filename);
+        return Ref<ElevationGrid>(memnew(ElevationGrid));
+    }
+
+    TiffDirectory dir;
+    if (!dir.parse(file.data(), file.size())) {
+        WARN_PRINT(filename + " is not a classic TIFF file (BigTIFF is not supported).");
+        return Ref<ElevationGrid>(memnew(ElevationGrid));
+    }
+
+    TiffLayout layout;
+    if (!read_tiff_layout(dir, filename, layout))
+        return Ref<ElevationGrid>(memnew(ElevationGrid));
+    const int width = layout.width, height = layout.height, bits = layout.bits, sample_format = layout.sample_format;
+    const int rows_per_strip = layout.rows_per_strip;
+
+    const String nodata_text = dir.text(GDAL_NODATA).strip_edges();
+    const double nodata_value = nodata_text.is_valid_float() ? nodata_text.to_float() : -9999.0;
+    const float nodata = static_cast<float>(nodata_value);
+
+    using Converter = void (*)(const uint8_t*, size_t, bool, int, float, float*);
+    Converter convert = nullptr;
+    switch (sample_format * 100 + bits) {
+        case 108: convert = convert_samples<uint8_t>; break;
+        case 116: convert = convert_samples<uint16_t>; break;
+        case 132: convert = convert_samples<uint32_t>; break;
+        case 208: convert = convert_samples<int8_t>; break;
+        case 216: convert = convert_samples<int16_t>; break;
+        case 232: convert = convert_samples<int32_t>; break;
+        case 332: convert = convert_samples<float>; break;
+        case 364: convert = convert_samples<double>; break;
+    }
+    if (convert == nullptr) {
+        WARN_PRINT("GeoTIFF " + filename + " has an unsupported sample type (format " + String::num_int64(sample_format) + ", " + String::num_int64(bits) + " bits).");
+        return Ref<ElevationGrid>(memnew(ElevationGrid));
+    }
+
+    // With separate planes the first strips hold the first sample of every pixel.
+    const size_t sample_bytes = bits / 8;
+    const size_t pixel_bytes = layout.planar ? sample_bytes : sample_bytes * layout.samples_per_pixel;
+    const size_t strip_count = (static_cast<size_t>(height) + rows_per_strip - 1) / rows_per_strip;
+    if (dir.find(STRIP_OFFSETS)->count < strip_count) {
+        WARN_PRINT("GeoTIFF " + filename + " has fewer strips than rows need.");
+        return Ref<ElevationGrid>(memnew(ElevationGrid));
+    }
+    std::vector<size_t> strip_offsets(strip_count);
+    for (size_t i = 0; i < strip_count; i++)
+        strip_offsets[i] = static_cast<size_t>(dir.number(STRIP_OFFSETS, static_cast<uint32_t>(i), 0));
+
+    const RasterWindow w = RasterWindow::covering(layout.top_left, layout.cellsize, height, width, window);
+    std::vector<float> raster(static_cast<size_t>(w.rows) * w.cols, nodata);
+    const uint8_t* data = file.data();
+    const size_t size = file.size();
+    const bool swap = dir.needs_swap();
+    std::atomic<bool> truncated(false);
+    parallel_for(w.rows, [&](size_t r, size_t) {
+        const size_t row = w.row + r;
+        const size_t offset = strip_offsets[row / rows_per_strip] + ((row % rows_per_strip) * width + w.col) * pixel_bytes;
+        if (offset + (w.cols - 1) * pixel_bytes + sample_bytes > size) {
+            truncated = true;
+            return;
+        }
+        convert(data + offset, pixel_bytes, swap, w.cols, nodata, raster.data() + r * w.cols);
+    }, 64);
+    if (truncated)
+        WARN_PRINT("GeoTIFF " + filename + " is truncated; missing rows are filled with NODATA.");
+
+    return make_grid(layout.top_left, layout.cellsize, nodata_value, w, std::move(raster));
+}
+
+bool probeHGT(const String& filename, DEMInfo& info) {
+    // The size is all we need from the file, so do not map it.
+    Ref<FileAccess> file = FileAccess::open(filename, FileAccess::READ);
+    if (file.is_null() || !file->is_open())
+        return false;
+
+    GeoCoords top_left;
+    int samples = 0;
+    if (!read_hgt_layout(filename, file->get_length(), top_left, samples))
+        return false;
+    info = DEMInfo::from_grid(top_left, 1.0 / (samples - 1), samples, samples);
+    return true;
+}
+
+bool probeGeoTIFF(const String& filename, DEMInfo& info) {
+    FileBytes file;
+    TiffDirectory dir;
+    TiffLayout layout;
+    if (!file.open(filename, MappedFile::RANDOM) || !dir.parse(file.data(), file.size()) || !read_tiff_layout(dir, filename, layout))
+        return false;
+    info = DEMInfo::from_grid(layout.top_left, layout.cellsize, layout.height, layout.width);
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef BINARY_DEM_H
+#define BINARY_DEM_H
+#include "ElevationParser.h"
+#include <godot_cpp/variant/string.hpp>
+
+/**
+ * Rows and columns of a raster covering a window, with a one cell margin so bilinear
+ * sampling at the window edges still has both neighbours. Empty if the window misses the raster.
+ */
+struct RasterWindow {
+    int row = 0;
+    int col = 0;
+    int rows = 0;
+    int cols = 0;
+
+    /**
+     * @param top_left Geo coordinates of the first sample.
+     * @param cellsize Cell size in degrees.
+     * @param window Window to cover, or null for the whole raster.
+     */
+    static RasterWindow covering(const GeoCoords& top_left, double cellsize, int nrows, int ncols, const DEMWindow* window);
+};
+
+/**
+ * Loads an SRTM .hgt tile (big endian int16, 1201x1201 or 3601x3601 samples). The tile position
+ * comes from the file name (e.g. N50E019.hgt). The file is memory-mapped and only the rows of
+ * the window are read.
+ * @param window Region to load, or null for the whole tile.
+ */
+godot::Ref<ElevationGrid> loadHGT(const godot::String& filename, const DEMWindow* window = nullptr);
+
+/**
+ * Loads a baseline GeoTIFF: uncompressed, striped, geographic coordinates, 8 to 64 bit integer or
+ * float samples (the first sample of each pixel is used). The file is memory-mapped and only the
+ * window is read.
+ * @param window Region to load, or null for the whole raster.
+ */
+godot::Ref<ElevationGrid> loadGeoTIFF(const godot::String& filename, const DEMWindow* window = nullptr);
+
+/* Read only the georeferencing of a .hgt or GeoTIFF file (see probeDEM). */
+bool probeHGT(const godot::String& filename, DEMInfo& info);
+bool probeGeoTIFF(const godot::String& filename, DEMInfo& info);
+
+#endif // BINARY_DEM_H
@@ -0,0 +1,224 @@
+#include "ElevationCache.h"
+#include "HeightPyramid.h"
+#include "SurfaceMaps.h"
+#include "../../util/MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+
+using namespace godot;
+
+namespace {
+    // 2: topLeftGeo of ASCII grids is the centre of the first sample, not the corner of its cell.
+    const uint32_t SGDEM_VERSION = 2;
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    const size_t SECTION_ALIGNMENT = 64;
+
+    enum SectionId : uint32_t {
+        SECTION_RASTER = 1,
+        SECTION_PYRAMID = 2,
+        SECTION_SURFACE = 3,
+    };
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t section_count;
+        uint64_t source_size;
+        uint64_t source_mtime;
+        uint32_t has_window;
+        uint32_t pyramid_block;
+        double window[4]; // min lon, min lat, max lon, max lat in radians
+        int32_t ncols;
+        int32_t nrows;
+        double cellsize;
+        double top_left[2]; // lon, lat in radians
+        double nodata_value;
+    };
+
+    struct Section {
+        uint32_t id;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    size_t align(size_t offset) {
+        return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+
+    /* Header fields identifying the source and how it was read. @return false if the source is missing. */
+    bool make_key(const String& filename, const DEMWindow* window, Header& header) {
+        Ref<FileAccess> source = FileAccess::open(filename, FileAccess::READ);
+        if (source.is_null() || !source->is_open())
+            return false;
+
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "SGDM", 4);
+        header.version = SGDEM_VERSION;
+        header.byte_order = BYTE_ORDER_MARK;
+        header.source_size = source->get_length();
+        header.source_mtime = FileAccess::get_modified_time(filename);
+        header.pyramid_block = HeightPyramid::BLOCK;
+        if (window != nullptr) {
+            header.has_window = 1;
+            header.window[0] = window->min.lon.get_radians();
+            header.window[1] = window->min.lat.get_radians();
+            header.window[2] = window->max.lon.get_radians();
+            header.window[3] = window->max.lat.get_radians();
+        }
+        return true;
+    }
+
+    bool same_key(const Header& a, const Header& b) {
+        return std::memcmp(a.magic, b.magic, 4) == 0 && a.version == b.version && a.byte_order == b.byte_order &&
+               a.source_size == b.source_size && a.source_mtime == b.source_mtime && a.pyramid_block == b.pyramid_block &&
+               a.has_window == b.has_window && std::memcmp(a.window, b.window, sizeof(a.window)) == 0;
+    }
+
+    void store_bytes(const Ref<FileAccess>& file, const void* data, size_t size) {
+        // store_buffer takes a PackedByteArray, so large arrays go through it in pieces.
+        const size_t CHUNK = 4 << 20;
+        PackedByteArray bytes;
+        for (size_t offset = 0; offset < size; offset += CHUNK) {
+            const size_t n = std::min(CHUNK, size - offset);
+            bytes.resize(n);
+            std::memcpy(bytes.ptrw(), static_cast<const uint8_t*>(data) + offset, n);
+            file->store_buffer(bytes);
+        }
+    }
+
+    void store_padding(const Ref<FileAccess>& file, size_t from, size_t to) {
+        const uint8_t zeros[SECTION_ALIGNMENT] = {};
+        if (to > from)
+            store_bytes(file, zeros, to - from);
+    }
+}
+
+String elevationCachePath(const String& filename) {
+    return filename + ".sgdem";
+}
+
+Ref<ElevationGrid> readElevationCache(const String& filename, const DEMWindow* window) {
+    const String path = elevationCachePath(filename);
+    Header expected;
+    if (!FileAccess::file_exists(path) || !make_key(filename, window, expected))
+        return Ref<ElevationGrid>();
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(MappedFile::native_path(path), MappedFile::RANDOM) || file->size() < sizeof(Header))
+        return Ref<ElevationGrid>();
+
+    Header header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (!same_key(header, expected) || header.ncols <= 0 || header.nrows <= 0)
+        return Ref<ElevationGrid>();
+    if (sizeof(Header) + static_cast<size_t>(header.section_count) * sizeof(Section) > file->size())
+        return Ref<ElevationGrid>();
+
+    const size_t raster_size = static_cast<size_t>(header.ncols) * header.nrows * sizeof(float);
+    const size_t pyramid_size = HeightPyramid::storage_size(header.nrows, header.ncols) * sizeof(float);
+    const size_t surface_size = SurfaceMaps::storage_size(header.nrows, header.ncols) * sizeof(float);
+    const float* raster = nullptr;
+    const float* pyramid = nullptr;
+    const float* surface = nullptr;
+    for (uint32_t i = 0; i < header.section_count; i++) {
+        Section section;
+        std::memcpy(&section, file->data() + sizeof(Header) + i * sizeof(Section), sizeof(section));
+        if (section.offset % SECTION_ALIGNMENT != 0 || section.offset + section.size > file->size())
+            return Ref<ElevationGrid>();
+        const float* values = reinterpret_cast<const float*>(file->data() + section.offset);
+        if (section.id == SECTION_RASTER && section.size == raster_size)
+            raster = values;
+        else if (section.id == SECTION_PYRAMID && section.size == pyramid_size)
+            pyramid = values;
+        else if (section.id == SECTION_SURFACE && section.size == surface_size)
+            surface = values;
+    }
+    if (raster == nullptr || pyramid == nullptr)
+        return Ref<ElevationGrid>();
+
+    Ref<ElevationGrid> grid = memnew(ElevationGrid);
+    grid->setNcols(header.ncols);
+    grid->setNrows(header.nrows);
+    grid->setCellsize(header.cellsize);
+    grid->setNodataValue(header.nodata_value);
+    grid->setTopLeftGeo(GeoCoords(Longitude::radians(header.top_left[0]), Latitude::radians(header.top_left[1])));
+    grid->setMappedRaster(std::move(file), raster, header.ncols, pyramid, surface);
+    return grid;
+}
+
+bool writeElevationCache(const String& filename, const DEMWindow* window, const ElevationGrid& grid) {
+    Header header;
+    if (grid.getRasterData() == nullptr || grid.getStride() != grid.getNcols() || !make_key(filename, window, header))
+        return false;
+
+    // Write next to the cache and rename, so grids still mapping an outdated cache keep their data.
+    const String path = elevationCachePath(filename);
+    const String temporary_path = path + ".tmp";
+    Ref<FileAccess> file = FileAccess::open(temporary_path, FileAccess::WRITE);
+    if (file.is_null() || !file->is_open()) {
+        WARN_PRINT("Could not write elevation cache " + path);
+        return false;
+    }
+
+    const size_t raster_size = static_cast<size_t>(grid.getNcols()) * grid.getNrows() * sizeof(float);
+    const size_t pyramid_size = HeightPyramid::storage_size(grid.getNrows(), grid.getNcols()) * sizeof(float);
+    const SurfaceMaps& surface = grid.getSurfaceMaps();
+    const size_t surface_size = SurfaceMaps::storage_size(grid.getNrows(), grid.getNcols()) * sizeof(float);
+
+    Section sections[3] = {};
+    sections[0].id = SECTION_RASTER;
+    sections[0].offset = align(sizeof(Header) + sizeof(sections));
+    sections[0].size = raster_size;
+    sections[1].id = SECTION_PYRAMID;
+    sections[1].offset = align(sections[0].offset + raster_size);
+    sections[1].size = pyramid_size;
+    sections[2].id = SECTION_SURFACE;
+    sections[2].offset = align(sections[1].offset + pyramid_size);
+    sections[2].size = surface_size;
+
+    header.section_count = 3;
+    header.ncols = grid.getNcols();
+    header.nrows = grid.getNrows();
+    header.cellsize = grid.getCellsize();
+    header.top_left[0] = grid.getTopLeftGeo().lon.get_radians();
+    header.top_left[1] = grid.getTopLeftGeo().lat.get_radians();
+    header.nodata_value = grid.getNodataValue();
+
+    store_bytes(file, &header, sizeof(header));
+    store_bytes(file, sections, sizeof(sections));
+    size_t position = sizeof(header) + sizeof(sections);
+    store_padding(file, position, sections[0].offset);
+    store_bytes(file, grid.getRasterData(), raster_size);
+    position = sections[0].offset + raster_size;
+    store_padding(file, position, sections[1].offset);
+    store_bytes(file, grid.getPyramid().data(), pyramid_size);
+    position = sections[1].offset + pyramid_size;
+    store_padding(file, position, sections[2].offset);
+    store_bytes(file, surface.data(), surface_size);
+    file->close();
+
+    if (DirAccess::rename_absolute(temporary_path, path) != OK) {
+        WARN_PRINT("Could not replace elevation cache " + path);
+        DirAccess::remove_absolute(temporary_path);
+        return false;
+    }
+    return true;
+}
+
+Ref<ElevationGrid> loadCachedDEM(const String& filename, const DEMWindow* window) {
+    Ref<ElevationGrid> grid = readElevationCache(filename, window);
+    if (grid.is_valid())
+        return grid;
+
+    grid = loadDEM(filename, window);
+    if (grid->getRasterData() != nullptr)
+        writeElevationCache(filename, window, *grid.ptr());
+    return grid;
+}
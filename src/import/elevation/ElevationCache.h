@@ -0,0 +1,34 @@
+#ifndef ELEVATION_CACHE_H
+#define ELEVATION_CACHE_H
+#include "ElevationParser.h"
+#include <godot_cpp/variant/string.hpp>
+
+/**
+ * .sgdem: binary cache written next to a DEM file (<source>.sgdem) on its first load.
+ *
+ * Layout (native byte order, recorded in the header):
+ *   header     magic "SGDM", version, byte order mark, source size and modification time,
+ *              window the raster was read for, ncols, nrows, cellsize, top left (radians), NODATA
+ *   sections   id, offset and size of each section
+ *   RASTER     ncols * nrows float32, row by row from the top
+ *   PYRAMID    HeightPyramid storage
+ *   SURFACE    SurfaceMaps storage (normals, slopes, curvatures); optional, computed on demand if missing
+ * Sections start at 64 byte boundaries so they can be used in place from a mapping.
+ */
+
+/* Path of the cache of a DEM file. */
+godot::String elevationCachePath(const godot::String& filename);
+
+/**
+ * Maps the cache of filename if it matches the source file and window.
+ * @return The grid, or a null Ref if there is no valid cache.
+ */
+godot::Ref<ElevationGrid> readElevationCache(const godot::String& filename, const DEMWindow* window);
+
+/* Writes the cache of filename. @return Whether it was written. */
+bool writeElevationCache(const godot::String& filename, const DEMWindow* window, const ElevationGrid& grid);
+
+/* loadDEM through the .sgdem cache: maps a valid cache, otherwise loads the source and writes one. */
+godot::Ref<ElevationGrid> loadCachedDEM(const godot::String& filename, const DEMWindow* window = nullptr);
+
+#endif // ELEVATION_CACHE_H
@@ -0,0 +1,198 @@
+#include "ElevationMosaic.h"
+#include "ElevationCache.h"
+#include <algorithm>
+#include <cmath>
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+
+using namespace godot;
+
+int ElevationMosaic::scan_directory(const String& directory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    tiles.clear();
+    buckets.clear();
+    lru.clear();
+    loaded_bytes = 0;
+
+    const PackedStringArray files = DirAccess::get_files_at(directory);
+    for (int64_t i = 0; i < files.size(); i++) {
+        Tile tile;
+        tile.filename = directory.path_join(files[i]);
+        if (probeDEM(tile.filename, tile.info))
+            tiles.push_back(tile);
+    }
+
+    for (uint32_t i = 0; i < tiles.size(); i++) {
+        const DEMWindow& bounds = tiles[i].info.bounds;
+        const int64_t lon_begin = static_cast<int64_t>(std::floor(bounds.min.lon.get_degrees()));
+        const int64_t lon_end = static_cast<int64_t>(std::floor(bounds.max.lon.get_degrees()));
+        const int64_t lat_begin = static_cast<int64_t>(std::floor(bounds.min.lat.get_degrees()));
+        const int64_t lat_end = static_cast<int64_t>(std::floor(bounds.max.lat.get_degrees()));
+        for (int64_t lon = lon_begin; lon <= lon_end; lon++)
+            for (int64_t lat = lat_begin; lat <= lat_end; lat++)
+                buckets[bucket_key(lon, lat)].push_back(i);
+    }
+    // Where tiles overlap, the finest one wins.
+    for (auto& bucket : buckets) {
+        std::stable_sort(bucket.second.begin(), bucket.second.end(), [this](uint32_t a, uint32_t b) {
+            return tiles[a].info.cellsize < tiles[b].info.cellsize;
+        });
+    }
+
+    if (tiles.empty())
+        WARN_PRINT("No DEM files (.hgt, .tif, .asc) found in " + directory);
+    return static_cast<int>(tiles.size());
+}
+
+int64_t ElevationMosaic::find_tile(const GeoCoords& coords) const {
+    const int64_t lon = static_cast<int64_t>(std::floor(coords.lon.get_degrees()));
+    const int64_t lat = static_cast<int64_t>(std::floor(coords.lat.get_degrees()));
+    const auto bucket = buckets.find(bucket_key(lon, lat));
+    if (bucket == buckets.end())
+        return -1;
+    for (uint32_t tile : bucket->second)
+        if (tiles[tile].info.bounds.contains(coords))
+            return tile;
+    return -1;
+}
+
+Ref<ElevationGrid> ElevationMosaic::acquire(uint32_t index) const {
+    const Tile& tile = tiles[index];
+    if (tile.grid.is_valid()) {
+        lru.splice(lru.begin(), lru, tile.lru_position);
+        return tile.grid;
+    }
+
+    // Loading under the lock keeps two threads from reading the same tile; later samples of it are cheap.
+    tile.grid = use_cache ? loadCachedDEM(tile.filename) : loadDEM(tile.filename);
+    tile.bytes = static_cast<size_t>(std::max(0, tile.grid->getNcols())) * static_cast<size_t>(std::max(0, tile.grid->getNrows())) * sizeof(float);
+    lru.push_front(index);
+    tile.lru_position = lru.begin();
+    loaded_bytes += tile.bytes;
+    evict_to_limit(index);
+    return tile.grid;
+}
+
+void ElevationMosaic::evict_to_limit(uint32_t keep) const {
+    const size_t limit = static_cast<size_t>(std::max<int64_t>(0, memory_limit_mb)) << 20;
+    while (loaded_bytes > limit && !lru.empty() && lru.back() != keep) {
+        const Tile& tile = tiles[lru.back()];
+        // Samplers still holding the Ref keep the raster alive until they are done.
+        tile.grid.unref();
+        loaded_bytes -= tile.bytes;
+        tile.bytes = 0;
+        lru.pop_back();
+    }
+}
+
+double ElevationMosaic::getElevation(const GeoCoords& coords) const {
+    const int64_t tile = find_tile(coords);
+    if (tile < 0)
+        return 0.0;
+
+    Ref<ElevationGrid> grid;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        grid = acquire(static_cast<uint32_t>(tile));
+    }
+    return grid->bilinearInterpolation(coords);
+}
+
+void ElevationMosaic::getElevations(const double* lon, const double* lat, size_t count, double* out) const {
+    std::vector<int64_t> tile_of(count);
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        tile_of[i] = find_tile(GeoCoords(Longitude::radians(lon[i]), Latitude::radians(lat[i])));
+        if (tile_of[i] < 0)
+            out[i] = 0.0;
+        else
+            order.push_back(static_cast<uint32_t>(i));
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return tile_of[a] < tile_of[b];
+    });
+
+    std::vector<double> tile_lon, tile_lat, tile_out;
+    for (size_t begin = 0; begin < order.size();) {
+        const int64_t tile = tile_of[order[begin]];
+        size_t end = begin;
+        tile_lon.clear();
+        tile_lat.clear();
+        while (end < order.size() && tile_of[order[end]] == tile) {
+            tile_lon.push_back(lon[order[end]]);
+            tile_lat.push_back(lat[order[end]]);
+            end++;
+        }
+
+        Ref<ElevationGrid> grid;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            grid = acquire(static_cast<uint32_t>(tile));
+        }
+        tile_out.resize(tile_lon.size());
+        grid->sampleBatch(tile_lon.data(), tile_lat.data(), tile_lon.size(), tile_out.data());
+        for (size_t k = begin; k < end; k++)
+            out[order[k]] = tile_out[k - begin];
+        begin = end;
+    }
+}
+
+bool ElevationMosaic::getBounds(DEMWindow& bounds) const {
+    if (tiles.empty())
+        return false;
+    bounds = tiles[0].info.bounds;
+    for (const Tile& tile : tiles) {
+        bounds.min.lon.value = std::min(bounds.min.lon.value, tile.info.bounds.min.lon.value);
+        bounds.min.lat.value = std::min(bounds.min.lat.value, tile.info.bounds.min.lat.value);
+        bounds.max.lon.value = std::max(bounds.max.lon.value, tile.info.bounds.max.lon.value);
+        bounds.max.lat.value = std::max(bounds.max.lat.value, tile.info.bounds.max.lat.value);
+    }
+    return true;
+}
+
+Vector2 ElevationMosaic::get_min_geo() const {
+    DEMWindow bounds;
+    return getBounds(bounds) ? bounds.min.to_vector2_representation() : Vector2();
+}
+
+Vector2 ElevationMosaic::get_max_geo() const {
+    DEMWindow bounds;
+    return getBounds(bounds) ? bounds.max.to_vector2_representation() : Vector2();
+}
+
+void ElevationMosaic::set_memory_limit_mb(int64_t value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    memory_limit_mb = value;
+    if (!lru.empty())
+        evict_to_limit(lru.front());
+}
+
+int ElevationMosaic::get_loaded_tile_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(lru.size());
+}
+
+int64_t ElevationMosaic::get_loaded_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int64_t>(loaded_bytes);
+}
+
+void ElevationMosaic::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("scan_directory", "directory"), &ElevationMosaic::scan_directory);
+    ClassDB::bind_method(D_METHOD("get_elevation_vec", "coords"), &ElevationMosaic::get_elevation_vec);
+    ClassDB::bind_method(D_METHOD("get_min_geo"), &ElevationMosaic::get_min_geo);
+    ClassDB::bind_method(D_METHOD("get_max_geo"), &ElevationMosaic::get_max_geo);
+    ClassDB::bind_method(D_METHOD("get_tile_count"), &ElevationMosaic::get_tile_count);
+    ClassDB::bind_method(D_METHOD("get_loaded_tile_count"), &ElevationMosaic::get_loaded_tile_count);
+    ClassDB::bind_method(D_METHOD("get_loaded_bytes"), &ElevationMosaic::get_loaded_bytes);
+
+    ClassDB::bind_method(D_METHOD("set_use_cache", "value"), &ElevationMosaic::set_use_cache);
+    ClassDB::bind_method(D_METHOD("get_use_cache"), &ElevationMosaic::get_use_cache);
+    ClassDB::bind_method(D_METHOD("set_memory_limit_mb", "value"), &ElevationMosaic::set_memory_limit_mb);
+    ClassDB::bind_method(D_METHOD("get_memory_limit_mb"), &ElevationMosaic::get_memory_limit_mb);
+
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_cache"), "set_use_cache", "get_use_cache");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "memory_limit_mb", PROPERTY_HINT_RANGE, "0,65536,1,or_greater,suffix:MB"), "set_memory_limit_mb", "get_memory_limit_mb");
+}
@@ -0,0 +1,94 @@
+#ifndef ELEVATION_MOSAIC_H
+#define ELEVATION_MOSAIC_H
+#include "ElevationParser.h"
+#include "../osm_parser/OSMHeightmap.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Heightmap over a directory of DEM tiles (.hgt, .tif, .asc), for regions too large to load at once.
+ * Scanning only reads the file headers into a bounding box index; a tile's raster is loaded the
+ * first time a point inside it is sampled and kept in an LRU cache limited by memory_limit_mb.
+ * Sampling is thread safe.
+ */
+class ElevationMosaic : public OSMHeightmap {
+    GDCLASS(ElevationMosaic, OSMHeightmap);
+public:
+    /**
+     * Indexes the DEM files of a directory (not recursive), replacing the current index.
+     * @return Number of tiles found.
+     */
+    MAPSHADERS_DLL_SYMBOL int scan_directory(const godot::String& directory);
+
+    /* Elevation at the point, from the finest tile containing it. 0 outside of all tiles. */
+    virtual double getElevation(const GeoCoords&) const override;
+    /* Groups the points by tile, so each tile is looked up once and sampled in one batch. */
+    virtual void getElevations(const double* lon, const double* lat, size_t count, double* out) const override;
+    double get_elevation_vec(const godot::Vector2& coords) {
+        return getElevation(GeoCoords::from_vector2_representation(coords));
+    }
+
+    /* Rectangle covered by all tiles. @return false if there are no tiles. */
+    bool getBounds(DEMWindow& bounds) const;
+    godot::Vector2 get_min_geo() const;
+    godot::Vector2 get_max_geo() const;
+
+    void set_memory_limit_mb(int64_t value);
+    int64_t get_memory_limit_mb() const {
+        return memory_limit_mb;
+    }
+
+    /* Whether tiles are loaded through .sgdem caches (see ElevationCache.h). */
+    void set_use_cache(bool value) {
+        use_cache = value;
+    }
+    bool get_use_cache() const {
+        return use_cache;
+    }
+
+    int get_tile_count() const {
+        return static_cast<int>(tiles.size());
+    }
+    int get_loaded_tile_count() const;
+    int64_t get_loaded_bytes() const;
+
+protected:
+    static void _bind_methods();
+
+private:
+    struct Tile {
+        godot::String filename;
+        DEMInfo info;
+        /* Loaded raster, guarded by the mutex. */
+        mutable godot::Ref<ElevationGrid> grid;
+        mutable size_t bytes = 0;
+        mutable std::list<uint32_t>::iterator lru_position;
+    };
+
+    /* Index of the tile to sample at coords, or -1. Reads only the index, so needs no lock. */
+    int64_t find_tile(const GeoCoords& coords) const;
+    /* Returns the raster of a tile, loading it and evicting others if needed. Call with mutex held. */
+    godot::Ref<ElevationGrid> acquire(uint32_t tile) const;
+    void evict_to_limit(uint32_t keep) const;
+
+    static int64_t bucket_key(int64_t lon_bucket, int64_t lat_bucket) {
+        return (lon_bucket << 32) ^ (lat_bucket & 0xffffffff);
+    }
+
+    std::vector<Tile> tiles;
+    /* One degree buckets, each listing the tiles overlapping it from the finest. */
+    std::unordered_map<int64_t, std::vector<uint32_t>> buckets;
+
+    mutable std::mutex mutex;
+    /* Loaded tiles, most recently used first. */
+    mutable std::list<uint32_t> lru;
+    mutable size_t loaded_bytes = 0;
+
+    int64_t memory_limit_mb = 512;
+    bool use_cache = true;
+};
+
+#endif // ELEVATION_MOSAIC_H
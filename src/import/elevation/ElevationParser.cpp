@@ -1,19 +1,35 @@
 #include "ElevationParser.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
-#include <fstream>
 #include <string>
-#include <sstream>
 #include <godot_cpp/core/error_macros.hpp>
 #include <godot_cpp/classes/file_access.hpp>
 #include <godot_cpp/classes/node.hpp>
+#include "BinaryDEM.h"
+#include "ElevationCache.h"
+#include "ElevationMosaic.h"
+#include "../../util/MappedFile.h"
+#include "../../util/Parallel.h"
 #include "../../util/Util.h"
 
 using namespace godot;
 
-void ElevationGrid::setNcols(int value) { ncols = value; }
+void ElevationGrid::setNcols(int value) {
+    // The raster is read with ncols and stride unchecked, so its size is fixed once it is set.
+    ERR_FAIL_COND_MSG(raster_data != nullptr && value != ncols, "ElevationGrid: ncols cannot change once a raster is set; use set_heightmap.");
+    ncols = value;
+}
 int ElevationGrid::getNcols() const { return ncols; }
 
-void ElevationGrid::setNrows(int value) { nrows = value; }
+void ElevationGrid::setNrows(int value) {
+    ERR_FAIL_COND_MSG(raster_data != nullptr && value != nrows, "ElevationGrid: nrows cannot change once a raster is set; use set_heightmap.");
+    nrows = value;
+}
 int ElevationGrid::getNrows() const { return nrows; }
 
 void ElevationGrid::setTopLeftGeo(const GeoCoords& value) { topLeftGeo = value; }
@@ -25,8 +41,167 @@ double ElevationGrid::getCellsize() const { return cellsize; }
 void ElevationGrid::setNodataValue(double value) { nodata_value = value; }
 double ElevationGrid::getNodataValue() const { return nodata_value; }
 
-void ElevationGrid::setHeightmap(const godot::Array& value) { heightmap = value; }
-godot::Array ElevationGrid::getHeightmap() const { return heightmap; }
+void ElevationGrid::setRaster(std::vector<float>&& values, int64_t row_stride) {
+    raster = std::move(values);
+    mapping.reset();
+    raster_data = raster.empty() ? nullptr : raster.data();
+    stride = row_stride;
+    heightmap_view_valid = false;
+    if (raster_data != nullptr)
+        pyramid.build(raster_data, stride, nrows, ncols, static_cast<float>(nodata_value));
+    else
+        pyramid.clear();
+    std::lock_guard<std::mutex> lock(surface_mutex);
+    surface.clear();
+}
+
+void ElevationGrid::setMappedRaster(std::shared_ptr<const MappedFile> file, const float* values, int64_t row_stride, const float* pyramid_storage,
+                                    const float* surface_storage) {
+    raster.clear();
+    raster.shrink_to_fit();
+    mapping = std::move(file);
+    raster_data = values;
+    stride = row_stride;
+    heightmap_view_valid = false;
+    pyramid.attach(pyramid_storage, nrows, ncols);
+    std::lock_guard<std::mutex> lock(surface_mutex);
+    surface.attach(surface_storage, nrows, ncols);
+}
+
+const SurfaceMaps& ElevationGrid::getSurfaceMaps() const {
+    std::lock_guard<std::mutex> lock(surface_mutex);
+    if (surface.empty() && raster_data != nullptr)
+        surface.build(raster_data, stride, nrows, ncols, static_cast<float>(nodata_value), topLeftGeo.lat.get_degrees(), cellsize);
+    return surface;
+}
+
+double ElevationGrid::sampleSurface(const float* values, int channels, int channel, const godot::Vector2& geo) const {
+    if (values == nullptr || ncols < 2 || nrows < 2)
+        return 0.0;
+    const GeoCoords coords = GeoCoords::from_vector2_representation(geo);
+    const double x = (coords.lon.get_degrees() - topLeftGeo.lon.get_degrees()) / cellsize;
+    const double y = (topLeftGeo.lat.get_degrees() - coords.lat.get_degrees()) / cellsize;
+    const int col = std::max(0, std::min(static_cast<int>(std::floor(x)), ncols - 2));
+    const int row = std::max(0, std::min(static_cast<int>(std::floor(y)), nrows - 2));
+    const double dx = std::max(0.0, std::min(1.0, x - col)), dy = std::max(0.0, std::min(1.0, y - row));
+    auto at = [&](int r, int c) -> double {
+        return values[(static_cast<size_t>(r) * ncols + c) * channels + channel];
+    };
+    const double top = at(row, col) + dx * (at(row, col + 1) - at(row, col));
+    const double bottom = at(row + 1, col) + dx * (at(row + 1, col + 1) - at(row + 1, col));
+    return top + dy * (bottom - top);
+}
+
+godot::Vector3 ElevationGrid::get_normal(const godot::Vector2& geo) const {
+    const float* normals = getSurfaceMaps().get_normals();
+    if (normals == nullptr)
+        return godot::Vector3(0.0, 1.0, 0.0);
+    const godot::Vector3 normal(static_cast<real_t>(sampleSurface(normals, 3, 0, geo)), static_cast<real_t>(sampleSurface(normals, 3, 1, geo)),
+                                static_cast<real_t>(sampleSurface(normals, 3, 2, geo)));
+    return normal.normalized();
+}
+
+double ElevationGrid::get_slope(const godot::Vector2& geo) const {
+    return sampleSurface(getSurfaceMaps().get_slopes(), 1, 0, geo);
+}
+
+double ElevationGrid::get_curvature(const godot::Vector2& geo) const {
+    return sampleSurface(getSurfaceMaps().get_curvatures(), 1, 0, geo);
+}
+
+godot::Ref<godot::Image> ElevationGrid::get_normal_image(bool mipmaps) const {
+    const SurfaceMaps& maps = getSurfaceMaps();
+    if (maps.empty())
+        return godot::Ref<godot::Image>();
+
+    // The normals are already stored as RGB triplets.
+    PackedByteArray bytes;
+    bytes.resize(static_cast<int64_t>(3 * sizeof(float)) * ncols * nrows);
+    std::memcpy(bytes.ptrw(), maps.get_normals(), bytes.size());
+    godot::Ref<godot::Image> image = godot::Image::create_from_data(ncols, nrows, false, godot::Image::FORMAT_RGBF, bytes);
+    if (mipmaps)
+        image->generate_mipmaps();
+    return image;
+}
+
+godot::Ref<godot::Image> ElevationGrid::get_slope_image(bool mipmaps) const {
+    const SurfaceMaps& maps = getSurfaceMaps();
+    if (maps.empty())
+        return godot::Ref<godot::Image>();
+
+    const size_t count = static_cast<size_t>(ncols) * nrows;
+    PackedByteArray bytes;
+    bytes.resize(static_cast<int64_t>(2 * sizeof(float) * count));
+    float* dst = reinterpret_cast<float*>(bytes.ptrw());
+    const float* slopes = maps.get_slopes();
+    const float* curvatures = maps.get_curvatures();
+    for (size_t i = 0; i < count; i++) {
+        dst[2 * i] = slopes[i];
+        dst[2 * i + 1] = curvatures[i];
+    }
+    godot::Ref<godot::Image> image = godot::Image::create_from_data(ncols, nrows, false, godot::Image::FORMAT_RGF, bytes);
+    if (mipmaps)
+        image->generate_mipmaps();
+    return image;
+}
+
+bool ElevationGrid::getHeightBounds(const GeoCoords& min, const GeoCoords& max, float& min_height, float& max_height) const {
+    if (raster_data == nullptr || cellsize <= 0.0)
+        return false;
+    const double left = topLeftGeo.lon.get_degrees(), top = topLeftGeo.lat.get_degrees();
+    const double col_begin = std::floor((min.lon.get_degrees() - left) / cellsize);
+    const double col_end = std::ceil((max.lon.get_degrees() - left) / cellsize);
+    const double row_begin = std::floor((top - max.lat.get_degrees()) / cellsize);
+    const double row_end = std::ceil((top - min.lat.get_degrees()) / cellsize);
+    if (col_end < 0.0 || row_end < 0.0 || col_begin > ncols - 1 || row_begin > nrows - 1)
+        return false;
+
+    return pyramid.query(static_cast<int>(std::max(0.0, row_begin)), static_cast<int>(std::max(0.0, col_begin)),
+                         static_cast<int>(std::min<double>(nrows - 1, row_end)), static_cast<int>(std::min<double>(ncols - 1, col_end)),
+                         min_height, max_height);
+}
+
+godot::Vector2 ElevationGrid::get_height_bounds(const godot::Vector2& min_geo, const godot::Vector2& max_geo) const {
+    float min_height, max_height;
+    if (!getHeightBounds(GeoCoords::from_vector2_representation(min_geo), GeoCoords::from_vector2_representation(max_geo), min_height, max_height))
+        return godot::Vector2(INFINITY, -INFINITY);
+    return godot::Vector2(min_height, max_height);
+}
+
+void ElevationGrid::setHeightmap(const godot::Array& value) {
+    const int rows = static_cast<int>(value.size());
+    const int cols = rows > 0 ? static_cast<int>(static_cast<PackedFloat64Array>(value[0]).size()) : 0;
+
+    std::vector<float> values(static_cast<size_t>(rows) * cols, 0.0f);
+    for (int i = 0; i < rows; i++) {
+        const PackedFloat64Array row = value[i];
+        const int64_t n = std::min<int64_t>(row.size(), cols);
+        for (int64_t j = 0; j < n; j++)
+            values[static_cast<size_t>(i) * cols + j] = static_cast<float>(row[j]);
+    }
+
+    nrows = rows;
+    ncols = cols;
+    setRaster(std::move(values), cols);
+}
+
+godot::Array ElevationGrid::getHeightmap() const {
+    if (!heightmap_view_valid) {
+        heightmap_view = TypedArray<PackedFloat64Array>();
+        heightmap_view.resize(raster_data == nullptr ? 0 : nrows);
+        for (int i = 0; i < heightmap_view.size(); i++) {
+            PackedFloat64Array row;
+            row.resize(ncols);
+            double* dst = row.ptrw();
+            for (int j = 0; j < ncols; j++)
+                dst[j] = getHeight(i, j);
+            heightmap_view[i] = row;
+        }
+        heightmap_view_valid = true;
+    }
+    // Arrays are shared by reference; the rows are copy-on-write, so a shallow copy keeps scripts off the cache.
+    return heightmap_view.duplicate();
+}
 
 godot::Vector3 ElevationGrid::getBottomLeftWorld() const {
     if (this->geomap == nullptr) {
@@ -65,37 +240,64 @@ godot::Vector3 ElevationGrid::getTopRightWorld() const {
 }
 
 double ElevationGrid::bilinearInterpolation(const GeoCoords &point) const {
-    // Convert geographic coordinates to pixel coordinates
-    double pixelX = (point.lon - getTopLeftGeo().lon).get_degrees() / getCellsize();
-    double pixelY = (getTopLeftGeo().lat - point.lat).get_degrees() / getCellsize();
-
-    // Get the integer part of the pixel coordinates (nearest pixel indices)
-    int col = static_cast<int>(std::floor(pixelX));
-    int row = static_cast<int>(std::floor(pixelY));
-
-    // Ensure indices are within bounds (same as in GDAL code)
-    col = std::max(0, std::min(col, getNcols() - 2));
-    row = std::max(0, std::min(row, getNrows() - 2));
-
-    // Calculate fractional parts
-    double dx = pixelX - col;
-    double dy = pixelY - row;
-
-    // Bilinear interpolation
-    const auto& heightmap = getHeightmap();
-    double Q11 = static_cast<PackedFloat64Array>(heightmap[row])[col];
-    double Q21 = static_cast<PackedFloat64Array>(heightmap[row])[col + 1];
-    double Q12 = static_cast<PackedFloat64Array>(heightmap[row + 1])[col];
-    double Q22 = static_cast<PackedFloat64Array>(heightmap[row + 1])[col + 1];
-
-    double elevation = (1 - dx) * (1 - dy) * Q11 +
-                      dx * (1 - dy) * Q21 +
-                      (1 - dx) * dy * Q12 +
-                      dx * dy * Q22;
-
+    const double lon = point.lon.get_radians(), lat = point.lat.get_radians();
+    double elevation;
+    sampleBatch(&lon, &lat, 1, &elevation);
     return elevation;
 }
 
+void ElevationGrid::sampleBatch(const double* lon, const double* lat, size_t count, double* out) const {
+    if (raster_data == nullptr || getNcols() < 2 || getNrows() < 2) {
+        std::fill(out, out + count, 0.0);
+        return;
+    }
+
+    // Geographic coordinates to pixel coordinates: degrees from the top left corner over the cell size.
+    const double to_pixels = 180.0 / Math_PI / getCellsize();
+    const double lon0 = getTopLeftGeo().lon.get_radians(), lat0 = getTopLeftGeo().lat.get_radians();
+    const int max_col = getNcols() - 2, max_row = getNrows() - 2;
+    const float* data = raster_data;
+
+    // Blocks: the index/weight pass is branch-free arithmetic the compiler vectorizes, the gather follows.
+    const size_t BLOCK = 256;
+    int64_t index[BLOCK];
+    double dx[BLOCK], dy[BLOCK];
+    for (size_t begin = 0; begin < count; begin += BLOCK) {
+        const size_t n = std::min(BLOCK, count - begin);
+        for (size_t i = 0; i < n; i++) {
+            const double pixel_x = (lon[begin + i] - lon0) * to_pixels;
+            const double pixel_y = (lat0 - lat[begin + i]) * to_pixels;
+            // Clamp the cell to the grid (same as in GDAL code); outside points extrapolate the edge cell.
+            const int col = std::max(0, std::min(static_cast<int>(std::floor(pixel_x)), max_col));
+            const int row = std::max(0, std::min(static_cast<int>(std::floor(pixel_y)), max_row));
+            dx[i] = pixel_x - col;
+            dy[i] = pixel_y - row;
+            index[i] = row * stride + col;
+        }
+        for (size_t i = 0; i < n; i++) {
+            const float* q = data + index[i];
+            const double top = q[0] + dx[i] * (q[1] - q[0]);
+            const double bottom = q[stride] + dx[i] * (q[stride + 1] - q[stride]);
+            out[begin + i] = top + dy[i] * (bottom - top);
+        }
+    }
+}
+
+godot::PackedFloat64Array ElevationGrid::sample_batch(godot::PackedVector2Array coords) const {
+    const int64_t count = coords.size();
+    std::vector<double> lon(count), lat(count);
+    const Vector2* src = coords.ptr();
+    for (int64_t i = 0; i < count; i++) {
+        lon[i] = src[i].x;
+        lat[i] = src[i].y;
+    }
+
+    PackedFloat64Array heights;
+    heights.resize(count);
+    sampleBatch(lon.data(), lat.data(), count, heights.ptrw());
+    return heights;
+}
+
 void ElevationGrid::_bind_methods()
 {
     ClassDB::bind_method(D_METHOD("set_ncols", "value"), &ElevationGrid::setNcols);
@@ -121,6 +323,14 @@ void ElevationGrid::_bind_methods()
     ClassDB::bind_method(D_METHOD("set_top_left_geo", "value"), &ElevationGrid::setTopLeftGeoVec);
     ClassDB::bind_method(D_METHOD("get_top_left_geo"), &ElevationGrid::getTopLeftGeoVec);
 
+    ClassDB::bind_method(D_METHOD("sample_batch", "coords"), &ElevationGrid::sample_batch);
+    ClassDB::bind_method(D_METHOD("get_height_bounds", "min_geo", "max_geo"), &ElevationGrid::get_height_bounds);
+    ClassDB::bind_method(D_METHOD("get_normal", "geo"), &ElevationGrid::get_normal);
+    ClassDB::bind_method(D_METHOD("get_slope", "geo"), &ElevationGrid::get_slope);
+    ClassDB::bind_method(D_METHOD("get_curvature", "geo"), &ElevationGrid::get_curvature);
+    ClassDB::bind_method(D_METHOD("get_normal_image", "mipmaps"), &ElevationGrid::get_normal_image, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("get_slope_image", "mipmaps"), &ElevationGrid::get_slope_image, DEFVAL(true));
+
     ADD_PROPERTY(PropertyInfo(Variant::INT, "ncols"), "set_ncols", "get_ncols");
     ADD_PROPERTY(PropertyInfo(Variant::INT, "nrows"), "set_nrows", "get_nrows");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "cellsize"), "set_cellsize", "get_cellsize");
@@ -129,71 +339,262 @@ void ElevationGrid::_bind_methods()
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "nodata_value"), "set_nodata_value", "get_nodata_value");
 }
 
-// Function to load the ASCII Grid
-Ref<ElevationGrid> loadASCIIGrid(const godot::String& filename) {
-    Ref<FileAccess> gd_file = FileAccess::open(filename, FileAccess::READ);
-    if (!gd_file->is_open()) {
-        WARN_PRINT("Could not open file " + filename);
+namespace {
+    bool is_space(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
     }
 
-    std::istringstream file(std::string(gd_file->get_as_text().ascii().ptr()));
+    const char* skip_space(const char* p, const char* end) {
+        while (p < end && is_space(*p))
+            p++;
+        return p;
+    }
 
-    gd_file->close();
+    const char* skip_token(const char* p, const char* end) {
+        while (p < end && !is_space(*p))
+            p++;
+        return p;
+    }
 
-    Ref<ElevationGrid> grid = memnew(ElevationGrid);
-    std::string line;
-
-    {
-        std::string key;
-        int ncols, nrows;
-        double left, bottom, cellsize, nodata_value;
-        file >> key >> ncols;
-        file >> key >> nrows;
-        file >> key >> left;
-        file >> key >> bottom;
-        file >> key >> cellsize;
-
-        auto pos = file.tellg();
-        file >> key;
-        if (key == "NODATA_value") {
-            file >> nodata_value;
-        } else {
-            file.seekg(pos);
+    /* Parses a number at p. @return The position after it, or p if there is no number. */
+    const char* parse_number(const char* p, const char* end, double& out) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        const char* start = (p < end && *p == '+') ? p + 1 : p; // from_chars does not accept a plus sign
+        const auto result = std::from_chars(start, end, out);
+        return result.ec == std::errc() ? result.ptr : p;
+#else
+        // No floating point from_chars in this standard library (e.g. libc++). strtod follows the locale and
+        // would stop at the '.' under a comma-decimal one, so the number is parsed by hand.
+        const char* q = p;
+        const bool negative = q < end && *q == '-';
+        if (q < end && (*q == '-' || *q == '+'))
+            q++;
+
+        // Up to 19 significant digits fit in the mantissa; further integer digits only scale it.
+        uint64_t mantissa = 0;
+        int digits = 0, exponent = 0;
+        bool any_digit = false;
+        for (; q < end && *q >= '0' && *q <= '9'; q++, any_digit = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*q - '0');
+                digits += mantissa != 0;
+            } else {
+                exponent++;
+            }
+        }
+        if (q < end && *q == '.') {
+            for (q++; q < end && *q >= '0' && *q <= '9'; q++, any_digit = true) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*q - '0');
+                    digits += mantissa != 0;
+                    exponent--;
+                }
+            }
+        }
+        if (!any_digit)
+            return p;
+
+        if (q < end && (*q == 'e' || *q == 'E')) {
+            const char* e = q + 1;
+            const bool exponent_negative = e < end && *e == '-';
+            if (e < end && (*e == '-' || *e == '+'))
+                e++;
+            if (e < end && *e >= '0' && *e <= '9') {
+                int value = 0;
+                for (; e < end && *e >= '0' && *e <= '9'; e++)
+                    value = std::min(value * 10 + (*e - '0'), 100000);
+                exponent += exponent_negative ? -value : value;
+                q = e;
+            }
         }
 
-        grid->setNcols(ncols);
-        grid->setNrows(nrows);
-        grid->setCellsize(cellsize);
-        grid->setTopLeftGeo(GeoCoords(Longitude::degrees(left), Latitude::degrees(bottom + nrows * cellsize)));
+        const double magnitude = static_cast<double>(mantissa);
+        out = exponent < 0 ? magnitude / std::pow(10.0, -exponent) : magnitude * std::pow(10.0, exponent);
+        if (negative)
+            out = -out;
+        return q;
+#endif
     }
 
-    std::getline(file, line);
-
+    struct AsciiGridHeader {
+        int ncols = 0;
+        int nrows = 0;
+        double x = 0.0;
+        double y = 0.0;
+        bool x_is_center = false;
+        bool y_is_center = false;
+        double cellsize = 0.0;
+        double nodata_value = -9999.0;
+    };
+
+    /* Reads "key value" pairs until the first numeric token. @return Start of the data. */
+    const char* parse_ascii_grid_header(const char* p, const char* end, AsciiGridHeader& header) {
+        while (true) {
+            p = skip_space(p, end);
+            if (p >= end || !std::isalpha(static_cast<unsigned char>(*p)))
+                return p;
+
+            const char* key_end = skip_token(p, end);
+            std::string key(p, key_end);
+            std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            double value = 0.0;
+            p = skip_space(key_end, end);
+            const char* value_end = parse_number(p, end, value);
+            if (value_end == p) {
+                WARN_PRINT(String("ASCII grid: no value for header key ") + key.c_str());
+                return p;
+            }
+            p = skip_token(value_end, end);
+
+            if (key == "ncols")
+                header.ncols = static_cast<int>(value);
+            else if (key == "nrows")
+                header.nrows = static_cast<int>(value);
+            else if (key == "xllcorner" || key == "xllcenter") {
+                header.x = value;
+                header.x_is_center = key == "xllcenter";
+            } else if (key == "yllcorner" || key == "yllcenter") {
+                header.y = value;
+                header.y_is_center = key == "yllcenter";
+            } else if (key == "cellsize")
+                header.cellsize = value;
+            else if (key == "nodata_value")
+                header.nodata_value = value;
+        }
+    }
 
-    // Initialize the heightmap
-    std::vector<PackedFloat64Array> heightmap(grid->getNrows(), PackedFloat64Array());
-    // Read the elevation data
-    for (int i = 0; i < grid->getNrows(); i++) {
-        std::getline(file, line);
-        std::istringstream iss(line);
-        heightmap[i].resize(grid->getNcols());
-        for (int j = 0; j < grid->getNcols(); j++) {
-            iss >> heightmap[i][j];
+    size_t count_tokens(const char* p, const char* end) {
+        size_t count = 0;
+        while (true) {
+            p = skip_space(p, end);
+            if (p >= end)
+                return count;
+            p = skip_token(p, end);
+            count++;
         }
     }
 
+    /**
+     * Parses the values of an ASCII grid into raster (row-major from the top row). The text is split
+     * into chunks at whitespace; the first parallel pass counts the values of each chunk, which gives
+     * every chunk its first raster index, and the second pass parses straight into the raster.
+     * @return Number of values found in the text.
+     */
+    size_t parse_ascii_grid_values(const char* begin, const char* end, float nodata_value, std::vector<float>& raster) {
+        const size_t span = static_cast<size_t>(end - begin);
+        const size_t chunk_count = parallel_worker_count(span, 1 << 20);
+
+        std::vector<const char*> bounds(chunk_count + 1);
+        bounds[0] = begin;
+        bounds[chunk_count] = end;
+        for (size_t i = 1; i < chunk_count; i++)
+            bounds[i] = std::max(bounds[i - 1], skip_token(begin + span * i / chunk_count, end));
+
+        std::vector<size_t> first_index(chunk_count + 1, 0);
+        parallel_for(chunk_count, [&](size_t i, size_t) {
+            first_index[i + 1] = count_tokens(bounds[i], bounds[i + 1]);
+        });
+        for (size_t i = 0; i < chunk_count; i++)
+            first_index[i + 1] += first_index[i];
+
+        parallel_for(chunk_count, [&](size_t i, size_t) {
+            const char* p = bounds[i];
+            const char* chunk_end = bounds[i + 1];
+            size_t index = first_index[i];
+            while (true) {
+                p = skip_space(p, chunk_end);
+                if (p >= chunk_end)
+                    break;
+                double value = 0.0;
+                const char* value_end = parse_number(p, chunk_end, value);
+                if (index < raster.size())
+                    raster[index] = value_end == p ? nodata_value : static_cast<float>(value);
+                index++;
+                // Exactly one value per token, even if the token has trailing garbage.
+                p = skip_token(value_end, chunk_end);
+            }
+        });
+        return first_index[chunk_count];
+    }
+}
 
-    auto gd_heightmap = TypedArray<PackedFloat64Array>();
-    gd_heightmap.resize(grid->getNrows());
-    for (int i = 0; i < grid->getNrows(); i++) {
-        gd_heightmap[i] = heightmap[i];
+namespace {
+    /* Centre of the north west sample, as topLeftGeo is for every loader; xllcorner and yllcorner are moved in half a cell. */
+    GeoCoords ascii_grid_top_left(const AsciiGridHeader& header) {
+        const double left = header.x + (header.x_is_center ? 0.0 : header.cellsize * 0.5);
+        const double bottom = header.y + (header.y_is_center ? 0.0 : header.cellsize * 0.5);
+        return GeoCoords(Longitude::degrees(left), Latitude::degrees(bottom + (header.nrows - 1) * header.cellsize));
     }
+}
 
-    grid->setHeightmap(gd_heightmap);
+// Function to load the ASCII Grid
+Ref<ElevationGrid> loadASCIIGrid(const godot::String& filename) {
+    FileBytes file;
+    if (!file.open(filename)) {
+        WARN_PRINT("Could not open file " + filename);
+        return Ref<ElevationGrid>(memnew(ElevationGrid));
+    }
+    const char* begin = file.chars();
+    const char* end = begin + file.size();
+
+    Ref<ElevationGrid> grid = memnew(ElevationGrid);
+
+    AsciiGridHeader header;
+    const char* data = parse_ascii_grid_header(begin, end, header);
+
+    grid->setNcols(header.ncols);
+    grid->setNrows(header.nrows);
+    grid->setCellsize(header.cellsize);
+    grid->setNodataValue(header.nodata_value);
+    grid->setTopLeftGeo(ascii_grid_top_left(header));
+
+    const size_t expected = static_cast<size_t>(std::max(0, header.ncols)) * static_cast<size_t>(std::max(0, header.nrows));
+    std::vector<float> raster(expected, static_cast<float>(header.nodata_value));
+    const size_t found = parse_ascii_grid_values(data, end, static_cast<float>(header.nodata_value), raster);
+    if (found != expected)
+        WARN_PRINT("ASCII grid " + filename + " has " + String::num_uint64(found) + " values, expected " + String::num_uint64(expected) + ".");
+
+    grid->setRaster(std::move(raster), header.ncols);
 
     return grid;
 }
 
+bool probeASCIIGrid(const godot::String& filename, DEMInfo& info) {
+    // Only the first page of the file is touched.
+    FileBytes file;
+    if (!file.open(filename, MappedFile::RANDOM))
+        return false;
+
+    AsciiGridHeader header;
+    parse_ascii_grid_header(file.chars(), file.chars() + file.size(), header);
+    if (header.ncols <= 0 || header.nrows <= 0 || header.cellsize <= 0.0)
+        return false;
+
+    info = DEMInfo::from_grid(ascii_grid_top_left(header), header.cellsize, header.nrows, header.ncols);
+    return true;
+}
+
+Ref<ElevationGrid> loadDEM(const godot::String& filename, const DEMWindow* window) {
+    const String extension = filename.get_extension().to_lower();
+    if (extension == "hgt")
+        return loadHGT(filename, window);
+    if (extension == "tif" || extension == "tiff")
+        return loadGeoTIFF(filename, window);
+    return loadASCIIGrid(filename);
+}
+
+bool probeDEM(const godot::String& filename, DEMInfo& info) {
+    const String extension = filename.get_extension().to_lower();
+    if (extension == "hgt")
+        return probeHGT(filename, info);
+    if (extension == "tif" || extension == "tiff")
+        return probeGeoTIFF(filename, info);
+    if (extension == "asc")
+        return probeASCIIGrid(filename, info);
+    return false;
+}
+
 // Function to extract a subgrid based on latitude and longitude bounds
 std::vector<std::vector<double>> extractSubgrid(const ElevationGrid& grid, const GeoCoords& start, const GeoCoords& end) {
     // Calculate row and column indices (same as in GDAL code)
@@ -209,10 +610,9 @@ std::vector<std::vector<double>> extractSubgrid(const ElevationGrid& grid, const
 
     // Extract the subgrid
     std::vector<std::vector<double>> subgrid(std::max(0, rowEnd - rowStart + 1), std::vector<double>(std::max(0, colEnd - colStart + 1)));
-    const auto& heightmap = grid.getHeightmap();
     for (int i = rowStart; i <= rowEnd; ++i) {
         for (int j = colStart; j <= colEnd; ++j) {
-            subgrid[i - rowStart][j - colStart] = static_cast<PackedFloat64Array>(heightmap[i])[j];
+            subgrid[i - rowStart][j - colStart] = grid.getHeight(i, j);
         }
     }
 
@@ -220,35 +620,7 @@ std::vector<std::vector<double>> extractSubgrid(const ElevationGrid& grid, const
 }
 
 double bilinearInterpolation(const ElevationGrid& grid, const GeoCoords& point) {
-    // Convert geographic coordinates to pixel coordinates
-    double pixelX = (point.lon - grid.getTopLeftGeo().lon).get_degrees() / grid.getCellsize();
-    double pixelY = (grid.getTopLeftGeo().lat - point.lat).get_degrees() / grid.getCellsize();
-
-    // Get the integer part of the pixel coordinates (nearest pixel indices)
-    int col = static_cast<int>(std::floor(pixelX));
-    int row = static_cast<int>(std::floor(pixelY));
-
-    // Ensure indices are within bounds (same as in GDAL code)
-    col = std::max(0, std::min(col, grid.getNcols() - 2));
-    row = std::max(0, std::min(row, grid.getNrows() - 2));
-
-    // Calculate fractional parts
-    double dx = pixelX - col;
-    double dy = pixelY - row;
-
-    // Bilinear interpolation
-    const auto& heightmap = grid.getHeightmap();
-    double Q11 = static_cast<PackedFloat64Array>(heightmap[row])[col];
-    double Q21 = static_cast<PackedFloat64Array>(heightmap[row])[col + 1];
-    double Q12 = static_cast<PackedFloat64Array>(heightmap[row + 1])[col];
-    double Q22 = static_cast<PackedFloat64Array>(heightmap[row + 1])[col + 1];
-
-    double elevation = (1 - dx) * (1 - dy) * Q11 +
-                      dx * (1 - dy) * Q21 +
-                      (1 - dx) * dy * Q12 +
-                      dx * dy * Q22;
-
-    return elevation;
+    return grid.bilinearInterpolation(point);
 }
 
 
@@ -263,7 +635,21 @@ void printGrid(const std::vector<std::vector<double>>& grid) {
 }
 
 godot::Ref<ElevationGrid> ElevationParser::import(godot::Ref<GeoMap> geomap) {
-    auto grid = loadASCIIGrid(filename.ascii().ptr());
+    // Binary rasters are read only around the origin of the GeoMap we are importing into.
+    DEMWindow window;
+    const DEMWindow* window_ptr = nullptr;
+    const OriginBasedGeoMap* origin_geomap = geomap.is_valid() ? Object::cast_to<OriginBasedGeoMap>(geomap.ptr()) : nullptr;
+    if (origin_geomap != nullptr && window_size > 0.0) {
+        const double lon = origin_geomap->get_geo_origin_longitude_degrees();
+        const double lat = origin_geomap->get_geo_origin_latitude_degrees();
+        const double half_lat = window_size * 0.5 / LATITUDE_DEGREE_IN_METRES;
+        const double half_lon = std::min(180.0, half_lat / std::max(1e-6, std::cos(lat * Math_PI / 180.0)));
+        window.min = GeoCoords(Longitude::degrees(lon - half_lon), Latitude::degrees(lat - half_lat));
+        window.max = GeoCoords(Longitude::degrees(lon + half_lon), Latitude::degrees(lat + half_lat));
+        window_ptr = &window;
+    }
+
+    auto grid = use_cache ? loadCachedDEM(filename, window_ptr) : loadDEM(filename, window_ptr);
     if (geomap.is_null()) {
         geomap = godot::Ref<GeoMap>(memnew(EquirectangularGeoMap(grid->getTopLeftGeo() - GeoCoords(Longitude::zero(), Latitude::degrees(grid->getCellsize() * grid->getNrows())), grid->getTopLeftGeo() + GeoCoords(Longitude::degrees(grid->getCellsize() * grid->getNcols()), Latitude::zero()))));
     }
@@ -281,10 +667,33 @@ godot::Ref<ElevationGrid> ElevationParser::import(godot::Ref<GeoMap> geomap) {
     return grid;
 }
 
+godot::Ref<ElevationMosaic> ElevationParser::import_mosaic() {
+    Ref<ElevationMosaic> mosaic = memnew(ElevationMosaic);
+    mosaic->set_memory_limit_mb(memory_limit_mb);
+    mosaic->set_use_cache(use_cache);
+    mosaic->scan_directory(directory);
+
+    WARN_PRINT("Indexed " + String::num_int64(mosaic->get_tile_count()) + " DEM tiles in " + directory);
+    return mosaic;
+}
+
 void ElevationParser::_bind_methods() {
     ClassDB::bind_method(D_METHOD("import", "geomap"), &ElevationParser::import);
+    ClassDB::bind_method(D_METHOD("import_mosaic"), &ElevationParser::import_mosaic);
     ClassDB::bind_method(D_METHOD("set_filename", "value"), &ElevationParser::set_filename);
     ClassDB::bind_method(D_METHOD("get_filename"), &ElevationParser::get_filename);
-
-    ADD_PROPERTY(PropertyInfo(Variant::STRING, "filename", PROPERTY_HINT_FILE, "*.asc"), "set_filename", "get_filename");
+    ClassDB::bind_method(D_METHOD("set_use_cache", "value"), &ElevationParser::set_use_cache);
+    ClassDB::bind_method(D_METHOD("get_use_cache"), &ElevationParser::get_use_cache);
+    ClassDB::bind_method(D_METHOD("set_directory", "value"), &ElevationParser::set_directory);
+    ClassDB::bind_method(D_METHOD("get_directory"), &ElevationParser::get_directory);
+    ClassDB::bind_method(D_METHOD("set_memory_limit_mb", "value"), &ElevationParser::set_memory_limit_mb);
+    ClassDB::bind_method(D_METHOD("get_memory_limit_mb"), &ElevationParser::get_memory_limit_mb);
+    ClassDB::bind_method(D_METHOD("set_window_size", "value"), &ElevationParser::set_window_size);
+    ClassDB::bind_method(D_METHOD("get_window_size"), &ElevationParser::get_window_size);
+
+    ADD_PROPERTY(PropertyInfo(Variant::STRING, "filename", PROPERTY_HINT_FILE, "*.asc,*.hgt,*.tif,*.tiff"), "set_filename", "get_filename");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_cache"), "set_use_cache", "get_use_cache");
+    ADD_PROPERTY(PropertyInfo(Variant::STRING, "directory", PROPERTY_HINT_DIR), "set_directory", "get_directory");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "memory_limit_mb", PROPERTY_HINT_RANGE, "0,65536,1,or_greater,suffix:MB"), "set_memory_limit_mb", "get_memory_limit_mb");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "window_size", PROPERTY_HINT_RANGE, "0,1000000,1,or_greater,suffix:m"), "set_window_size", "get_window_size");
 }
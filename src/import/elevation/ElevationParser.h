@@ -3,17 +3,27 @@
 #include "../GeoMap.h"
 #include "../Parser.h"
 #include "../../util/Util.h"
+#include "HeightPyramid.h"
+#include "SurfaceMaps.h"
+#include <godot_cpp/classes/image.hpp>
 #include <godot_cpp/variant/typed_array.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class MappedFile;
 
 class ElevationGrid : public godot::RefCounted {
     GDCLASS(ElevationGrid, godot::RefCounted);
 public:
+    /* ncols and nrows are fixed once a raster is set; setting a different value then fails. */
     void setNcols(int value);
     int getNcols() const;
 
     void setNrows(int value);
     int getNrows() const;
 
+    /* Centre of the north west sample (row 0, column 0), for every DEM format. */
     void setTopLeftGeo(const GeoCoords& value);
     const GeoCoords& getTopLeftGeo() const;
 
@@ -30,6 +40,60 @@ public:
     void setNodataValue(double value);
     double getNodataValue() const;
 
+    /*
+     * Heights row by row starting from the top (north) row, stride values apart.
+     * Set ncols, nrows and nodata_value first; the min/max pyramid is built from the raster.
+     */
+    void setRaster(std::vector<float>&& values, int64_t row_stride);
+    /*
+     * Uses a raster and pyramid stored in a mapped .sgdem file, which stays mapped as long as the grid needs it.
+     * surface_storage may be null; the surface maps are then computed when first needed.
+     */
+    void setMappedRaster(std::shared_ptr<const MappedFile> file, const float* values, int64_t row_stride, const float* pyramid_storage,
+                         const float* surface_storage = nullptr);
+    const float* getRasterData() const { return raster_data; }
+    int64_t getStride() const { return stride; }
+    float getHeight(int row, int col) const { return raster_data[row * stride + col]; }
+    const HeightPyramid& getPyramid() const { return pyramid; }
+    /* Normal, slope and curvature rasters, computed on first use unless they came from the cache. */
+    const SurfaceMaps& getSurfaceMaps() const;
+
+    /**
+     * Conservative bounds of the heights in a region, from the min/max pyramid.
+     * @return false if the region misses the grid or has no data.
+     */
+    bool getHeightBounds(const GeoCoords& min, const GeoCoords& max, float& min_height, float& max_height) const;
+
+    /**
+     * Conservative height bounds of a region, e.g. for culling.
+     * @param min_geo Minimum corner of the region in its Vector2 representation.
+     * @param max_geo Maximum corner of the region in its Vector2 representation.
+     * @return (min, max) height, or (INF, -INF) if the region has no data.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Vector2 get_height_bounds(const godot::Vector2& min_geo, const godot::Vector2& max_geo) const;
+
+    /* Bilinear surface normal at a point given in its Vector2 geo representation (east, up, south frame). */
+    MAPSHADERS_DLL_SYMBOL godot::Vector3 get_normal(const godot::Vector2& geo) const;
+    /* Bilinear slope at a point in degrees. */
+    MAPSHADERS_DLL_SYMBOL double get_slope(const godot::Vector2& geo) const;
+    /* Bilinear curvature (Laplacian of the height) at a point in 1/m; positive in hollows. */
+    MAPSHADERS_DLL_SYMBOL double get_curvature(const godot::Vector2& geo) const;
+
+    /**
+     * Normals as an ncols x nrows FORMAT_RGBF image, row 0 at the top (north).
+     * @param mipmaps Whether to generate mipmaps.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Ref<godot::Image> get_normal_image(bool mipmaps = true) const;
+    /**
+     * Slope (R, degrees) and curvature (G, 1/m) as an ncols x nrows FORMAT_RGF image.
+     * @param mipmaps Whether to generate mipmaps.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Ref<godot::Image> get_slope_image(bool mipmaps = true) const;
+
+    /*
+     * Compatibility view of the raster: one PackedFloat64Array per row, built on first access.
+     * get_heightmap returns a copy, so editing it no longer changes the grid; pass the edited rows to set_heightmap.
+     */
     void setHeightmap(const godot::Array& value);
     godot::Array getHeightmap() const;
 
@@ -46,26 +110,95 @@ public:
     }
 
     double bilinearInterpolation(const GeoCoords & coords) const;
+
+    /* Bilinear heights of many points (radians) in one pass over the raster. */
+    void sampleBatch(const double* lon, const double* lat, size_t count, double* out) const;
+
+    /**
+     * Bilinear heights of many points.
+     * @param coords Geo coordinates in their Vector2 representation.
+     * @return One height per point.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::PackedFloat64Array sample_batch(godot::PackedVector2Array coords) const;
 protected: 
     static void _bind_methods();
 
 private:
-    int ncols;
-    int nrows;
+    int ncols = 0;
+    int nrows = 0;
     GeoCoords topLeftGeo;
-    double cellsize;
-    double nodata_value;
-    godot::TypedArray<godot::PackedFloat64Array> heightmap;
+    double cellsize = 0.0;
+    double nodata_value = -9999.0;
+
+    /* raster_data points either into raster or into mapping. */
+    std::vector<float> raster;
+    std::shared_ptr<const MappedFile> mapping;
+    const float* raster_data = nullptr;
+    int64_t stride = 0;
+    HeightPyramid pyramid;
+    mutable SurfaceMaps surface;
+    mutable std::mutex surface_mutex;
+
+    /* Bilinear value of one channel of an interleaved surface raster at a point. */
+    double sampleSurface(const float* values, int channels, int channel, const godot::Vector2& geo) const;
+
+    mutable godot::TypedArray<godot::PackedFloat64Array> heightmap_view;
+    mutable bool heightmap_view_valid = false;
 
     godot::Ref<GeoMap> geomap;
 };
 
+/* Geographic rectangle to read from a raster. */
+struct DEMWindow {
+    GeoCoords min;
+    GeoCoords max;
+
+    bool contains(const GeoCoords& coords) const {
+        return coords.lon.value >= min.lon.value && coords.lon.value <= max.lon.value &&
+               coords.lat.value >= min.lat.value && coords.lat.value <= max.lat.value;
+    }
+};
+
+/* Georeferencing of a DEM file, read without loading its raster. */
+struct DEMInfo {
+    /* Rectangle spanned by the samples. */
+    DEMWindow bounds;
+    double cellsize = 0.0;
+    int ncols = 0;
+    int nrows = 0;
+
+    /* @param top_left Centre of the north west sample, like ElevationGrid::getTopLeftGeo. */
+    static DEMInfo from_grid(const GeoCoords& top_left, double cellsize, int nrows, int ncols) {
+        DEMInfo info;
+        info.bounds.min = top_left - GeoCoords(Longitude::zero(), Latitude::degrees(cellsize * (nrows - 1)));
+        info.bounds.max = top_left + GeoCoords(Longitude::degrees(cellsize * (ncols - 1)), Latitude::zero());
+        info.cellsize = cellsize;
+        info.ncols = ncols;
+        info.nrows = nrows;
+        return info;
+    }
+};
+
+/**
+ * Loads a DEM file, choosing the reader by extension: .hgt, .tif/.tiff or ESRI ASCII grid.
+ * @param window Region to read, or null for the whole file. Only the binary readers honour it.
+ */
+godot::Ref<ElevationGrid> loadDEM(const godot::String& filename, const DEMWindow* window = nullptr);
+
+/* Reads only the header of a DEM file. @return false if it is not a DEM file we can load. */
+bool probeDEM(const godot::String& filename, DEMInfo& info);
+
+class ElevationMosaic;
+
 class ElevationParser : public Parser {
     GDCLASS(ElevationParser, Parser);
 public:
     using Parser::Parser;
     godot::Ref<ElevationGrid> import(godot::Ref<GeoMap> geomap = nullptr);
 
+    /* Indexes the DEM tiles in directory; they are loaded lazily when sampled. */
+    godot::Ref<ElevationMosaic> import_mosaic();
+
     void set_filename(const godot::String& value) {
         filename = value;
     }
@@ -73,6 +206,41 @@ public:
         return filename;
     }
 
+    /* Whether to load through and write .sgdem caches next to the DEM files (see ElevationCache.h). */
+    void set_use_cache(bool value) {
+        use_cache = value;
+    }
+    bool get_use_cache() const {
+        return use_cache;
+    }
+
+    /* Directory of DEM tiles. When set, SGImport uses import_mosaic instead of loading filename. */
+    void set_directory(const godot::String& value) {
+        directory = value;
+    }
+    godot::String get_directory() const {
+        return directory;
+    }
+
+    /* Memory the mosaic may use for loaded tiles. */
+    void set_memory_limit_mb(int64_t value) {
+        memory_limit_mb = value;
+    }
+    int64_t get_memory_limit_mb() const {
+        return memory_limit_mb;
+    }
+
+    /*
+     * Side of the square around the GeoMap origin, in metres, read from binary rasters (.hgt, .tif).
+     * 0 reads the whole raster.
+     */
+    void set_window_size(double value) {
+        window_size = value;
+    }
+    double get_window_size() const {
+        return window_size;
+    }
+
     ~ElevationParser() override = default;
 
 protected:
@@ -80,6 +248,10 @@ protected:
 
 private:
     godot::String filename;
+    godot::String directory;
+    int64_t memory_limit_mb = 512;
+    double window_size = 0.0;
+    bool use_cache = true;
 };
 
 #endif // ELEVATION_PARSER_H
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "HeightPyramid.h"
+#include "../../util/Parallel.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    /* Blocks along a side of size samples at level 0, at least one. */
+    int level0_blocks(int samples) {
+        return std::max(1, (samples - 1 + HeightPyramid::BLOCK - 1) / HeightPyramid::BLOCK);
+    }
+
+    template <typename F>
+    void for_each_level_size(int nrows, int ncols, F&& f) {
+        int rows = level0_blocks(nrows), cols = level0_blocks(ncols);
+        while (true) {
+            f(rows, cols);
+            if (rows == 1 && cols == 1)
+                break;
+            rows = (rows + 1) / 2;
+            cols = (cols + 1) / 2;
+        }
+    }
+}
+
+size_t HeightPyramid::storage_size(int nrows, int ncols) {
+    if (nrows <= 0 || ncols <= 0)
+        return 0;
+    size_t size = 0;
+    for_each_level_size(nrows, ncols, [&](int rows, int cols) {
+        size += 2 * static_cast<size_t>(rows) * cols;
+    });
+    return size;
+}
+
+void HeightPyramid::layout(const float* storage, int nrows, int ncols) {
+    levels.clear();
+    storage_data = storage;
+    raster_rows = nrows;
+    raster_cols = ncols;
+    if (storage == nullptr || nrows <= 0 || ncols <= 0)
+        return;
+
+    size_t offset = 0;
+    for_each_level_size(nrows, ncols, [&](int rows, int cols) {
+        Level level;
+        level.rows = rows;
+        level.cols = cols;
+        level.min = storage + offset;
+        level.max = storage + offset + static_cast<size_t>(rows) * cols;
+        offset += 2 * static_cast<size_t>(rows) * cols;
+        levels.push_back(level);
+    });
+}
+
+void HeightPyramid::build(const float* raster, int64_t stride, int nrows, int ncols, float nodata_value) {
+    owned.assign(storage_size(nrows, ncols), 0.0f);
+    layout(owned.data(), nrows, ncols);
+    if (levels.empty())
+        return;
+
+    const float none_min = std::numeric_limits<float>::infinity();
+    const float none_max = -std::numeric_limits<float>::infinity();
+
+    // Level 0 straight from the raster, one block row per task.
+    const Level& base = levels[0];
+    float* base_min = owned.data();
+    float* base_max = owned.data() + static_cast<size_t>(base.rows) * base.cols;
+    parallel_for(base.rows, [&](size_t block_row, size_t) {
+        const int row_begin = static_cast<int>(block_row) * BLOCK;
+        const int row_end = std::min(row_begin + BLOCK, nrows - 1);
+        for (int block_col = 0; block_col < base.cols; block_col++) {
+            const int col_begin = block_col * BLOCK;
+            const int col_end = std::min(col_begin + BLOCK, ncols - 1);
+            float lo = none_min, hi = none_max;
+            for (int r = row_begin; r <= row_end; r++) {
+                const float* row = raster + r * stride;
+                for (int c = col_begin; c <= col_end; c++) {
+                    if (row[c] == nodata_value)
+                        continue;
+                    lo = std::min(lo, row[c]);
+                    hi = std::max(hi, row[c]);
+                }
+            }
+            base_min[block_row * base.cols + block_col] = lo;
+            base_max[block_row * base.cols + block_col] = hi;
+        }
+    }, 16);
+
+    for (size_t l = 1; l < levels.size(); l++) {
+        const Level& child = levels[l - 1];
+        const Level& level = levels[l];
+        float* level_min = const_cast<float*>(level.min);
+        float* level_max = const_cast<float*>(level.max);
+        for (int r = 0; r < level.rows; r++) {
+            for (int c = 0; c < level.cols; c++) {
+                float lo = none_min, hi = none_max;
+                for (int cr = 2 * r; cr < std::min(2 * r + 2, child.rows); cr++) {
+                    for (int cc = 2 * c; cc < std::min(2 * c + 2, child.cols); cc++) {
+                        lo = std::min(lo, child.min[cr * child.cols + cc]);
+                        hi = std::max(hi, child.max[cr * child.cols + cc]);
+                    }
+                }
+                level_min[r * level.cols + c] = lo;
+                level_max[r * level.cols + c] = hi;
+            }
+        }
+    }
+}
+
+void HeightPyramid::attach(const float* storage, int nrows, int ncols) {
+    owned.clear();
+    owned.shrink_to_fit();
+    layout(storage, nrows, ncols);
+}
+
+void HeightPyramid::clear() {
+    owned.clear();
+    layout(nullptr, 0, 0);
+}
+
+bool HeightPyramid::query(int row_begin, int col_begin, int row_end, int col_end, float& min_height, float& max_height) const {
+    if (levels.empty())
+        return false;
+    row_begin = std::max(0, row_begin);
+    col_begin = std::max(0, col_begin);
+    row_end = std::min(raster_rows - 1, row_end);
+    col_end = std::min(raster_cols - 1, col_end);
+    if (row_begin > row_end || col_begin > col_end)
+        return false;
+
+    // Blocks holding the region's cells; a region of single samples still needs the block of one cell.
+    int block_row_begin = std::min(row_begin, raster_rows - 2) / BLOCK, block_row_end = std::max(row_begin, row_end - 1) / BLOCK;
+    int block_col_begin = std::min(col_begin, raster_cols - 2) / BLOCK, block_col_end = std::max(col_begin, col_end - 1) / BLOCK;
+    block_row_begin = std::max(0, block_row_begin);
+    block_col_begin = std::max(0, block_col_begin);
+
+    // Go up until the region spans a handful of blocks.
+    size_t l = 0;
+    while (l + 1 < levels.size() && (block_row_end - block_row_begin + 1) * (block_col_end - block_col_begin + 1) > 16) {
+        block_row_begin /= 2;
+        block_row_end /= 2;
+        block_col_begin /= 2;
+        block_col_end /= 2;
+        l++;
+    }
+
+    const Level& level = levels[l];
+    block_row_end = std::min(block_row_end, level.rows - 1);
+    block_col_end = std::min(block_col_end, level.cols - 1);
+    float lo = std::numeric_limits<float>::infinity(), hi = -std::numeric_limits<float>::infinity();
+    for (int r = block_row_begin; r <= block_row_end; r++) {
+        for (int c = block_col_begin; c <= block_col_end; c++) {
+            lo = std::min(lo, level.min[r * level.cols + c]);
+            hi = std::max(hi, level.max[r * level.cols + c]);
+        }
+    }
+    if (lo > hi)
+        return false;
+    min_height = lo;
+    max_height = hi;
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef HEIGHT_PYRAMID_H
+#define HEIGHT_PYRAMID_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Min/max mip pyramid of a height raster for conservative height bounds of a region.
+ * Level 0 holds one entry per BLOCK x BLOCK cells and every level above halves both sides.
+ * A block includes the samples on its far edges, so it bounds the bilinear surface of its cells.
+ * NODATA samples are left out; a block without data has min > max.
+ *
+ * Storage is one float array: for each level its min values, then its max values, row by row.
+ * The array is either owned or points into a mapped .sgdem file.
+ */
+class HeightPyramid {
+public:
+    static constexpr int BLOCK = 8;
+
+    struct Level {
+        int rows = 0;
+        int cols = 0;
+        const float* min = nullptr;
+        const float* max = nullptr;
+    };
+
+    /* Builds owned storage from a raster. */
+    void build(const float* raster, int64_t stride, int nrows, int ncols, float nodata_value);
+    /* Uses storage laid out by a previous build (see data()); it has to outlive the pyramid. */
+    void attach(const float* storage, int nrows, int ncols);
+    void clear();
+
+    /* Number of floats in the storage of a raster of this size. */
+    static size_t storage_size(int nrows, int ncols);
+    const float* data() const {
+        return storage_data;
+    }
+
+    bool empty() const {
+        return levels.empty();
+    }
+    const std::vector<Level>& get_levels() const {
+        return levels;
+    }
+
+    /**
+     * Bounds of the heights of samples [row_begin, row_end] x [col_begin, col_end] (inclusive, clamped).
+     * The result may include some samples around the region; it is never tighter than the truth.
+     * @return false if the region has no data.
+     */
+    bool query(int row_begin, int col_begin, int row_end, int col_end, float& min_height, float& max_height) const;
+
+private:
+    void layout(const float* storage, int nrows, int ncols);
+
+    std::vector<Level> levels;
+    std::vector<float> owned;
+    const float* storage_data = nullptr;
+    int raster_rows = 0;
+    int raster_cols = 0;
+};
+
+#endif // HEIGHT_PYRAMID_H
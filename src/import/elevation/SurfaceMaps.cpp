@@ -0,0 +1,84 @@
+#include "SurfaceMaps.h"
+#include "../GeoMap.h"
+#include "../../util/Parallel.h"
+#include <cmath>
+
+size_t SurfaceMaps::storage_size(int nrows, int ncols) {
+    if (nrows <= 0 || ncols <= 0)
+        return 0;
+    return 5 * static_cast<size_t>(nrows) * ncols;
+}
+
+void SurfaceMaps::layout(const float* storage, int nrows, int ncols) {
+    if (storage == nullptr || nrows <= 0 || ncols <= 0) {
+        normals = slopes = curvatures = nullptr;
+        return;
+    }
+    const size_t count = static_cast<size_t>(nrows) * ncols;
+    normals = storage;
+    slopes = storage + 3 * count;
+    curvatures = storage + 4 * count;
+}
+
+void SurfaceMaps::attach(const float* storage, int nrows, int ncols) {
+    owned.clear();
+    owned.shrink_to_fit();
+    layout(storage, nrows, ncols);
+}
+
+void SurfaceMaps::clear() {
+    attach(nullptr, 0, 0);
+}
+
+void SurfaceMaps::build(const float* raster, int64_t stride, int nrows, int ncols, float nodata_value, double top_latitude, double cellsize) {
+    owned.assign(storage_size(nrows, ncols), 0.0f);
+    layout(owned.data(), nrows, ncols);
+    if (empty())
+        return;
+
+    const size_t count = static_cast<size_t>(nrows) * ncols;
+    float* out_normals = owned.data();
+    float* out_slopes = out_normals + 3 * count;
+    float* out_curvatures = out_normals + 4 * count;
+    const double cell_height = cellsize * LATITUDE_DEGREE_IN_METRES;
+
+    parallel_for(static_cast<size_t>(nrows), [&](size_t r, size_t) {
+        const int row = static_cast<int>(r);
+        const double cell_width = cell_height * std::cos((top_latitude - row * cellsize) * Math_PI / 180.0);
+        const float* here = raster + row * stride;
+        const float* north = row > 0 ? here - stride : nullptr;
+        const float* south = row + 1 < nrows ? here + stride : nullptr;
+
+        for (int col = 0; col < ncols; col++) {
+            const size_t i = static_cast<size_t>(row) * ncols + col;
+            const float h = here[col];
+            double gx = 0.0, gz = 0.0, laplacian = 0.0;
+            if (h != nodata_value) {
+                // A missing neighbour takes the height of the sample, which turns the difference one sided.
+                const bool has_w = col > 0 && here[col - 1] != nodata_value;
+                const bool has_e = col + 1 < ncols && here[col + 1] != nodata_value;
+                const bool has_n = north != nullptr && north[col] != nodata_value;
+                const bool has_s = south != nullptr && south[col] != nodata_value;
+                const double w = has_w ? here[col - 1] : h, e = has_e ? here[col + 1] : h;
+                const double n = has_n ? north[col] : h, s = has_s ? south[col] : h;
+                const int x_steps = has_w + has_e, z_steps = has_n + has_s;
+                if (x_steps > 0)
+                    gx = (e - w) / (x_steps * cell_width);
+                if (z_steps > 0)
+                    gz = (s - n) / (z_steps * cell_height);
+                if (x_steps == 2)
+                    laplacian += (e - 2.0 * h + w) / (cell_width * cell_width);
+                if (z_steps == 2)
+                    laplacian += (s - 2.0 * h + n) / (cell_height * cell_height);
+            }
+
+            // The surface y = h(x, z) has the normal (-dh/dx, 1, -dh/dz).
+            const double inverse_length = 1.0 / std::sqrt(gx * gx + gz * gz + 1.0);
+            out_normals[3 * i] = static_cast<float>(-gx * inverse_length);
+            out_normals[3 * i + 1] = static_cast<float>(inverse_length);
+            out_normals[3 * i + 2] = static_cast<float>(-gz * inverse_length);
+            out_slopes[i] = static_cast<float>(std::atan(std::sqrt(gx * gx + gz * gz)) * 180.0 / Math_PI);
+            out_curvatures[i] = static_cast<float>(laplacian);
+        }
+    }, 16);
+}
@@ -0,0 +1,58 @@
+#ifndef SURFACE_MAPS_H
+#define SURFACE_MAPS_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Normal, slope and curvature rasters of a height raster, one value per sample.
+ *
+ * Normals are unit vectors in the local east, up, south frame (the world axes of EquirectangularGeoMap).
+ * Slope is the angle to the horizontal in degrees. Curvature is the Laplacian of the height in 1/m:
+ * positive in hollows, negative on ridges. Derivatives are central differences in metres, with the cell
+ * width taken at the latitude of each row; they are one sided at the border and next to NODATA.
+ *
+ * Storage is one float array: the normals (3 floats per sample), then the slopes, then the curvatures.
+ * The array is either owned or points into a mapped .sgdem file.
+ */
+class SurfaceMaps {
+public:
+    /**
+     * Builds owned storage from a raster.
+     * @param top_latitude Latitude of the first row in degrees.
+     * @param cellsize Cell size in degrees.
+     */
+    void build(const float* raster, int64_t stride, int nrows, int ncols, float nodata_value, double top_latitude, double cellsize);
+    /* Uses storage laid out by a previous build (see data()); it has to outlive the maps. */
+    void attach(const float* storage, int nrows, int ncols);
+    void clear();
+
+    /* Number of floats in the storage of a raster of this size. */
+    static size_t storage_size(int nrows, int ncols);
+    const float* data() const {
+        return normals;
+    }
+
+    bool empty() const {
+        return normals == nullptr;
+    }
+    const float* get_normals() const {
+        return normals;
+    }
+    const float* get_slopes() const {
+        return slopes;
+    }
+    const float* get_curvatures() const {
+        return curvatures;
+    }
+
+private:
+    void layout(const float* storage, int nrows, int ncols);
+
+    std::vector<float> owned;
+    const float* normals = nullptr;
+    const float* slopes = nullptr;
+    const float* curvatures = nullptr;
+};
+
+#endif // SURFACE_MAPS_H
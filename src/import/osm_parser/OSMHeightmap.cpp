@@ -1,9 +1,32 @@
 #include "OSMHeightmap.h"
 #include "../elevation/ElevationParser.h"
 #include <godot_cpp/core/class_db.hpp>
+#include <vector>
 
 using namespace godot;
 
+void OSMHeightmap::getElevations(const double* lon, const double* lat, size_t count, double* out) const {
+    for (size_t i = 0; i < count; i++)
+        out[i] = getElevation(GeoCoords(Longitude::radians(lon[i]), Latitude::radians(lat[i])));
+}
+
+PackedFloat64Array OSMHeightmap::get_elevations(const PackedVector2Array& coords) const {
+    const int64_t count = coords.size();
+    std::vector<double> lon(count), lat(count);
+    for (int64_t i = 0; i < count; i++) {
+        lon[i] = coords[i].x;
+        lat[i] = coords[i].y;
+    }
+    PackedFloat64Array result;
+    result.resize(count);
+    getElevations(lon.data(), lat.data(), static_cast<size_t>(count), result.ptrw());
+    return result;
+}
+
+void OSMHeightmap::_bind_methods() {
+    godot::ClassDB::bind_method(D_METHOD("get_elevations", "coords"), &OSMHeightmap::get_elevations);
+}
+
 ElevationHeightmap::ElevationHeightmap(godot::Ref<ElevationGrid> elevation_grid):
     elevation_grid(elevation_grid){}
 
@@ -11,6 +34,10 @@ double ElevationHeightmap::getElevation(const GeoCoords & coords) const {
     return elevation_grid->bilinearInterpolation(coords);
 }
 
+void ElevationHeightmap::getElevations(const double* lon, const double* lat, size_t count, double* out) const {
+    elevation_grid->sampleBatch(lon, lat, count, out);
+}
+
 void ElevationHeightmap::_bind_methods() {
     godot::ClassDB::bind_method(D_METHOD("get_elevation_vec", "coords"), &ElevationHeightmap::get_elevation_vec);
     godot::ClassDB::bind_method(D_METHOD("set_elevation_grid", "elevation_grid"), &ElevationHeightmap::set_elevation_grid);
@@ -9,8 +9,17 @@ class OSMHeightmap : public godot::RefCounted {
     GDCLASS(OSMHeightmap, godot::RefCounted);
 public:
     virtual double getElevation(const GeoCoords&) const = 0;
+    /* Elevations of many points (radians). The default calls getElevation for each point. */
+    virtual void getElevations(const double* lon, const double* lat, size_t count, double* out) const;
 
-    static void _bind_methods() {}
+    /**
+     * Elevations of many points in one call.
+     * @param coords Geo coordinates in their Vector2 representation.
+     * @return One elevation per point.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::PackedFloat64Array get_elevations(const godot::PackedVector2Array& coords) const;
+
+    static void _bind_methods();
 };
 
 class ElevationHeightmap : public OSMHeightmap {
@@ -19,6 +28,8 @@ public:
     ElevationHeightmap() {}
     ElevationHeightmap(godot::Ref<ElevationGrid> elevation_grid);
     virtual double getElevation(const GeoCoords&) const override;
+    /* One ElevationGrid::sampleBatch pass. */
+    virtual void getElevations(const double* lon, const double* lat, size_t count, double* out) const override;
     double get_elevation_vec(const godot::Vector2& coords) {
         return getElevation(GeoCoords::from_vector2_representation(coords));
     }
@@ -4,6 +4,8 @@
 #include <godot_cpp/classes/file_access.hpp>
 #include <godot_cpp/classes/node.hpp>
 #include <godot_cpp/classes/stream_peer_buffer.hpp>
+#include <algorithm>
+#include <cmath>
 #include <thread>
 
 #define MIN_INT 1 << 31
@@ -15,7 +17,7 @@ godot::Ref<GeoMap> OSMParser::import(godot::Ref<GeoMap> geomap, godot::Ref<OSMHe
     ParserInfo pi;
 
     pi.geomap = geomap;
-    pi.tilemap = godot::Ref<TileMapBase>(memnew(EquirectangularTileMap));
+    pi.tilemap = tilemap.is_valid() ? tilemap : godot::Ref<TileMapBase>(memnew(EquirectangularTileMap));
     pi.heightmap = heightmap;
     pi.parser->open(filename);
 
@@ -31,6 +33,8 @@ godot::Ref<GeoMap> OSMParser::import(godot::Ref<GeoMap> geomap, godot::Ref<OSMHe
             pi.reqs->merge(req);
     }
 
+    compile_selectors(pi);
+
     int print_line = 0;
     while (pi.parser->read() == 0) {
         XMLParser::NodeType cur_node_type = pi.parser->get_node_type();
@@ -47,6 +51,7 @@ godot::Ref<GeoMap> OSMParser::import(godot::Ref<GeoMap> geomap, godot::Ref<OSMHe
         if (xml_node_finished)
             parse_xml_node_end(pi);
     }
+    flush_nodes(pi);
 
     //_ASSERT(pi.xml_stack.is_empty());
     
@@ -55,6 +60,12 @@ godot::Ref<GeoMap> OSMParser::import(godot::Ref<GeoMap> geomap, godot::Ref<OSMHe
                 String::num_int64(pi.world.ways.size()) + " ways; " +
                 String::num_int64(pi.world.relations.size()) + " relations.");
 
+    // Nodes that build geometry once every element is in (e.g. roads) need the projection and terrain the positions came from.
+    for (int i = 0; i < shader_nodes.size(); i++) {
+        if (Object::cast_to<Node>(shader_nodes[i])->has_method("import_context"))
+            Object::cast_to<Node>(shader_nodes[i])->call("import_context", pi.geomap, pi.heightmap);
+    }
+
     for (int i = 0; i < shader_nodes.size(); i++) {
         Object::cast_to<Node>(shader_nodes[i])->call("import_finished");
     }
@@ -136,8 +147,10 @@ bool OSMParser::parse_xml_node(ParserInfo &pi) {
     }
     
 
-    if (element_type == "bounds")
+    if (element_type == "bounds") {
+        flush_nodes(pi);
         parse_bounds(pi);
+    }
     else if (element_type == "node")
         parse_node(pi, d);
     else if (element_type == "way")
@@ -171,14 +184,83 @@ bool OSMParser::parse_xml_node(ParserInfo &pi) {
 
 void OSMParser::parse_xml_node_end(ParserInfo &pi) {
     Dictionary item = pi.xml_stack.back();
+    pi.xml_stack.pop_back();
     const String element_type = item["element_type"].stringify();
-    auto shader_nodes = this->get_shader_nodes();
 
-    if (element_type != "node" && element_type != "way" && element_type != "relation") {
-        pi.xml_stack.pop_back();
+    if (element_type == "node") {
+        pi.pending_nodes.push_back(item);
+        if (pi.pending_nodes.size() >= NODE_BATCH)
+            flush_nodes(pi);
+    } else if (element_type == "way" || element_type == "relation") {
+        // Ways and relations look up the nodes they reference.
+        flush_nodes(pi);
+        import_element(pi, element_type, item);
+    }
+}
+
+void OSMParser::flush_nodes(ParserInfo &pi) {
+    if (pi.pending_nodes.empty())
         return;
+
+    if (pi.heightmap.is_valid()) {
+        const size_t count = pi.pending_nodes.size();
+        std::vector<Vector2> geo(count);
+        for (size_t i = 0; i < count; i++)
+            geo[i] = pi.pending_nodes[i]["pos_geo"];
+
+        // Row-major order (north to south in rows of 3", then west to east) keeps raster reads close together.
+        const double ROW_RADIANS = Math_PI / 180.0 / 1200.0;
+        std::vector<uint32_t> order(count);
+        std::vector<int64_t> row(count);
+        for (size_t i = 0; i < count; i++) {
+            order[i] = static_cast<uint32_t>(i);
+            row[i] = static_cast<int64_t>(std::floor(-geo[i].y / ROW_RADIANS));
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return row[a] != row[b] ? row[a] < row[b] : geo[a].x < geo[b].x;
+        });
+
+        std::vector<double> lon(count), lat(count), elevation(count);
+        for (size_t k = 0; k < count; k++) {
+            lon[k] = geo[order[k]].x;
+            lat[k] = geo[order[k]].y;
+        }
+        pi.heightmap->getElevations(lon.data(), lat.data(), count, elevation.data());
+        for (size_t k = 0; k < count; k++) {
+            Dictionary& node = pi.pending_nodes[order[k]];
+            node["pos_elevation"] = static_cast<Vector3>(node["pos"]) + static_cast<Vector3>(node["up"]) * elevation[k];
+        }
     }
 
+    for (Dictionary& node : pi.pending_nodes)
+        import_element(pi, "node", node);
+    pi.pending_nodes.clear();
+}
+
+void OSMParser::compile_selectors(ParserInfo &pi) {
+    auto shader_nodes = this->get_shader_nodes();
+
+    pi.selectors.clear();
+    pi.node_selectors.assign(shader_nodes.size(), -1);
+    for (int i = 0; i < shader_nodes.size(); i++) {
+        Node* node = Object::cast_to<Node>(shader_nodes[i]);
+        if (!node->has_method("get_selector"))
+            continue;
+
+        const String source = node->call("get_selector");
+        if (source.strip_edges().is_empty())
+            continue;
+
+        String error;
+        pi.node_selectors[i] = pi.selectors.add(source, error);
+        if (pi.node_selectors[i] < 0)
+            WARN_PRINT("Invalid selector of " + String(node->get_name()) + ": " + error + ". It will get every element.");
+    }
+}
+
+void OSMParser::import_element(ParserInfo &pi, const String& element_type, Dictionary& item) {
+    auto shader_nodes = this->get_shader_nodes();
+
     Vector2i tile = get_element_tile(element_type, pi, item);
     if (!pi.tile_bytes.has(tile)) {
         Array fas;
@@ -189,28 +271,34 @@ void OSMParser::parse_xml_node_end(ParserInfo &pi) {
     }
     auto tile_fas = static_cast<Array>(pi.tile_bytes[tile]);
 
+    // Tags are matched once per element, not once per shader node.
+    if (pi.selectors.size() > 0)
+        pi.selectors.match(TagSelector::element_type(element_type), item, pi.matched);
+    auto wants = [&pi](int i) {
+        return pi.node_selectors[i] < 0 || pi.matched[pi.node_selectors[i]];
+    };
 
     if (element_type == "node") {
         pi.world.nodes[(int64_t)item["id"]] = item;
         for (int i = 0; i < tile_fas.size(); i++) {
-            Object::cast_to<Node>(shader_nodes[i])->call("import_node", item, tile_fas[i]);
-
+            if (wants(i))
+                Object::cast_to<Node>(shader_nodes[i])->call("import_node", item, tile_fas[i]);
         }
         //Error res = sg_import.emit_signal("import_node", item, *pi.tile_bytes[tile]);
     } else if (element_type == "way") {
         
         pi.world.ways[(int64_t)item["id"]] = item;  
         for (int i = 0; i < tile_fas.size(); i++) {
-            Object::cast_to<Node>(shader_nodes[i])->call("import_way", item, tile_fas[i]);
+            if (wants(i))
+                Object::cast_to<Node>(shader_nodes[i])->call("import_way", item, tile_fas[i]);
         }
     } else if (element_type == "relation") {
         pi.world.relations[(int64_t)item["id"]] = item;
         for (int i = 0; i < tile_fas.size(); i++) {
-            Object::cast_to<Node>(shader_nodes[i])->call("import_relation", item, tile_fas[i]);
+            if (wants(i))
+                Object::cast_to<Node>(shader_nodes[i])->call("import_relation", item, tile_fas[i]);
         }
     }
-    
-    pi.xml_stack.pop_back();
 }
 
 double lerp(double a, double b, double t) {
@@ -237,13 +325,14 @@ void OSMParser::parse_bounds(ParserInfo & pi) {
 void OSMParser::parse_node(ParserInfo & pi, Dictionary& d) {
     GeoCoords coords(Longitude::degrees(pi.parser->get_named_attribute_value("lon").to_float()),
                      Latitude::degrees(pi.parser->get_named_attribute_value("lat").to_float()));
-    Vector3 pos = pi.geomap->geo_to_world(coords);
-    Vector3 up = pi.geomap->geo_to_world_up(coords);
+    Vector3 pos, up;
+    pi.geomap->geo_to_world_and_up(coords, pos, up);
 
     d["pos"] = pos;
     d["pos_geo"] = coords.to_vector2_representation();
     d["up"] = up;
-    d["pos_elevation"] = pi.heightmap.is_valid() ? pos + up * pi.heightmap->getElevation(coords) : pos;
+    // With a heightmap this is replaced in flush_nodes, once the elevation of a whole batch is known.
+    d["pos_elevation"] = pos;
 }
 
 Vector2i OSMParser::get_element_tile(const String& element_type, ParserInfo& pi, Dictionary& element) {
@@ -335,11 +424,15 @@ void OSMParser::_bind_methods() {
     ClassDB::bind_method(D_METHOD("load_tiles", "plsrefactor"), &OSMParser::load_tiles);
     ClassDB::bind_method(D_METHOD("get_true"), &OSMParser::get_true);
 
+    ClassDB::bind_method(D_METHOD("set_tilemap", "value"), &OSMParser::set_tilemap);
+    ClassDB::bind_method(D_METHOD("get_tilemap"), &OSMParser::get_tilemap);
+
     ClassDB::bind_method(D_METHOD("set_test_index_to_load", "value"), &OSMParser::set_test_index_to_load);
     ClassDB::bind_method(D_METHOD("get_test_index_to_load"), &OSMParser::get_test_index_to_load);
     ClassDB::bind_method(D_METHOD("load_tile_test"), &OSMParser::load_tile_test);
 
     ADD_PROPERTY(PropertyInfo(Variant::STRING, "filename", PROPERTY_HINT_FILE, "*.osm"), "set_filename", "get_filename");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "tilemap", PROPERTY_HINT_RESOURCE_TYPE, "TileMapBase"), "set_tilemap", "get_tilemap");
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "load_all_tiles"), "load_tiles", "get_true");
     ADD_PROPERTY(PropertyInfo(Variant::INT, "test_index_to_load"), "set_test_index_to_load", "get_test_index_to_load");
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "load_tile_test"), "load_tile_test", "get_true");
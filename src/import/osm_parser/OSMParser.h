@@ -4,6 +4,7 @@
 #include "../Parser.h"
 #include "../../util/GlobalRequirements.h"
 #include "OSMHeightmap.h"
+#include "TagSelector.h"
 #include "../TileMap.h"
 
 #include <godot_cpp/variant/string.hpp>
@@ -11,6 +12,7 @@
 #include <godot_cpp/classes/xml_parser.hpp>
 #include <godot_cpp/templates/hash_map.hpp>
 #include <godot_cpp/templates/vector.hpp>
+#include <vector>
 
 
 class OSMParser : public Parser {
@@ -42,6 +44,14 @@ public:
         return filename;
     }
 
+    /* Tiling scheme used to split the map into tiles. Defaults to EquirectangularTileMap. */
+    void set_tilemap(const godot::Ref<TileMapBase>& value) {
+        tilemap = value;
+    }
+    godot::Ref<TileMapBase> get_tilemap() const {
+        return tilemap;
+    }
+
     void set_test_index_to_load(int value) {
         test_index_to_load = value;
     }
@@ -63,6 +73,12 @@ private:
         godot::Ref<OSMHeightmap> heightmap;
         godot::Dictionary tile_bytes; // Vector2 -> Array of Ref<StreamPeerBuffer>
         World world;
+        /* Parsed nodes waiting for their elevation (see flush_nodes). */
+        std::vector<godot::Dictionary> pending_nodes;
+        /* Selectors of the shader nodes; node_selectors[i] is -1 for nodes that take every element. */
+        TagSelector selectors;
+        std::vector<int32_t> node_selectors;
+        std::vector<uint8_t> matched;
         ParserInfo() : parser(memnew(godot::XMLParser)), geomap(nullptr), tilemap(nullptr), heightmap(nullptr) {}
     };
     /* Returns true if this is the deepest node (if we have to pop). */
@@ -70,6 +86,15 @@ private:
 
     void parse_xml_node_end(ParserInfo&);
 
+    /* Nodes are sampled from the heightmap in batches of this many. */
+    static constexpr size_t NODE_BATCH = 4096;
+    /* Samples the elevations of the pending nodes in one batch, then passes them to the shader nodes. */
+    void flush_nodes(ParserInfo&);
+    /* Compiles the selectors returned by the optional get_selector() of every shader node. */
+    void compile_selectors(ParserInfo&);
+    /* Stores a finished element and passes it to the shader nodes whose selector it matches. */
+    void import_element(ParserInfo&, const godot::String& element_type, godot::Dictionary& item);
+
     // parse_xml_node helpers
     void parse_bounds(ParserInfo&);
     void parse_node(ParserInfo&, godot::Dictionary& d);
@@ -78,6 +103,7 @@ private:
 
     // Fields
     godot::String filename;
+    godot::Ref<TileMapBase> tilemap;
 
     int test_index_to_load;
 };
@@ -0,0 +1,233 @@
+#include "TagSelector.h"
+
+using namespace godot;
+
+namespace {
+    struct ParsedTest {
+        String key;
+        String value;
+        enum { PRESENT, ABSENT, EQUAL, NOT_EQUAL } op;
+    };
+
+    struct ParsedRule {
+        uint8_t types;
+        std::vector<ParsedTest> tests;
+    };
+
+    class SelectorReader {
+    public:
+        SelectorReader(const String& source) : src(source), len(source.length()) {}
+
+        bool read(std::vector<ParsedRule>& out, String& error) {
+            do {
+                ParsedRule rule;
+                if (!read_rule(rule, error))
+                    return false;
+                out.push_back(std::move(rule));
+            } while (accept(','));
+
+            skip_spaces();
+            if (pos < len)
+                return fail("unexpected '" + String::chr(src[pos]) + "'", error);
+            return true;
+        }
+
+    private:
+        bool read_rule(ParsedRule& rule, String& error) {
+            skip_spaces();
+            if (accept('*')) {
+                rule.types = TagSelector::ELEMENT_ANY;
+            } else {
+                const int64_t start = pos;
+                while (pos < len && is_alpha(src[pos]))
+                    pos++;
+                const String name = src.substr(start, pos - start);
+                rule.types = TagSelector::element_type(name);
+                if (rule.types == 0)
+                    return fail(name.is_empty() ? String("expected an element type") : "unknown element type \"" + name + "\"", error);
+            }
+
+            while (pos < len && src[pos] == '[') {
+                pos++;
+                ParsedTest test;
+                const bool negated = accept('!');
+                if (!read_word(test.key, error))
+                    return false;
+
+                if (accept(']')) {
+                    test.op = negated ? ParsedTest::ABSENT : ParsedTest::PRESENT;
+                } else {
+                    if (negated)
+                        return fail("[!key] takes no value", error);
+                    if (accept('=')) {
+                        test.op = ParsedTest::EQUAL;
+                    } else if (pos + 1 < len && src[pos] == '!' && src[pos + 1] == '=') {
+                        pos += 2;
+                        test.op = ParsedTest::NOT_EQUAL;
+                    } else {
+                        return fail("expected ']', '=' or '!='", error);
+                    }
+                    if (!read_word(test.value, error))
+                        return false;
+                    if (!accept(']'))
+                        return fail("expected ']'", error);
+                }
+                rule.tests.push_back(std::move(test));
+            }
+            return true;
+        }
+
+        /* A quoted string, or everything up to the next bracket, operator or comma, trimmed. */
+        bool read_word(String& out, String& error) {
+            skip_spaces();
+            if (pos < len && (src[pos] == '"' || src[pos] == '\'')) {
+                const char32_t quote = src[pos++];
+                const int64_t start = pos;
+                while (pos < len && src[pos] != quote)
+                    pos++;
+                if (pos == len)
+                    return fail("unterminated string", error);
+                out = src.substr(start, pos - start);
+                pos++;
+                skip_spaces();
+                return true;
+            }
+
+            const int64_t start = pos;
+            while (pos < len && !is_special(src[pos]))
+                pos++;
+            out = src.substr(start, pos - start).strip_edges();
+            if (out.is_empty())
+                return fail("expected a key or value", error);
+            return true;
+        }
+
+        bool accept(char32_t c) {
+            skip_spaces();
+            if (pos < len && src[pos] == c) {
+                pos++;
+                return true;
+            }
+            return false;
+        }
+
+        void skip_spaces() {
+            while (pos < len && (src[pos] == ' ' || src[pos] == '\t' || src[pos] == '\n' || src[pos] == '\r'))
+                pos++;
+        }
+
+        bool fail(const String& message, String& error) const {
+            error = message + " at column " + String::num_int64(pos + 1);
+            return false;
+        }
+
+        static bool is_alpha(char32_t c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+
+        static bool is_special(char32_t c) {
+            return c == '[' || c == ']' || c == '=' || c == '!' || c == ',' || c == '"' || c == '\'';
+        }
+
+        const String& src;
+        const int64_t len;
+        int64_t pos = 0;
+    };
+}
+
+uint8_t TagSelector::element_type(const String& name) {
+    if (name == "node")
+        return ELEMENT_NODE;
+    if (name == "way")
+        return ELEMENT_WAY;
+    if (name == "relation")
+        return ELEMENT_RELATION;
+    return 0;
+}
+
+int32_t TagSelector::add(const String& source, String& error) {
+    std::vector<ParsedRule> parsed;
+    if (!SelectorReader(source).read(parsed, error))
+        return -1;
+
+    const int32_t selector = selector_count++;
+    for (const ParsedRule& p : parsed) {
+        Rule rule;
+        rule.selector = selector;
+        rule.types = p.types;
+        for (const ParsedTest& test : p.tests) {
+            const int32_t key = intern(test.key);
+            switch (test.op) {
+                case ParsedTest::PRESENT:
+                    set_bit(rule.required, key);
+                    break;
+                case ParsedTest::ABSENT:
+                    set_bit(rule.forbidden, key);
+                    break;
+                case ParsedTest::EQUAL:
+                    // The value test alone would do, the bit rejects elements without the tag before any string compare.
+                    set_bit(rule.required, key);
+                    rule.values.push_back({key, test.value, false});
+                    break;
+                case ParsedTest::NOT_EQUAL:
+                    rule.values.push_back({key, test.value, true});
+                    break;
+            }
+        }
+        rules.push_back(std::move(rule));
+    }
+    return selector;
+}
+
+void TagSelector::match(uint8_t type, const Dictionary& item, std::vector<uint8_t>& out) {
+    out.assign(selector_count, 0);
+
+    present.assign((keys.size() + 63) / 64, 0);
+    values.resize(keys.size());
+    for (size_t k = 0; k < keys.size(); k++) {
+        values[k] = item.get(keys[k], Variant());
+        if (values[k].get_type() != Variant::NIL)
+            present[k / 64] |= uint64_t(1) << (k % 64);
+    }
+
+    for (const Rule& rule : rules) {
+        if (out[rule.selector] || !(rule.types & type))
+            continue;
+
+        bool ok = true;
+        for (size_t w = 0; ok && w < rule.required.size(); w++)
+            ok = (present[w] & rule.required[w]) == rule.required[w];
+        for (size_t w = 0; ok && w < rule.forbidden.size(); w++)
+            ok = (present[w] & rule.forbidden[w]) == 0;
+        for (size_t t = 0; ok && t < rule.values.size(); t++) {
+            const ValueTest& test = rule.values[t];
+            const Variant& value = values[test.key];
+            const bool equal = value.get_type() != Variant::NIL && static_cast<String>(value) == test.value;
+            ok = equal != test.negate;
+        }
+        if (ok)
+            out[rule.selector] = 1;
+    }
+}
+
+void TagSelector::clear() {
+    key_index.clear();
+    keys.clear();
+    rules.clear();
+    selector_count = 0;
+}
+
+int32_t TagSelector::intern(const String& key) {
+    if (const int32_t* index = key_index.getptr(key))
+        return *index;
+    const int32_t index = static_cast<int32_t>(keys.size());
+    key_index.insert(key, index);
+    keys.push_back(key);
+    return index;
+}
+
+void TagSelector::set_bit(std::vector<uint64_t>& mask, int32_t bit) {
+    if (mask.size() <= static_cast<size_t>(bit / 64))
+        mask.resize(bit / 64 + 1, 0);
+    mask[bit / 64] |= uint64_t(1) << (bit % 64);
+}
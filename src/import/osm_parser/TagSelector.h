@@ -0,0 +1,88 @@
+#ifndef TAGSELECTOR_H
+#define TAGSELECTOR_H
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compiled MapCSS-like selectors deciding which shader nodes an OSM element is passed to.
+ *
+ * A selector is a comma separated list of rules, each an element type ("node", "way", "relation" or "*")
+ * followed by tag tests:
+ *   [key]         the tag is set
+ *   [!key]        the tag is not set
+ *   [key=value]   the tag is set to value
+ *   [key!=value]  the tag is not set, or set to something else
+ * e.g. "node, way[building][!building:part], way[highway=primary]". Keys and values containing
+ * brackets, commas or spaces can be quoted.
+ *
+ * All selectors added to one TagSelector share a key table: every key is interned once, presence tests
+ * become bitmask comparisons and an element's tags are looked up once per key, however many rules use it.
+ */
+class TagSelector {
+public:
+    enum ElementType : uint8_t {
+        ELEMENT_NODE = 1,
+        ELEMENT_WAY = 2,
+        ELEMENT_RELATION = 4,
+        ELEMENT_ANY = ELEMENT_NODE | ELEMENT_WAY | ELEMENT_RELATION
+    };
+
+    /**
+     * Compiles a selector.
+     * @param error Receives the reason and position if the selector is malformed.
+     * @return Index of the selector in the output of match, or -1 on error (nothing is added then).
+     */
+    int32_t add(const godot::String& source, godot::String& error);
+
+    /* Number of selectors added. */
+    int32_t size() const {
+        return selector_count;
+    }
+
+    /* 0 for element types other than "node", "way" and "relation". */
+    static uint8_t element_type(const godot::String& name);
+
+    /**
+     * Tests an element against every selector.
+     * @param type One of ElementType.
+     * @param item The element; tags are its String keys (see OSMParser::parse_xml_node).
+     * @param out Resized to size(), receives 1 for every selector with a matching rule.
+     */
+    void match(uint8_t type, const godot::Dictionary& item, std::vector<uint8_t>& out);
+
+    void clear();
+
+private:
+    struct ValueTest {
+        int32_t key;
+        godot::String value;
+        /* [key!=value] */
+        bool negate;
+    };
+
+    struct Rule {
+        int32_t selector;
+        uint8_t types;
+        /* Bit k stands for keys[k]; words past the end are 0. */
+        std::vector<uint64_t> required;
+        std::vector<uint64_t> forbidden;
+        std::vector<ValueTest> values;
+    };
+
+    int32_t intern(const godot::String& key);
+    static void set_bit(std::vector<uint64_t>& mask, int32_t bit);
+
+    godot::HashMap<godot::String, int32_t> key_index;
+    std::vector<godot::String> keys;
+    std::vector<Rule> rules;
+    int32_t selector_count = 0;
+
+    // match scratch
+    std::vector<uint64_t> present;
+    std::vector<godot::Variant> values;
+};
+
+#endif // TAGSELECTOR_H
@@ -3,12 +3,19 @@
 
 #include "import/osm_parser/OSMParser.h"
 #include "import/elevation/ElevationParser.h"
+#include "import/elevation/ElevationMosaic.h"
 #include "import/coastline/CoastlineParser.h"
+#include "import/coastline/CoastMask.h"
 
 
 #include "import/SGImport.h"
 #define P2T_STATIC_EXPORTS
 #include "util/PolyUtil.h"
+#include "util/BuildingMesher.h"
+#include "util/RoadMesher.h"
+#include "util/TerrainMesher.h"
+#include "util/MeshOptimizer.h"
+#include "util/GeometryCodec.h"
 #include "util/GlobalRequirementsBuilder.h"
 
 #include <gdextension_interface.h>
@@ -34,10 +41,17 @@ void initialize_mapshaders(ModuleInitializationLevel p_level) {
 
 	ClassDB::register_abstract_class<TileMapBase>();
 	ClassDB::register_class<EquirectangularTileMap>();
+	ClassDB::register_class<QuadkeyTileMap>();
+	ClassDB::register_class<CubeSphereTileMap>();
 
 	ClassDB::register_class<ElevationGrid>();
 	ClassDB::register_class<SkeletonSubtree>();
 	ClassDB::register_class<PolyUtil>();
+	ClassDB::register_class<BuildingMesher>();
+	ClassDB::register_class<RoadMesher>();
+	ClassDB::register_class<TerrainMesher>();
+	ClassDB::register_class<MeshOptimizer>();
+	ClassDB::register_class<GeometryCodec>();
 	ClassDB::register_class<GlobalRequirements>();
 	ClassDB::register_class<GlobalRequirementsBuilder>();
 
@@ -45,9 +59,11 @@ void initialize_mapshaders(ModuleInitializationLevel p_level) {
 	ClassDB::register_class<OSMParser>();
 	ClassDB::register_class<ElevationParser>();
 	ClassDB::register_class<CoastlineParser>();
+	ClassDB::register_class<CoastMask>();
 
 	ClassDB::register_abstract_class<OSMHeightmap>();
 	ClassDB::register_class<ElevationHeightmap>();
+	ClassDB::register_class<ElevationMosaic>();
 }
 void uninitialize_mapshaders(ModuleInitializationLevel p_level)
 {
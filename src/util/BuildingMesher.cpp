@@ -0,0 +1,441 @@
+#include "BuildingMesher.h"
+#include "Parallel.h"
+#include "PolyUtil.h"
+#include <algorithm>
+#include <deque>
+
+using namespace godot;
+
+namespace {
+    const Vector3 UP(0.0, 1.0, 0.0);
+
+    BuildingMesher::RoofType get_roof_type(const String& code) {
+        if (code == "pyramidal")
+            return BuildingMesher::ROOF_PYRAMIDAL;
+        if (code == "skillion")
+            return BuildingMesher::ROOF_SKILLION;
+        if (code == "hipped")
+            return BuildingMesher::ROOF_HIPPED;
+        if (code == "gabled")
+            return BuildingMesher::ROOF_GABLED;
+        return BuildingMesher::ROOF_FLAT;
+    }
+
+    Color osm_to_gd_color(const String& code) {
+        return Color::from_string(code.replace("grey", "gray"), Color(1.0, 1.0, 1.0));
+    }
+
+    double tag_to_float(const Dictionary& tags, const char* key, const char* default_value) {
+        const String value = tags.get(key, default_value);
+        return value.to_float();
+    }
+
+    Vector2 flat(const Vector3& v) {
+        return Vector2(v.x, v.z);
+    }
+
+    std::vector<Vector2> flat_ring(const std::vector<Vector3>& ring) {
+        std::vector<Vector2> out;
+        out.reserve(ring.size());
+        for (const auto& v : ring)
+            out.push_back(flat(v));
+        return out;
+    }
+
+    /* Collects the geometry of one worker; buffers are keyed by color. */
+    struct MeshSink {
+        std::vector<BuildingMesher::MeshBuffer> buffers;
+
+        BuildingMesher::MeshBuffer& get(const Color& color) {
+            for (auto& buffer : buffers) {
+                if (buffer.color == color)
+                    return buffer;
+            }
+            buffers.emplace_back();
+            buffers.back().color = color;
+            return buffers.back();
+        }
+    };
+
+    void push_vertex(BuildingMesher::MeshBuffer& buffer, const Vector3& v, const Vector3& normal, const Vector2& uv) {
+        buffer.vertices.push_back(v);
+        buffer.normals.push_back(normal);
+        buffer.uvs.push_back(uv);
+    }
+
+    /* Port of RenderUtil.wall_poly_np. */
+    void mesh_walls(const BuildingMesher::Building& b, BuildingMesher::MeshBuffer& out) {
+        const auto& nodes = b.footprint;
+        if (nodes.size() < 3)
+            return;
+
+        const size_t edge_count = b.closed ? nodes.size() : nodes.size() - 1;
+        const Vector3 min_vec(0.0, b.min_height, 0.0), max_vec(0.0, b.max_height, 0.0);
+        real_t uv_x_length_so_far = 0.0;
+
+        for (size_t i = 0; i < edge_count; i++) {
+            const Vector3& v_this = nodes[i];
+            const Vector3& v_next = nodes[(i + 1) % nodes.size()];
+
+            const Vector3 verts[6] = { v_this + min_vec, v_next + min_vec, v_next + max_vec,
+                                       v_this + min_vec, v_next + max_vec, v_this + max_vec };
+            const real_t verts_uv_x[6] = { 0, 1, 1, 0, 1, 0 };
+
+            const Vector3 normal = Vector3(v_next.x - v_this.x, 0.0, v_next.z - v_this.z).cross(-UP).normalized();
+            const real_t edge_length = (v_next - v_this).length();
+
+            for (int j = 0; j < 6; j++)
+                push_vertex(out, verts[j], normal, Vector2(uv_x_length_so_far + verts_uv_x[j] * edge_length, verts[j].y));
+
+            uv_x_length_so_far += edge_length;
+        }
+    }
+
+    /* Port of RenderUtil.polygon. */
+    void mesh_flat_roof(const BuildingMesher::Building& b, BuildingMesher::MeshBuffer& out) {
+        std::vector<int> indices;
+        if (!PolyUtil::triangulate(flat_ring(b.footprint), {}, indices))
+            return;
+
+        for (int index : indices) {
+            const Vector3 v = b.footprint[index] + Vector3(0.0, b.max_height, 0.0);
+            push_vertex(out, v, UP, Vector2(v.x, v.z) * 0.05);
+        }
+    }
+
+    /* Port of RenderUtil.pyramid. */
+    void mesh_pyramidal_roof(const BuildingMesher::Building& b, double height, BuildingMesher::MeshBuffer& out) {
+        const auto& verts = b.footprint;
+        const Vector3 min_height_vec(0.0, b.max_height, 0.0);
+
+        Vector3 tip;
+        for (const auto& v : verts)
+            tip += v;
+        tip /= static_cast<real_t>(verts.size());
+        tip.y += height + b.max_height;
+
+        real_t uv_x_length_so_far = 0.0;
+        for (size_t i = 0; i < verts.size(); i++) {
+            const Vector3& v1 = verts[i];
+            const Vector3& v2 = verts[(i + 1) % verts.size()];
+
+            const Vector3 normal = -(v2 - v1).cross(tip - v1).normalized();
+            const real_t edge_length = (v2 - v1).length();
+            const real_t triangle_height = ((v1 + v2) / 2.0).distance_to(tip);
+
+            push_vertex(out, v1 + min_height_vec, normal, Vector2(uv_x_length_so_far, 0.0));
+            push_vertex(out, v2 + min_height_vec, normal, Vector2(uv_x_length_so_far + edge_length, 0.0));
+            push_vertex(out, tip, normal, Vector2(uv_x_length_so_far + edge_length / 2.0, triangle_height));
+
+            uv_x_length_so_far += edge_length;
+        }
+    }
+
+    /* Port of RenderUtil.skillion. */
+    void mesh_skillion_roof(const BuildingMesher::Building& b, double height, BuildingMesher::MeshBuffer& out) {
+        const std::vector<Vector2> nodes_2d = flat_ring(b.footprint);
+        std::vector<int> indices;
+        if (!PolyUtil::triangulate(nodes_2d, {}, indices))
+            return;
+
+        Vector2 dir_vec = Vector2::from_angle(Math_PI / 2.0 - Math::deg_to_rad(b.roof_direction));
+        dir_vec.x *= -1.0;
+
+        real_t min_proj = nodes_2d[0].dot(dir_vec), max_proj = min_proj;
+        for (const auto& v : nodes_2d) {
+            min_proj = std::min(min_proj, v.dot(dir_vec));
+            max_proj = std::max(max_proj, v.dot(dir_vec));
+        }
+        const real_t proj_range = max_proj - min_proj > 0.0 ? max_proj - min_proj : 1.0;
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            Vector3 vs[3];
+            for (int j = 0; j < 3; j++) {
+                const int v_index = indices[i + j];
+                const real_t slope = (nodes_2d[v_index].dot(dir_vec) - min_proj) / proj_range;
+                vs[j] = b.footprint[v_index] + Vector3(0.0, b.max_height + height * slope, 0.0);
+            }
+
+            Vector3 normal = (vs[2] - vs[1]).cross(vs[1] - vs[0]).normalized();
+            if (normal.y < 0.0)
+                normal = -normal;
+
+            for (const auto& v : vs)
+                push_vertex(out, v, normal, Vector2(v.x, v.z) * 0.05);
+        }
+    }
+
+    /* Returns -1 if p is not the source of any subtree. */
+    int find_subtree(const std::vector<PolyUtil::Subtree>& subtrees, const Vector2& p) {
+        for (size_t i = 0; i < subtrees.size(); i++) {
+            if (subtrees[i].source == p)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    bool has_sink(const PolyUtil::Subtree& subtree, const Vector2& p) {
+        return std::find(subtree.sinks.begin(), subtree.sinks.end(), p) != subtree.sinks.end();
+    }
+
+    /* Port of RenderUtil.hipped; walks the skeleton between the two corners of every edge. */
+    void mesh_hipped_roof(const BuildingMesher::Building& b, bool gabled, BuildingMesher::MeshBuffer& out) {
+        std::vector<Vector2> nodes_2d = flat_ring(b.footprint);
+        if (nodes_2d.size() < 3)
+            return;
+
+        // Same winding as RenderUtil.enforce_winding(verts, false).
+        {
+            Vector2 mid;
+            for (const auto& v : nodes_2d)
+                mid += v;
+            mid /= static_cast<real_t>(nodes_2d.size());
+
+            double winding_val = 0.0;
+            for (size_t i = 0; i < nodes_2d.size(); i++) {
+                const Vector2 cur = nodes_2d[i] - mid;
+                const Vector2 next = nodes_2d[(i + 1) % nodes_2d.size()] - mid;
+                winding_val += (next.x - cur.x) * (next.y + cur.y);
+            }
+            if (winding_val < 0.0)
+                std::reverse(nodes_2d.begin(), nodes_2d.end());
+        }
+
+        double base_y = 0.0;
+        for (const auto& v : b.footprint)
+            base_y += v.y;
+        base_y = base_y / b.footprint.size() + b.max_height;
+
+        std::vector<PolyUtil::Subtree> subtrees = PolyUtil::skeletonize(nodes_2d, {});
+        if (gabled)
+            PolyUtil::hipped_to_gabled(subtrees);
+
+        for (size_t i = 0; i < nodes_2d.size(); i++) {
+            const Vector2 v1 = nodes_2d[i];
+            const Vector2 v2 = nodes_2d[(i + 1) % nodes_2d.size()];
+
+            // BFS over subtrees, from the one touching v1 to the one touching v2.
+            std::deque<std::vector<int>> queue;
+            std::vector<bool> visited(subtrees.size(), false);
+            std::vector<int> subtrees_to_v2;
+
+            for (size_t s = 0; s < subtrees.size(); s++) {
+                const auto& sinks = subtrees[s].sinks;
+                if (std::any_of(sinks.begin(), sinks.end(), [&v1](const Vector2& sink) { return sink.is_equal_approx(v1); })) {
+                    queue.push_back({ static_cast<int>(s) });
+                    visited[s] = true;
+                    break;
+                }
+            }
+
+            while (!queue.empty()) {
+                std::vector<int> nodes_so_far = std::move(queue.front());
+                queue.pop_front();
+                const PolyUtil::Subtree& current = subtrees[nodes_so_far.back()];
+
+                if (has_sink(current, v2)) {
+                    subtrees_to_v2 = std::move(nodes_so_far);
+                    break;
+                }
+
+                auto enqueue = [&](int neighbor) {
+                    if (visited[neighbor])
+                        return;
+                    visited[neighbor] = true;
+                    queue.push_back(nodes_so_far);
+                    queue.back().push_back(neighbor);
+                };
+
+                for (const auto& sink : current.sinks) {
+                    const int neighbor = find_subtree(subtrees, sink);
+                    if (neighbor >= 0)
+                        enqueue(neighbor);
+                }
+                for (size_t s = 0; s < subtrees.size(); s++) {
+                    if (has_sink(subtrees[s], current.source))
+                        enqueue(static_cast<int>(s));
+                }
+            }
+
+            // Face polygon: v1, skeleton nodes, v2.
+            std::vector<Vector2> poly;
+            std::vector<real_t> heights;
+            poly.push_back(v1);
+            heights.push_back(0.0);
+            for (int s : subtrees_to_v2) {
+                poly.push_back(subtrees[s].source);
+                heights.push_back(subtrees[s].height);
+            }
+            poly.push_back(v2);
+            heights.push_back(0.0);
+
+            std::vector<int> indices;
+            if (poly.size() == 3)
+                indices = { 0, 1, 2 };
+            else if (!PolyUtil::triangulate(poly, {}, indices))
+                continue;
+
+            for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+                Vector3 vs[3];
+                for (int j = 0; j < 3; j++) {
+                    const int v_index = indices[t + j];
+                    vs[j] = Vector3(poly[v_index].x, base_y + heights[v_index], poly[v_index].y);
+                }
+
+                const Vector3 normal = (vs[2] - vs[1]).cross(vs[1] - vs[0]).normalized();
+                for (const auto& v : vs)
+                    push_vertex(out, v, normal, Vector2(v.x, v.z));
+            }
+        }
+    }
+
+    void mesh_building(const BuildingMesher::Building& b, MeshSink& sink) {
+        if (b.footprint.empty())
+            return;
+
+        mesh_walls(b, sink.get(b.color));
+
+        BuildingMesher::MeshBuffer& roof = sink.get(b.roof_color);
+        const double roof_height = b.has_roof_height ? b.roof_height : b.max_height - b.min_height;
+        switch (b.roof_type) {
+            case BuildingMesher::ROOF_FLAT:
+                mesh_flat_roof(b, roof);
+                break;
+            case BuildingMesher::ROOF_PYRAMIDAL:
+                mesh_pyramidal_roof(b, roof_height, roof);
+                break;
+            case BuildingMesher::ROOF_SKILLION:
+                mesh_skillion_roof(b, roof_height, roof);
+                break;
+            case BuildingMesher::ROOF_HIPPED:
+                mesh_hipped_roof(b, false, roof);
+                break;
+            case BuildingMesher::ROOF_GABLED:
+                mesh_hipped_roof(b, true, roof);
+                break;
+        }
+    }
+}
+
+Dictionary BuildingMesher::building_info(Dictionary osm_dict, PackedVector3Array nodes) const {
+    Dictionary d;
+    d["name"] = osm_dict.get("name", String::num_int64(osm_dict["id"]));
+    d["nodes"] = nodes;
+    d["max_height"] = tag_to_float(osm_dict, "height", "3");
+    d["min_height"] = tag_to_float(osm_dict, "min_height", "0");
+    d["color"] = osm_to_gd_color(osm_dict.get("building:colour", "white"));
+    d["roof_type"] = get_roof_type(osm_dict.get("roof:shape", "flat"));
+
+    if (osm_dict.has("roof:colour"))
+        d["roof_color"] = osm_to_gd_color(osm_dict["roof:colour"]);
+    if (osm_dict.has("roof:height")) {
+        const double roof_height = tag_to_float(osm_dict, "roof:height", "0");
+        d["max_height"] = static_cast<double>(d["max_height"]) - roof_height;
+        d["roof_height"] = roof_height;
+    }
+    if (osm_dict.has("roof:direction"))
+        d["roof_dir"] = tag_to_float(osm_dict, "roof:direction", "0");
+
+    // Defaults (RenderUtil.apply_defaults)
+    if (!osm_dict.has("height") && osm_dict.has("building:levels")) {
+        double levels = tag_to_float(osm_dict, "building:levels", "0");
+        if (osm_dict.has("roof:levels"))
+            levels += tag_to_float(osm_dict, "roof:levels", "0");
+        d["max_height"] = levels * 3.0; // floor is 3m high
+    }
+    if (!osm_dict.has("building:color") && osm_dict.has("building:material")) {
+        const String material = osm_dict["building:material"];
+        // Color.DARK_RED for brick, white otherwise.
+        d["color"] = material == "brick" ? Color(0.545098, 0.0, 0.0) : Color(1.0, 1.0, 1.0);
+    }
+
+    return d;
+}
+
+BuildingMesher::Building BuildingMesher::building_from_info(const Dictionary& info) {
+    Building b;
+    const PackedVector3Array nodes = info.get("nodes", PackedVector3Array());
+    b.footprint.assign(nodes.ptr(), nodes.ptr() + nodes.size());
+
+    // Drop the repeated closing node and consecutive duplicates.
+    b.footprint.erase(std::unique(b.footprint.begin(), b.footprint.end(),
+                                  [](const Vector3& a, const Vector3& c) { return a.is_equal_approx(c); }),
+                      b.footprint.end());
+    b.closed = b.footprint.size() > 1 && b.footprint.front().is_equal_approx(b.footprint.back());
+    if (b.closed)
+        b.footprint.pop_back();
+
+    b.min_height = info.get("min_height", 0.0);
+    b.max_height = info.get("max_height", 3.0);
+    // An explicit roof:height=0 is kept, like d.get("roof_height", ...) in buildings.gd.
+    b.has_roof_height = info.has("roof_height");
+    b.roof_height = info.get("roof_height", 0.0);
+    b.roof_direction = info.get("roof_dir", 0.0);
+    b.roof_type = static_cast<RoofType>(static_cast<int>(info.get("roof_type", ROOF_FLAT)));
+    b.color = info.get("color", Color(1.0, 1.0, 1.0));
+    b.roof_color = info.get("roof_color", b.color);
+    return b;
+}
+
+void BuildingMesher::mesh(const std::vector<Building>& buildings, std::vector<MeshBuffer>& out) {
+    std::vector<MeshSink> sinks(parallel_worker_count(buildings.size(), 64));
+
+    parallel_for(buildings.size(), [&](size_t i, size_t worker) {
+        mesh_building(buildings[i], sinks[worker]);
+    }, 64);
+
+    // Merge worker buffers in worker order so the output does not depend on scheduling.
+    MeshSink merged;
+    merged.buffers = std::move(out);
+    for (auto& sink : sinks) {
+        for (auto& buffer : sink.buffers) {
+            merged.get(buffer.color).append(buffer);
+        }
+    }
+    out = std::move(merged.buffers);
+}
+
+Array BuildingMesher::mesh_buildings(Array building_infos) {
+    std::vector<Building> buildings;
+    buildings.reserve(building_infos.size());
+    for (int i = 0; i < building_infos.size(); i++)
+        buildings.push_back(building_from_info(building_infos[i]));
+
+    std::vector<MeshBuffer> buffers;
+    mesh(buildings, buffers);
+
+    // Surfaces are independent, so they are optimized in parallel too.
+    std::vector<MeshOptimizer::Stats> stats(buffers.size());
+    parallel_for(buffers.size(), [&](size_t i, size_t) {
+        stats[i] = MeshOptimizer::optimize(buffers[i]);
+    });
+
+    last_stats = MeshOptimizer::Stats();
+    Array surfaces;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        if (buffers[i].vertices.empty())
+            continue;
+
+        last_stats += stats[i];
+
+        Dictionary surface;
+        surface["color"] = buffers[i].color;
+        surface["arrays"] = buffers[i].to_godot();
+        surface["stats"] = stats[i].to_dictionary();
+        surfaces.push_back(surface);
+    }
+
+    return surfaces;
+}
+
+void BuildingMesher::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("building_info", "osm_dict", "nodes"), &BuildingMesher::building_info);
+    ClassDB::bind_method(D_METHOD("mesh_buildings", "building_infos"), &BuildingMesher::mesh_buildings);
+    ClassDB::bind_method(D_METHOD("get_last_stats"), &BuildingMesher::get_last_stats);
+
+    BIND_ENUM_CONSTANT(ROOF_FLAT);
+    BIND_ENUM_CONSTANT(ROOF_PYRAMIDAL);
+    BIND_ENUM_CONSTANT(ROOF_SKILLION);
+    BIND_ENUM_CONSTANT(ROOF_HIPPED);
+    BIND_ENUM_CONSTANT(ROOF_GABLED);
+}
@@ -0,0 +1,86 @@
+#ifndef BUILDING_MESHER_H
+#define BUILDING_MESHER_H
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/color.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "Util.h"
+
+/**
+ * Native replacement for the wall and roof generation in RenderUtil.gd.
+ *
+ * Takes every building of a tile at once (as produced by building_info) and returns one set of mesh
+ * arrays per material, ready for ArrayMesh::add_surface_from_arrays. Buildings are meshed on
+ * worker threads; Godot types are only touched on the calling thread.
+ */
+class BuildingMesher : public godot::RefCounted {
+    GDCLASS(BuildingMesher, godot::RefCounted);
+public:
+    enum RoofType {
+        ROOF_FLAT,
+        ROOF_PYRAMIDAL,
+        ROOF_SKILLION,
+        ROOF_HIPPED,
+        ROOF_GABLED
+    };
+
+    struct Building {
+        /* Footprint in world space, without the repeated closing point. */
+        std::vector<godot::Vector3> footprint;
+        /* Whether the OSM way was closed (walls then also cover the last edge). */
+        bool closed = true;
+        double min_height = 0.0;
+        double max_height = 3.0;
+        /* Only used if has_roof_height; otherwise the roof spans max_height - min_height. */
+        double roof_height = 0.0;
+        bool has_roof_height = false;
+        double roof_direction = 0.0;
+        RoofType roof_type = ROOF_FLAT;
+        godot::Color color;
+        godot::Color roof_color;
+    };
+
+    /* Vertex data of one material. */
+    struct MeshBuffer : MeshArrays {
+        godot::Color color;
+    };
+
+    /**
+     * Native counterpart of RenderUtil.building_info and RenderUtil.apply_defaults.
+     * @param osm_dict Tags of the building way.
+     * @param nodes Footprint in world space.
+     * @return Dictionary with "name", "nodes", "min_height", "max_height", "color", "roof_type"
+     *         and optionally "roof_color", "roof_height", "roof_dir".
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary building_info(godot::Dictionary osm_dict, godot::PackedVector3Array nodes) const;
+
+    /**
+     * Meshes walls and roofs of all given buildings into welded, cache-optimized indexed meshes.
+     * @param building_infos Array of dictionaries returned by building_info.
+     * @return Array of dictionaries { "color": Color, "arrays": Array, "stats": Dictionary }, one per material.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Array mesh_buildings(godot::Array building_infos);
+
+    /* MeshOptimizer statistics summed over all surfaces of the last mesh_buildings call. */
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary get_last_stats() const {
+        return last_stats.to_dictionary();
+    }
+
+    /* Native API: meshes the buildings in parallel and appends to out (one buffer per material). */
+    static void mesh(const std::vector<Building>& buildings, std::vector<MeshBuffer>& out);
+
+    static Building building_from_info(const godot::Dictionary& info);
+
+protected:
+    static void _bind_methods();
+
+private:
+    MeshOptimizer::Stats last_stats;
+};
+
+VARIANT_ENUM_CAST(BuildingMesher::RoofType);
+
+#endif // BUILDING_MESHER_H
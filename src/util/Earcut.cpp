@@ -0,0 +1,545 @@
+#include "Earcut.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace godot;
+
+namespace {
+    /* Twice the signed area of p, q, r; negative if they turn counter-clockwise. */
+    template <typename N>
+    double area(const N* p, const N* q, const N* r) {
+        return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+    }
+
+    template <typename N>
+    bool equals(const N* a, const N* b) {
+        return a->x == b->x && a->y == b->y;
+    }
+
+    int sign(double value) {
+        return (value > 0.0) - (value < 0.0);
+    }
+
+    bool point_in_triangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py) {
+        return (cx - px) * (ay - py) >= (ax - px) * (cy - py) && (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+               (bx - px) * (cy - py) >= (cx - px) * (by - py);
+    }
+
+    /* Whether q lies on segment pr, given that p, q and r are collinear. */
+    template <typename N>
+    bool on_segment(const N* p, const N* q, const N* r) {
+        return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x) && q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+    }
+
+    template <typename N>
+    bool intersects(const N* p1, const N* q1, const N* p2, const N* q2) {
+        const int o1 = sign(area(p1, q1, p2));
+        const int o2 = sign(area(p1, q1, q2));
+        const int o3 = sign(area(p2, q2, p1));
+        const int o4 = sign(area(p2, q2, q1));
+        if (o1 != o2 && o3 != o4)
+            return true;
+        return (o1 == 0 && on_segment(p1, p2, q1)) || (o2 == 0 && on_segment(p1, q2, q1)) || (o3 == 0 && on_segment(p2, p1, q2)) ||
+               (o4 == 0 && on_segment(p2, q1, q2));
+    }
+
+    /* Whether diagonal ab crosses an edge of the polygon. */
+    template <typename N>
+    bool intersects_polygon(const N* a, const N* b) {
+        const N* p = a;
+        do {
+            if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i && intersects(p, p->next, a, b))
+                return true;
+            p = p->next;
+        } while (p != a);
+        return false;
+    }
+
+    /* Whether diagonal ab starts into the inside of the polygon at a. */
+    template <typename N>
+    bool locally_inside(const N* a, const N* b) {
+        return area(a->prev, a, a->next) < 0.0 ? area(a, b, a->next) >= 0.0 && area(a, a->prev, b) >= 0.0
+                                                : area(a, b, a->prev) < 0.0 || area(a, a->next, b) < 0.0;
+    }
+
+    /* Whether the middle of diagonal ab is inside the polygon. */
+    template <typename N>
+    bool middle_inside(const N* a, const N* b) {
+        const N* p = a;
+        bool inside = false;
+        const double px = (a->x + b->x) / 2.0, py = (a->y + b->y) / 2.0;
+        do {
+            if ((p->y > py) != (p->next->y > py) && p->next->y != p->y &&
+                px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x)
+                inside = !inside;
+            p = p->next;
+        } while (p != a);
+        return inside;
+    }
+
+    template <typename N>
+    bool is_valid_diagonal(const N* a, const N* b) {
+        return a->next->i != b->i && a->prev->i != b->i && !intersects_polygon(a, b) &&
+               ((locally_inside(a, b) && locally_inside(b, a) && middle_inside(a, b) &&
+                 (area(a->prev, a, b->prev) != 0.0 || area(a, b->prev, b) != 0.0)) ||
+                (equals(a, b) && area(a->prev, a, a->next) > 0.0 && area(b->prev, b, b->next) > 0.0));
+    }
+
+    /* Whether the sector of m contains the sector of p, both being the same point. */
+    template <typename N>
+    bool sector_contains_sector(const N* m, const N* p) {
+        return area(m->prev, m, p->prev) < 0.0 && area(p->next, m, m->next) < 0.0;
+    }
+
+    template <typename N>
+    void remove_node(N* p) {
+        p->next->prev = p->prev;
+        p->prev->next = p->next;
+        if (p->prev_z)
+            p->prev_z->next_z = p->next_z;
+        if (p->next_z)
+            p->next_z->prev_z = p->prev_z;
+    }
+
+    template <typename N>
+    N* leftmost(N* start) {
+        N* p = start;
+        N* result = start;
+        do {
+            if (p->x < result->x || (p->x == result->x && p->y < result->y))
+                result = p;
+            p = p->next;
+        } while (p != start);
+        return result;
+    }
+
+    /* Merge sort of the z-order list, Simon Tatham's linked list variant. */
+    template <typename N>
+    void sort_linked(N* list) {
+        int in_size = 1;
+        int merges;
+        do {
+            N* p = list;
+            N* tail = nullptr;
+            list = nullptr;
+            merges = 0;
+            while (p) {
+                merges++;
+                N* q = p;
+                int p_size = 0;
+                for (int i = 0; i < in_size && q; i++) {
+                    p_size++;
+                    q = q->next_z;
+                }
+                int q_size = in_size;
+                while (p_size > 0 || (q_size > 0 && q)) {
+                    N* e;
+                    if (p_size != 0 && (q_size == 0 || !q || p->z <= q->z)) {
+                        e = p;
+                        p = p->next_z;
+                        p_size--;
+                    } else {
+                        e = q;
+                        q = q->next_z;
+                        q_size--;
+                    }
+                    if (tail)
+                        tail->next_z = e;
+                    else
+                        list = e;
+                    e->prev_z = tail;
+                    tail = e;
+                }
+                p = q;
+            }
+            tail->next_z = nullptr;
+            in_size *= 2;
+        } while (merges > 1);
+    }
+
+    /* Twice the signed area of ring [begin, end); positive if it is clockwise. */
+    double signed_area(const Vector2* points, int32_t begin, int32_t end) {
+        double sum = 0.0;
+        for (int32_t i = begin, j = end - 1; i < end; j = i++)
+            sum += (static_cast<double>(points[j].x) - points[i].x) * (static_cast<double>(points[i].y) + points[j].y);
+        return sum;
+    }
+}
+
+bool Earcut::triangulate(const Vector2* points, const int32_t* ring_offsets, int32_t ring_count, std::vector<int32_t>& out) {
+    if (ring_count < 1)
+        return false;
+    const size_t first = out.size();
+    const int32_t point_count = ring_offsets[ring_count] - ring_offsets[0];
+    // Every split adds two nodes and there are fewer splits than triangles, so nodes never move once linked.
+    nodes.clear();
+    nodes.reserve(3 * static_cast<size_t>(point_count) + 6 * static_cast<size_t>(ring_count) + 8);
+    this->points = points;
+    triangles = &out;
+    inv_size = 0.0;
+
+    Node* outer = linked_list(ring_offsets[0], ring_offsets[1], true);
+    if (!outer || outer->next == outer->prev)
+        return false;
+    if (ring_count > 1)
+        outer = eliminate_holes(ring_offsets, ring_count, outer);
+
+    if (point_count > 80) {
+        double max_x, max_y;
+        min_x = max_x = points[ring_offsets[0]].x;
+        min_y = max_y = points[ring_offsets[0]].y;
+        for (int32_t i = ring_offsets[0] + 1; i < ring_offsets[1]; i++) {
+            min_x = std::min<double>(min_x, points[i].x);
+            min_y = std::min<double>(min_y, points[i].y);
+            max_x = std::max<double>(max_x, points[i].x);
+            max_y = std::max<double>(max_y, points[i].y);
+        }
+        inv_size = std::max(max_x - min_x, max_y - min_y);
+        inv_size = inv_size != 0.0 ? 32767.0 / inv_size : 0.0;
+    }
+
+    earcut_linked(outer, 0);
+    triangles = nullptr;
+    return out.size() > first;
+}
+
+double Earcut::deviation(const Vector2* points, const int32_t* ring_offsets, int32_t ring_count, const std::vector<int32_t>& indices,
+                         size_t first) {
+    double polygon_area = std::abs(signed_area(points, ring_offsets[0], ring_offsets[1]));
+    for (int32_t r = 1; r < ring_count; r++)
+        polygon_area -= std::abs(signed_area(points, ring_offsets[r], ring_offsets[r + 1]));
+
+    double triangles_area = 0.0;
+    for (size_t t = first; t + 2 < indices.size(); t += 3) {
+        const Vector2& a = points[indices[t]];
+        const Vector2& b = points[indices[t + 1]];
+        const Vector2& c = points[indices[t + 2]];
+        triangles_area += std::abs((static_cast<double>(a.x) - c.x) * (static_cast<double>(b.y) - a.y) -
+                                   (static_cast<double>(a.x) - b.x) * (static_cast<double>(c.y) - a.y));
+    }
+    if (polygon_area == 0.0 && triangles_area == 0.0)
+        return 0.0;
+    return std::abs((triangles_area - polygon_area) / polygon_area);
+}
+
+Earcut::Node* Earcut::create_node(int32_t i, double x, double y) {
+    nodes.emplace_back();
+    Node* p = &nodes.back();
+    p->i = i;
+    p->x = x;
+    p->y = y;
+    return p;
+}
+
+/* Links ring [begin, end) in the given winding; returns its last node. */
+Earcut::Node* Earcut::linked_list(int32_t begin, int32_t end, bool clockwise) {
+    Node* last = nullptr;
+    auto insert = [&](int32_t i) {
+        Node* p = create_node(i, points[i].x, points[i].y);
+        if (!last) {
+            p->prev = p;
+            p->next = p;
+        } else {
+            p->next = last->next;
+            p->prev = last;
+            last->next->prev = p;
+            last->next = p;
+        }
+        last = p;
+    };
+    if (clockwise == (signed_area(points, begin, end) > 0.0)) {
+        for (int32_t i = begin; i < end; i++)
+            insert(i);
+    } else {
+        for (int32_t i = end - 1; i >= begin; i--)
+            insert(i);
+    }
+
+    if (last && equals(last, last->next)) {
+        Node* next = last->next;
+        remove_node(last);
+        last = next == last ? nullptr : next;
+    }
+    return last;
+}
+
+/* Drops duplicate and collinear points between start and end. */
+Earcut::Node* Earcut::filter_points(Node* start, Node* end) {
+    if (!start)
+        return start;
+    if (!end)
+        end = start;
+
+    Node* p = start;
+    bool again;
+    do {
+        again = false;
+        if (!p->steiner && (equals(p, p->next) || area(p->prev, p, p->next) == 0.0)) {
+            remove_node(p);
+            p = end = p->prev;
+            if (p == p->next)
+                break;
+            again = true;
+        } else {
+            p = p->next;
+        }
+    } while (again || p != end);
+    return end;
+}
+
+/*
+ * Clips ears until the ring is a triangle. When no ear is left, pass 1 filters points again, pass 2 cuts off
+ * local self-intersections, and the last resort splits the ring in two along a valid diagonal.
+ */
+void Earcut::earcut_linked(Node* ear, int pass) {
+    if (!ear)
+        return;
+    if (pass == 0 && inv_size != 0.0)
+        index_curve(ear);
+
+    Node* stop = ear;
+    while (ear->prev != ear->next) {
+        Node* prev = ear->prev;
+        Node* next = ear->next;
+        if (inv_size != 0.0 ? is_ear_hashed(ear) : is_ear(ear)) {
+            emit(prev, ear, next);
+            remove_node(ear);
+            // Skipping the next vertex leads to fewer sliver triangles.
+            ear = next->next;
+            stop = next->next;
+            continue;
+        }
+
+        ear = next;
+        if (ear == stop) {
+            if (pass == 0) {
+                earcut_linked(filter_points(ear), 1);
+            } else if (pass == 1) {
+                earcut_linked(cure_local_intersections(filter_points(ear)), 2);
+            } else {
+                split_earcut(ear);
+            }
+            break;
+        }
+    }
+}
+
+bool Earcut::is_ear(Node* ear) const {
+    const Node* a = ear->prev;
+    const Node* b = ear;
+    const Node* c = ear->next;
+    if (area(a, b, c) >= 0.0)
+        return false; // Reflex.
+
+    const double x0 = std::min({ a->x, b->x, c->x }), y0 = std::min({ a->y, b->y, c->y });
+    const double x1 = std::max({ a->x, b->x, c->x }), y1 = std::max({ a->y, b->y, c->y });
+    for (const Node* p = c->next; p != a; p = p->next) {
+        if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && point_in_triangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+            area(p->prev, p, p->next) >= 0.0)
+            return false;
+    }
+    return true;
+}
+
+bool Earcut::is_ear_hashed(Node* ear) const {
+    const Node* a = ear->prev;
+    const Node* b = ear;
+    const Node* c = ear->next;
+    if (area(a, b, c) >= 0.0)
+        return false;
+
+    const double x0 = std::min({ a->x, b->x, c->x }), y0 = std::min({ a->y, b->y, c->y });
+    const double x1 = std::max({ a->x, b->x, c->x }), y1 = std::max({ a->y, b->y, c->y });
+    const int32_t min_z = z_order(x0, y0), max_z = z_order(x1, y1);
+    auto blocks = [&](const Node* p) {
+        return p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && p != a && p != c &&
+               point_in_triangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) && area(p->prev, p, p->next) >= 0.0;
+    };
+
+    // Only points within the z range of the ear's bounding box can lie in it; walk both ways from the ear.
+    const Node* p = ear->prev_z;
+    const Node* n = ear->next_z;
+    while (p && p->z >= min_z && n && n->z <= max_z) {
+        if (blocks(p))
+            return false;
+        p = p->prev_z;
+        if (blocks(n))
+            return false;
+        n = n->next_z;
+    }
+    for (; p && p->z >= min_z; p = p->prev_z)
+        if (blocks(p))
+            return false;
+    for (; n && n->z <= max_z; n = n->next_z)
+        if (blocks(n))
+            return false;
+    return true;
+}
+
+/* Cuts off triangles where the ring crosses itself over a single vertex. */
+Earcut::Node* Earcut::cure_local_intersections(Node* start) {
+    Node* p = start;
+    do {
+        Node* a = p->prev;
+        Node* b = p->next->next;
+        if (!equals(a, b) && intersects(a, p, p->next, b) && locally_inside(a, b) && locally_inside(b, a)) {
+            emit(a, p, b);
+            remove_node(p);
+            remove_node(p->next);
+            p = start = b;
+        }
+        p = p->next;
+    } while (p != start);
+    return filter_points(p);
+}
+
+/* Splits the ring along a valid diagonal and clips both halves. */
+void Earcut::split_earcut(Node* start) {
+    Node* a = start;
+    do {
+        for (Node* b = a->next->next; b != a->prev; b = b->next) {
+            if (a->i != b->i && is_valid_diagonal(a, b)) {
+                Node* c = split_polygon(a, b);
+                a = filter_points(a, a->next);
+                c = filter_points(c, c->next);
+                earcut_linked(a, 0);
+                earcut_linked(c, 0);
+                return;
+            }
+        }
+        a = a->next;
+    } while (a != start);
+}
+
+/* Bridges every hole into the outer ring, from the leftmost hole to the rightmost. */
+Earcut::Node* Earcut::eliminate_holes(const int32_t* ring_offsets, int32_t ring_count, Node* outer) {
+    queue.clear();
+    for (int32_t r = 1; r < ring_count; r++) {
+        Node* list = linked_list(ring_offsets[r], ring_offsets[r + 1], false);
+        if (!list)
+            continue;
+        if (list == list->next)
+            list->steiner = true;
+        queue.push_back(leftmost(list));
+    }
+    std::sort(queue.begin(), queue.end(), [](const Node* a, const Node* b) {
+        return a->x < b->x;
+    });
+    for (Node* hole : queue)
+        outer = eliminate_hole(hole, outer);
+    return outer;
+}
+
+Earcut::Node* Earcut::eliminate_hole(Node* hole, Node* outer) {
+    Node* bridge = find_hole_bridge(hole, outer);
+    if (!bridge)
+        return outer;
+    Node* bridge_reverse = split_polygon(bridge, hole);
+    filter_points(bridge_reverse, bridge_reverse->next);
+    return filter_points(bridge, bridge->next);
+}
+
+/* Outer ring vertex the leftmost point of a hole can be connected to (David Eberly's algorithm). */
+Earcut::Node* Earcut::find_hole_bridge(Node* hole, Node* outer) const {
+    Node* p = outer;
+    const double hx = hole->x, hy = hole->y;
+    double qx = -std::numeric_limits<double>::infinity();
+    Node* m = nullptr;
+
+    // The nearest segment to the left of the hole point on its horizontal, and its endpoint with the larger x.
+    do {
+        if (hy <= p->y && hy >= p->next->y && p->next->y != p->y) {
+            const double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+            if (x <= hx && x > qx) {
+                qx = x;
+                m = p->x < p->next->x ? p : p->next;
+                if (x == hx)
+                    return m; // The hole touches the outer segment.
+            }
+        }
+        p = p->next;
+    } while (p != outer);
+    if (!m)
+        return nullptr;
+
+    // Reflex points inside the triangle of the hole point, the segment intersection and m may block the view;
+    // the one with the smallest angle to the horizontal is taken instead.
+    const Node* stop = m;
+    const double mx = m->x, my = m->y;
+    double tan_min = std::numeric_limits<double>::infinity();
+    p = m;
+    do {
+        if (hx >= p->x && p->x >= mx && hx != p->x &&
+            point_in_triangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y)) {
+            const double tan = std::abs(hy - p->y) / (hx - p->x);
+            if (locally_inside(p, hole) &&
+                (tan < tan_min || (tan == tan_min && (p->x > m->x || (p->x == m->x && sector_contains_sector(m, p)))))) {
+                m = p;
+                tan_min = tan;
+            }
+        }
+        p = p->next;
+    } while (p != stop);
+    return m;
+}
+
+void Earcut::index_curve(Node* start) {
+    Node* p = start;
+    do {
+        if (p->z == 0)
+            p->z = z_order(p->x, p->y);
+        p->prev_z = p->prev;
+        p->next_z = p->next;
+        p = p->next;
+    } while (p != start);
+
+    p->prev_z->next_z = nullptr;
+    p->prev_z = nullptr;
+    sort_linked(p);
+}
+
+/* Morton code of a point scaled into 15 bits per axis. */
+int32_t Earcut::z_order(double x, double y) const {
+    int32_t ix = static_cast<int32_t>((x - min_x) * inv_size);
+    int32_t iy = static_cast<int32_t>((y - min_y) * inv_size);
+
+    ix = (ix | (ix << 8)) & 0x00FF00FF;
+    ix = (ix | (ix << 4)) & 0x0F0F0F0F;
+    ix = (ix | (ix << 2)) & 0x33333333;
+    ix = (ix | (ix << 1)) & 0x55555555;
+
+    iy = (iy | (iy << 8)) & 0x00FF00FF;
+    iy = (iy | (iy << 4)) & 0x0F0F0F0F;
+    iy = (iy | (iy << 2)) & 0x33333333;
+    iy = (iy | (iy << 1)) & 0x55555555;
+
+    return ix | (iy << 1);
+}
+
+/*
+ * Links a to b with a diagonal. a and b are duplicated so the ring splits in two: a -> b -> ... stays,
+ * and the other part is reached through the returned copy of b.
+ */
+Earcut::Node* Earcut::split_polygon(Node* a, Node* b) {
+    Node* a2 = create_node(a->i, a->x, a->y);
+    Node* b2 = create_node(b->i, b->x, b->y);
+    Node* an = a->next;
+    Node* bp = b->prev;
+
+    a->next = b;
+    b->prev = a;
+    a2->next = an;
+    an->prev = a2;
+    b2->next = a2;
+    a2->prev = b2;
+    bp->next = b2;
+    b2->prev = bp;
+    return b2;
+}
+
+void Earcut::emit(const Node* a, const Node* b, const Node* c) {
+    triangles->push_back(a->i);
+    triangles->push_back(b->i);
+    triangles->push_back(c->i);
+}
@@ -0,0 +1,72 @@
+#ifndef EARCUT_H
+#define EARCUT_H
+#include <godot_cpp/variant/vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Ear clipping triangulator for polygons with holes, a port of mapbox/earcut.
+ *
+ * Holes are bridged into the outer ring, so the polygon becomes one ring that is clipped ear by ear.
+ * Duplicate and collinear points are dropped rather than rejected, and polygons above 80 points index their
+ * points on a z-order curve so the point-in-ear test only visits points near the ear. Unlike constrained
+ * Delaunay it makes no attempt at well-shaped triangles, and on self-intersecting input it gives up or
+ * leaves gaps, which deviation() tells.
+ *
+ * An instance keeps its node buffer between calls, so a thread should reuse one.
+ */
+class Earcut {
+public:
+    /**
+     * @param ring_offsets Ring r has the points [ring_offsets[r], ring_offsets[r + 1]), the outer one first; a ring may repeat its first point.
+     * @param out Receives 3 indices into points per triangle, counter-clockwise like poly2tri's.
+     * @return false if no triangle was made.
+     */
+    bool triangulate(const godot::Vector2* points, const int32_t* ring_offsets, int32_t ring_count, std::vector<int32_t>& out);
+
+    /**
+     * Relative difference between the area of the polygon and the area of triangles [first, indices.size() / 3).
+     * Near 0 for a correct triangulation.
+     */
+    static double deviation(const godot::Vector2* points, const int32_t* ring_offsets, int32_t ring_count,
+                            const std::vector<int32_t>& indices, size_t first = 0);
+
+private:
+    struct Node {
+        int32_t i;
+        double x, y;
+        Node* prev = nullptr;
+        Node* next = nullptr;
+        /* Z-order curve value, and neighbours in z-order. */
+        int32_t z = 0;
+        Node* prev_z = nullptr;
+        Node* next_z = nullptr;
+        /* Set on single-point holes, which must not be filtered out. */
+        bool steiner = false;
+    };
+
+    Node* create_node(int32_t i, double x, double y);
+    Node* linked_list(int32_t begin, int32_t end, bool clockwise);
+    Node* filter_points(Node* start, Node* end = nullptr);
+    void earcut_linked(Node* ear, int pass);
+    bool is_ear(Node* ear) const;
+    bool is_ear_hashed(Node* ear) const;
+    Node* cure_local_intersections(Node* start);
+    void split_earcut(Node* start);
+    Node* eliminate_holes(const int32_t* ring_offsets, int32_t ring_count, Node* outer);
+    Node* eliminate_hole(Node* hole, Node* outer);
+    Node* find_hole_bridge(Node* hole, Node* outer) const;
+    void index_curve(Node* start);
+    int32_t z_order(double x, double y) const;
+    Node* split_polygon(Node* a, Node* b);
+    void emit(const Node* a, const Node* b, const Node* c);
+
+    std::vector<Node> nodes;
+    std::vector<Node*> queue;
+    const godot::Vector2* points = nullptr;
+    std::vector<int32_t>* triangles = nullptr;
+    /* Z-order hashing is on when inv_size is not 0. */
+    double min_x = 0.0, min_y = 0.0, inv_size = 0.0;
+};
+
+#endif // EARCUT_H
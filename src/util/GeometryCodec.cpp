@@ -0,0 +1,487 @@
+#include "GeometryCodec.h"
+#include <godot_cpp/classes/mesh.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if !defined(REAL_T_IS_DOUBLE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define GEOMETRY_CODEC_SSE2
+#elif !defined(REAL_T_IS_DOUBLE) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define GEOMETRY_CODEC_NEON
+#endif
+
+using namespace godot;
+
+namespace {
+    const uint32_t CODEC_MAGIC = 0x4D474753; // "SGGM"
+    const uint16_t CODEC_VERSION = 1;
+
+    enum Flags : uint16_t {
+        HAS_NORMALS = 1 << 0,
+        HAS_UVS = 1 << 1,
+        UV_FLOAT32 = 1 << 2,
+        HAS_INDICES = 1 << 3,
+        INDEX_32 = 1 << 4
+    };
+
+    /* The encoding is defined as little endian; every platform Godot ships on is. */
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t flags;
+        uint32_t vertex_count;
+        uint32_t index_count;
+        double origin[3];
+        float scale[3];
+        float uv_offset[2];
+    };
+    static_assert(sizeof(Header) == 64, "GeometryCodec.h documents a 64 byte header.");
+
+    /* Positions of the sections following the header. */
+    struct Layout {
+        Header header;
+        const uint8_t* positions = nullptr;
+        const uint8_t* normals = nullptr;
+        const uint8_t* uvs = nullptr;
+        const uint8_t* indices = nullptr;
+    };
+
+    size_t uv_bytes(uint16_t flags) {
+        return (flags & UV_FLOAT32) ? 2 * sizeof(float) : 2 * sizeof(uint16_t);
+    }
+
+    size_t index_bytes(uint16_t flags) {
+        return (flags & INDEX_32) ? sizeof(uint32_t) : sizeof(uint16_t);
+    }
+
+    bool parse_layout(const uint8_t* data, size_t size, Layout& layout) {
+        if (size < sizeof(Header))
+            return false;
+        std::memcpy(&layout.header, data, sizeof(Header));
+        const Header& h = layout.header;
+        if (h.magic != CODEC_MAGIC || h.version != CODEC_VERSION)
+            return false;
+
+        const size_t n = h.vertex_count;
+        size_t offset = sizeof(Header);
+        auto section = [&](size_t bytes) -> const uint8_t* {
+            if (bytes > size - offset)
+                return nullptr;
+            const uint8_t* p = data + offset;
+            offset += bytes;
+            return p;
+        };
+
+        layout.positions = section(n * 3 * sizeof(uint16_t));
+        if (!layout.positions)
+            return false;
+        if (h.flags & HAS_NORMALS) {
+            layout.normals = section(n * 2 * sizeof(int8_t));
+            if (!layout.normals)
+                return false;
+        }
+        if (h.flags & HAS_UVS) {
+            layout.uvs = section(n * uv_bytes(h.flags));
+            if (!layout.uvs)
+                return false;
+        }
+        if (h.flags & HAS_INDICES) {
+            layout.indices = section(size_t(h.index_count) * index_bytes(h.flags));
+            if (!layout.indices)
+                return false;
+        }
+        return offset == size;
+    }
+
+    template <typename T>
+    void put(std::vector<uint8_t>& out, const T& value) {
+        const size_t at = out.size();
+        out.resize(at + sizeof(T));
+        std::memcpy(out.data() + at, &value, sizeof(T));
+    }
+
+    template <typename T>
+    T get(const uint8_t* p, size_t i) {
+        T value;
+        std::memcpy(&value, p + i * sizeof(T), sizeof(T));
+        return value;
+    }
+
+    uint16_t float_to_half(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const uint32_t sign = (bits >> 16) & 0x8000u;
+        const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFFu;
+
+        if (exponent >= 31)
+            return static_cast<uint16_t>(sign | 0x7C00u); // Overflow and NaN both become infinity.
+        if (exponent <= 0) {
+            if (exponent < -10)
+                return static_cast<uint16_t>(sign);
+            mantissa |= 0x800000u;
+            const int shift = 14 - exponent;
+            uint32_t half = mantissa >> shift;
+            if ((mantissa >> (shift - 1)) & 1u)
+                half++;
+            return static_cast<uint16_t>(sign | half);
+        }
+        uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        // Round to nearest; a carry into the exponent is still the correct result.
+        if (mantissa & 0x1000u)
+            half++;
+        return static_cast<uint16_t>(half);
+    }
+
+    float half_to_float(uint16_t half) {
+        const uint32_t sign = (half & 0x8000u) << 16;
+        uint32_t exponent = (half >> 10) & 0x1Fu;
+        uint32_t mantissa = half & 0x3FFu;
+        uint32_t bits;
+
+        if (exponent == 0) {
+            if (mantissa == 0) {
+                bits = sign;
+            } else {
+                // Subnormal half, renormalize.
+                exponent = 127 - 15 + 1;
+                while (!(mantissa & 0x400u)) {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+            }
+        } else if (exponent == 31) {
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        } else {
+            bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+        }
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    int8_t to_snorm8(float value) {
+        return static_cast<int8_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+    }
+
+    /* Octahedral normal encoding, see Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors". */
+    void encode_octahedral(const Vector3& n, int8_t& out_x, int8_t& out_y) {
+        const float l1 = std::abs(float(n.x)) + std::abs(float(n.y)) + std::abs(float(n.z));
+        if (l1 <= 0.0f) {
+            out_x = out_y = 0;
+            return;
+        }
+        float x = n.x / l1, y = n.y / l1;
+        if (n.z < 0.0f) {
+            const float ox = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float oy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = ox;
+            y = oy;
+        }
+        out_x = to_snorm8(x);
+        out_y = to_snorm8(y);
+    }
+
+    /* Dequantizes count 16-bit values into origin + q * scale. */
+    void dequantize(const uint8_t* in, size_t count, float origin, float scale, float* out) {
+        size_t i = 0;
+#if defined(GEOMETRY_CODEC_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 o = _mm_set1_ps(origin), s = _mm_set1_ps(scale);
+        for (; i + 8 <= count; i += 8) {
+            const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * sizeof(uint16_t)));
+            const __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(q, zero));
+            const __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(q, zero));
+            _mm_storeu_ps(out + i, _mm_add_ps(o, _mm_mul_ps(lo, s)));
+            _mm_storeu_ps(out + i + 4, _mm_add_ps(o, _mm_mul_ps(hi, s)));
+        }
+#elif defined(GEOMETRY_CODEC_NEON)
+        const float32x4_t o = vdupq_n_f32(origin), s = vdupq_n_f32(scale);
+        for (; i + 8 <= count; i += 8) {
+            uint16_t lanes[8];
+            std::memcpy(lanes, in + i * sizeof(uint16_t), sizeof(lanes));
+            const uint16x8_t q = vld1q_u16(lanes);
+            const float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(q)));
+            const float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(q)));
+            vst1q_f32(out + i, vmlaq_f32(o, lo, s));
+            vst1q_f32(out + i + 4, vmlaq_f32(o, hi, s));
+        }
+#endif
+        for (; i < count; i++)
+            out[i] = origin + float(get<uint16_t>(in, i)) * scale;
+    }
+
+    /* Vertices are decoded in blocks small enough for the per-axis scratch to stay in L1. */
+    const size_t DECODE_BLOCK = 256;
+
+    void decode_positions(const Layout& layout, Vector3* out) {
+        const Header& h = layout.header;
+        const size_t n = h.vertex_count;
+#if defined(GEOMETRY_CODEC_SSE2) || defined(GEOMETRY_CODEC_NEON)
+        float axis[3][DECODE_BLOCK];
+        for (size_t begin = 0; begin < n; begin += DECODE_BLOCK) {
+            const size_t count = std::min(DECODE_BLOCK, n - begin);
+            for (int a = 0; a < 3; a++) {
+                const uint8_t* in = layout.positions + (a * n + begin) * sizeof(uint16_t);
+                dequantize(in, count, float(h.origin[a]), h.scale[a], axis[a]);
+            }
+            for (size_t i = 0; i < count; i++)
+                out[begin + i] = Vector3(axis[0][i], axis[1][i], axis[2][i]);
+        }
+#else
+        // real_t may be double here, so dequantize at full precision.
+        for (int a = 0; a < 3; a++) {
+            const uint8_t* in = layout.positions + a * n * sizeof(uint16_t);
+            for (size_t i = 0; i < n; i++)
+                out[i][a] = real_t(h.origin[a] + double(get<uint16_t>(in, i)) * h.scale[a]);
+        }
+#endif
+    }
+
+    void decode_normals(const Layout& layout, Vector3* out) {
+        const size_t n = layout.header.vertex_count;
+        const int8_t* in = reinterpret_cast<const int8_t*>(layout.normals);
+        for (size_t i = 0; i < n; i++) {
+            float x = std::max(in[2 * i] / 127.0f, -1.0f);
+            float y = std::max(in[2 * i + 1] / 127.0f, -1.0f);
+            const float z = 1.0f - std::abs(x) - std::abs(y);
+            // Branchless unfolding of the lower hemisphere.
+            const float t = std::max(-z, 0.0f);
+            x += x >= 0.0f ? -t : t;
+            y += y >= 0.0f ? -t : t;
+            const float inv_len = 1.0f / std::sqrt(x * x + y * y + z * z);
+            out[i] = Vector3(x * inv_len, y * inv_len, z * inv_len);
+        }
+    }
+
+    void decode_uvs(const Layout& layout, Vector2* out) {
+        const Header& h = layout.header;
+        const size_t n = h.vertex_count;
+        if (h.flags & UV_FLOAT32) {
+            for (size_t i = 0; i < n; i++)
+                out[i] = Vector2(h.uv_offset[0] + get<float>(layout.uvs, 2 * i), h.uv_offset[1] + get<float>(layout.uvs, 2 * i + 1));
+        } else {
+            for (size_t i = 0; i < n; i++)
+                out[i] = Vector2(h.uv_offset[0] + half_to_float(get<uint16_t>(layout.uvs, 2 * i)),
+                                 h.uv_offset[1] + half_to_float(get<uint16_t>(layout.uvs, 2 * i + 1)));
+        }
+    }
+
+    bool decode_indices(const Layout& layout, int32_t* out) {
+        const Header& h = layout.header;
+        const size_t count = h.index_count;
+        if (h.flags & INDEX_32) {
+            for (size_t i = 0; i < count; i++)
+                out[i] = static_cast<int32_t>(get<uint32_t>(layout.indices, i));
+        } else {
+            for (size_t i = 0; i < count; i++)
+                out[i] = get<uint16_t>(layout.indices, i);
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (out[i] < 0 || static_cast<uint32_t>(out[i]) >= h.vertex_count)
+                return false;
+        }
+        return true;
+    }
+}
+
+std::vector<uint8_t> GeometryCodec::encode(const MeshArrays& mesh, double uv_half_max_range, Stats* stats) {
+    const size_t n = mesh.vertices.size();
+    const bool has_normals = !mesh.normals.empty() && mesh.normals.size() == n;
+    const bool has_uvs = !mesh.uvs.empty() && mesh.uvs.size() == n;
+
+    Header h;
+    std::memset(&h, 0, sizeof(h)); // Padding is written out too.
+    h.magic = CODEC_MAGIC;
+    h.version = CODEC_VERSION;
+    h.vertex_count = static_cast<uint32_t>(n);
+    h.index_count = static_cast<uint32_t>(mesh.indices.size());
+    if (has_normals)
+        h.flags |= HAS_NORMALS;
+    if (has_uvs)
+        h.flags |= HAS_UVS;
+    if (!mesh.indices.empty()) {
+        h.flags |= HAS_INDICES;
+        if (n > 0xFFFF)
+            h.flags |= INDEX_32;
+    }
+
+    // Positions are stored relative to the bounding box of the tile geometry.
+    double min[3] = { 0.0, 0.0, 0.0 }, max[3] = { 0.0, 0.0, 0.0 };
+    for (int a = 0; a < 3; a++) {
+        min[a] = n ? std::numeric_limits<double>::max() : 0.0;
+        max[a] = n ? std::numeric_limits<double>::lowest() : 0.0;
+    }
+    for (const Vector3& v : mesh.vertices) {
+        for (int a = 0; a < 3; a++) {
+            min[a] = std::min(min[a], double(v[a]));
+            max[a] = std::max(max[a], double(v[a]));
+        }
+    }
+    for (int a = 0; a < 3; a++) {
+        h.origin[a] = min[a];
+        h.scale[a] = static_cast<float>((max[a] - min[a]) / 65535.0);
+    }
+
+    // UVs keep their fractional part (what a repeating texture sees) relative to an integer offset.
+    bool uv_half = true;
+    if (has_uvs) {
+        float uv_min[2] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+        float uv_max[2] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+        for (const Vector2& uv : mesh.uvs) {
+            uv_min[0] = std::min(uv_min[0], float(uv.x));
+            uv_min[1] = std::min(uv_min[1], float(uv.y));
+            uv_max[0] = std::max(uv_max[0], float(uv.x));
+            uv_max[1] = std::max(uv_max[1], float(uv.y));
+        }
+        for (int a = 0; a < 2; a++) {
+            h.uv_offset[a] = std::floor(uv_min[a]);
+            if (uv_max[a] - h.uv_offset[a] > uv_half_max_range)
+                uv_half = false;
+        }
+        if (!uv_half)
+            h.flags |= UV_FLOAT32;
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(sizeof(Header) + n * (6 + (has_normals ? 2 : 0) + (has_uvs ? uv_bytes(h.flags) : 0)) +
+                mesh.indices.size() * index_bytes(h.flags));
+    put(out, h);
+
+    double max_error = 0.0;
+    for (int a = 0; a < 3; a++) {
+        const double inv_scale = h.scale[a] > 0.0f ? 1.0 / h.scale[a] : 0.0;
+        for (const Vector3& v : mesh.vertices) {
+            const double q = std::clamp(std::round((v[a] - h.origin[a]) * inv_scale), 0.0, 65535.0);
+            put(out, static_cast<uint16_t>(q));
+            max_error = std::max(max_error, std::abs(h.origin[a] + q * h.scale[a] - v[a]));
+        }
+    }
+    if (has_normals) {
+        for (const Vector3& normal : mesh.normals) {
+            int8_t x, y;
+            encode_octahedral(normal, x, y);
+            put(out, x);
+            put(out, y);
+        }
+    }
+    if (has_uvs) {
+        for (const Vector2& uv : mesh.uvs) {
+            const float u = uv.x - h.uv_offset[0], v = uv.y - h.uv_offset[1];
+            if (uv_half) {
+                put(out, float_to_half(u));
+                put(out, float_to_half(v));
+            } else {
+                put(out, u);
+                put(out, v);
+            }
+        }
+    }
+    for (int32_t index : mesh.indices) {
+        if (h.flags & INDEX_32)
+            put(out, static_cast<uint32_t>(index));
+        else
+            put(out, static_cast<uint16_t>(index));
+    }
+
+    if (stats) {
+        stats->raw_bytes = static_cast<int64_t>(n * (sizeof(Vector3) + (has_normals ? sizeof(Vector3) : 0) + (has_uvs ? sizeof(Vector2) : 0)) +
+                                                mesh.indices.size() * sizeof(int32_t));
+        stats->encoded_bytes = static_cast<int64_t>(out.size());
+        stats->max_position_error = max_error;
+    }
+    return out;
+}
+
+bool GeometryCodec::decode(const uint8_t* data, size_t size, MeshArrays& out) {
+    Layout layout;
+    if (!parse_layout(data, size, layout))
+        return false;
+
+    const size_t n = layout.header.vertex_count;
+    out.vertices.resize(n);
+    decode_positions(layout, out.vertices.data());
+    out.normals.resize(layout.normals ? n : 0);
+    if (layout.normals)
+        decode_normals(layout, out.normals.data());
+    out.uvs.resize(layout.uvs ? n : 0);
+    if (layout.uvs)
+        decode_uvs(layout, out.uvs.data());
+    out.indices.resize(layout.indices ? layout.header.index_count : 0);
+    return !layout.indices || decode_indices(layout, out.indices.data());
+}
+
+PackedByteArray GeometryCodec::encode_arrays(Array arrays) {
+    MeshArrays mesh;
+    PackedByteArray packed;
+    if (!MeshArrays::from_godot(arrays, mesh))
+        return packed;
+    const std::vector<uint8_t> bytes = encode(mesh, uv_half_max_range, &last_stats);
+    packed.resize(bytes.size());
+    if (!bytes.empty())
+        std::memcpy(packed.ptrw(), bytes.data(), bytes.size());
+    return packed;
+}
+
+Array GeometryCodec::decode_arrays(PackedByteArray data) const {
+    Layout layout;
+    if (!parse_layout(data.ptr(), data.size(), layout)) {
+        ERR_PRINT("GeometryCodec: invalid or unsupported encoded geometry.");
+        return Array();
+    }
+
+    // Decode straight into the packed arrays handed to Godot.
+    const int64_t n = layout.header.vertex_count;
+    Array arrays;
+    arrays.resize(Mesh::ARRAY_MAX);
+
+    PackedVector3Array vertices;
+    vertices.resize(n);
+    decode_positions(layout, vertices.ptrw());
+    arrays[Mesh::ARRAY_VERTEX] = vertices;
+
+    if (layout.normals) {
+        PackedVector3Array normals;
+        normals.resize(n);
+        decode_normals(layout, normals.ptrw());
+        arrays[Mesh::ARRAY_NORMAL] = normals;
+    }
+    if (layout.uvs) {
+        PackedVector2Array uvs;
+        uvs.resize(n);
+        decode_uvs(layout, uvs.ptrw());
+        arrays[Mesh::ARRAY_TEX_UV] = uvs;
+    }
+    if (layout.indices) {
+        PackedInt32Array indices;
+        indices.resize(layout.header.index_count);
+        if (!decode_indices(layout, indices.ptrw())) {
+            ERR_PRINT("GeometryCodec: encoded index out of range.");
+            return Array();
+        }
+        arrays[Mesh::ARRAY_INDEX] = indices;
+    }
+    return arrays;
+}
+
+Dictionary GeometryCodec::get_last_stats() const {
+    Dictionary d;
+    d["raw_bytes"] = last_stats.raw_bytes;
+    d["encoded_bytes"] = last_stats.encoded_bytes;
+    d["max_position_error"] = last_stats.max_position_error;
+    return d;
+}
+
+void GeometryCodec::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("encode_arrays", "arrays"), &GeometryCodec::encode_arrays);
+    ClassDB::bind_method(D_METHOD("decode_arrays", "data"), &GeometryCodec::decode_arrays);
+    ClassDB::bind_method(D_METHOD("get_last_stats"), &GeometryCodec::get_last_stats);
+    ClassDB::bind_method(D_METHOD("set_uv_half_max_range", "value"), &GeometryCodec::set_uv_half_max_range);
+    ClassDB::bind_method(D_METHOD("get_uv_half_max_range"), &GeometryCodec::get_uv_half_max_range);
+
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "uv_half_max_range"), "set_uv_half_max_range", "get_uv_half_max_range");
+}
@@ -0,0 +1,74 @@
+#ifndef GEOMETRY_CODEC_H
+#define GEOMETRY_CODEC_H
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <cstdint>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "Util.h"
+
+/**
+ * Compact encoding of tile geometry for .sgdmap layers.
+ *
+ * Layout (little endian, attributes stored as structure of arrays so decoding streams through them):
+ *   header (64 bytes)
+ *     magic        uint32 "SGGM"
+ *     version      uint16, currently 1
+ *     flags        uint16: 1 normals, 2 uvs, 4 uvs as float32 instead of float16, 8 indices, 16 indices as uint32 instead of uint16
+ *     vertex count uint32
+ *     index count  uint32
+ *     origin       3 x float64, min corner of the tile geometry in world space
+ *     scale        3 x float32, metres per quantization step
+ *     uv offset    2 x float32, whole numbers subtracted from every UV before it is stored
+ *     padding      4 zero bytes
+ *   positions    3 x uint16 per vertex (all x, then all y, then all z); position = origin + q * scale
+ *   normals      2 x int8 per vertex, octahedral encoding (if flag 1)
+ *   uvs          2 x float16 or float32 per vertex (if flag 2); uv = uv offset + stored value
+ *   indices      uint16 or uint32 per index (if flag 8)
+ */
+class GeometryCodec : public godot::RefCounted {
+    GDCLASS(GeometryCodec, godot::RefCounted);
+public:
+    struct Stats {
+        int64_t raw_bytes = 0;
+        int64_t encoded_bytes = 0;
+        /* Largest position error introduced by quantization, in world units. */
+        double max_position_error = 0.0;
+    };
+
+    /* Native API. uv_half_max_range: UV extents (after the integer offset) above this are stored as float32. */
+    static std::vector<uint8_t> encode(const MeshArrays& mesh, double uv_half_max_range = 64.0, Stats* stats = nullptr);
+    static bool decode(const uint8_t* data, size_t size, MeshArrays& out);
+
+    /**
+     * Encodes Godot mesh arrays (vertices and optionally normals, uvs and indices).
+     * @return The encoded bytes, to be stored with store_var/put_var; empty if the indices are malformed.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::PackedByteArray encode_arrays(godot::Array arrays);
+
+    /**
+     * Decodes bytes produced by encode_arrays back into mesh arrays.
+     * @return Mesh arrays, or an empty Array if the data is invalid.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Array decode_arrays(godot::PackedByteArray data) const;
+
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary get_last_stats() const;
+
+    void set_uv_half_max_range(double value) {
+        uv_half_max_range = value;
+    }
+    double get_uv_half_max_range() const {
+        return uv_half_max_range;
+    }
+
+protected:
+    static void _bind_methods();
+
+private:
+    Stats last_stats;
+    double uv_half_max_range = 64.0;
+};
+
+#endif // GEOMETRY_CODEC_H
@@ -0,0 +1,157 @@
+#include "MappedFile.h"
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept {
+    *this = std::move(rhs);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept {
+    if (this != &rhs) {
+        close();
+        std::swap(bytes, rhs.bytes);
+        std::swap(length, rhs.length);
+        std::swap(opened, rhs.opened);
+#ifdef _WIN32
+        std::swap(file_handle, rhs.file_handle);
+        std::swap(mapping_handle, rhs.mapping_handle);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+
+    const int wide_length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (wide_length <= 0)
+        return false;
+    std::wstring wide_path(static_cast<size_t>(wide_length), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wide_path.data(), wide_length);
+
+    HANDLE file = CreateFileW(wide_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        access == SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    opened = true;
+    if (file_size.QuadPart == 0)
+        return true;
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        return false;
+    }
+    mapping_handle = mapping;
+
+    bytes = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!bytes) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(file_size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes)
+        UnmapViewOfFile(bytes);
+    if (mapping_handle)
+        CloseHandle(static_cast<HANDLE>(mapping_handle));
+    if (file_handle)
+        CloseHandle(static_cast<HANDLE>(file_handle));
+    bytes = nullptr;
+    length = 0;
+    opened = false;
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    opened = true;
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        opened = false;
+        return false;
+    }
+
+    bytes = static_cast<const uint8_t*>(mapped);
+    length = static_cast<size_t>(st.st_size);
+    // Read the whole file ahead for sequential parsing; windowed readers only touch the pages they need.
+    madvise(mapped, length, access == SEQUENTIAL ? MADV_WILLNEED : MADV_RANDOM);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes)
+        munmap(const_cast<uint8_t*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#endif
+
+std::string MappedFile::native_path(const godot::String& path) {
+    return std::string(godot::ProjectSettings::get_singleton()->globalize_path(path).utf8().get_data());
+}
+
+bool FileBytes::open(const godot::String& path, MappedFile::Access access) {
+    buffer.clear();
+    if (mapped.open(MappedFile::native_path(path), access))
+        return true;
+
+    godot::Ref<godot::FileAccess> file = godot::FileAccess::open(path, godot::FileAccess::READ);
+    if (file.is_null() || !file->is_open())
+        return false;
+    const godot::PackedByteArray bytes = file->get_buffer(file->get_length());
+    buffer.assign(bytes.ptr(), bytes.ptr() + bytes.size());
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+#include <godot_cpp/variant/string.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only memory mapping of a whole file (mmap on POSIX, CreateFileMapping on Windows).
+ * The mapping is released when the object is destroyed; it can be moved but not copied.
+ * An empty file opens successfully with data() == nullptr and size() == 0.
+ */
+class MappedFile {
+public:
+    /* How the mapping will be read; tells the OS whether to read ahead. */
+    enum Access {
+        SEQUENTIAL,
+        RANDOM,
+    };
+
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path, Access access = SEQUENTIAL) {
+        open(path, access);
+    }
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& rhs) noexcept;
+    MappedFile& operator=(MappedFile&& rhs) noexcept;
+
+    /* @param path Native file system path (see native_path). @return Whether the file is mapped. */
+    bool open(const std::string& path, Access access = SEQUENTIAL);
+    void close();
+
+    bool is_open() const {
+        return opened;
+    }
+    const uint8_t* data() const {
+        return bytes;
+    }
+    const char* chars() const {
+        return reinterpret_cast<const char*>(bytes);
+    }
+    size_t size() const {
+        return length;
+    }
+
+    /* Converts a Godot path (res://, user:// or absolute) into a native UTF-8 path. */
+    static std::string native_path(const godot::String& path);
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
+
+/**
+ * Bytes of a whole file: mapped when the file is on disk, otherwise (e.g. inside a .pck)
+ * read into memory through FileAccess.
+ */
+class FileBytes {
+public:
+    /* @param path Godot path. @return Whether the file could be opened. */
+    bool open(const godot::String& path, MappedFile::Access access = MappedFile::SEQUENTIAL);
+
+    const uint8_t* data() const {
+        return mapped.is_open() ? mapped.data() : buffer.data();
+    }
+    const char* chars() const {
+        return reinterpret_cast<const char*>(data());
+    }
+    size_t size() const {
+        return mapped.is_open() ? mapped.size() : buffer.size();
+    }
+
+private:
+    MappedFile mapped;
+    std::vector<uint8_t> buffer;
+};
+
+#endif // MAPPED_FILE_H
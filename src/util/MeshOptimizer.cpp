@@ -0,0 +1,474 @@
+#include "MeshOptimizer.h"
+#include <godot_cpp/classes/mesh.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+using namespace godot;
+
+namespace {
+    template <typename T, typename P>
+    P to_packed(const std::vector<T>& v) {
+        P packed;
+        packed.resize(v.size());
+        if (!v.empty())
+            std::memcpy(packed.ptrw(), v.data(), v.size() * sizeof(T));
+        return packed;
+    }
+
+    template <typename T, typename P>
+    std::vector<T> from_packed(const Variant& variant) {
+        const P packed = variant;
+        return std::vector<T>(packed.ptr(), packed.ptr() + packed.size());
+    }
+
+    size_t vertex_stride(const MeshArrays& mesh) {
+        return sizeof(Vector3) + (mesh.normals.empty() ? 0 : sizeof(Vector3)) + (mesh.uvs.empty() ? 0 : sizeof(Vector2));
+    }
+
+    int64_t mesh_bytes(const MeshArrays& mesh) {
+        return static_cast<int64_t>(mesh.vertices.size() * vertex_stride(mesh) + mesh.indices.size() * sizeof(int32_t));
+    }
+
+    /* All attributes of one vertex, compared bitwise. */
+    struct VertexKey {
+        real_t data[8];
+
+        bool operator==(const VertexKey& rhs) const {
+            return std::memcmp(data, rhs.data, sizeof(data)) == 0;
+        }
+    };
+
+    struct VertexKeyHash {
+        size_t operator()(const VertexKey& key) const {
+            // FNV-1a over the raw bytes.
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.data);
+            uint64_t hash = 1469598103934665603ull;
+            for (size_t i = 0; i < sizeof(key.data); i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    /* Tom Forsyth's vertex scoring, see "Linear-Speed Vertex Cache Optimisation". */
+    const int FORSYTH_CACHE_SIZE = 32;
+
+    float forsyth_score(int cache_position, int live_triangles) {
+        if (live_triangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cache_position >= 0) {
+            if (cache_position < 3) {
+                score = 0.75f;
+            } else {
+                const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cache_position - 3) * scaler, 1.5f);
+            }
+        }
+        return score + 2.0f * std::pow(static_cast<float>(live_triangles), -0.5f);
+    }
+}
+
+/* MeshArrays */
+
+void MeshArrays::append(const MeshArrays& rhs) {
+    const int32_t base = static_cast<int32_t>(vertices.size());
+    vertices.insert(vertices.end(), rhs.vertices.begin(), rhs.vertices.end());
+    normals.insert(normals.end(), rhs.normals.begin(), rhs.normals.end());
+    uvs.insert(uvs.end(), rhs.uvs.begin(), rhs.uvs.end());
+    for (int32_t index : rhs.indices)
+        indices.push_back(base + index);
+}
+
+Array MeshArrays::to_godot() const {
+    Array arrays;
+    arrays.resize(Mesh::ARRAY_MAX);
+    arrays[Mesh::ARRAY_VERTEX] = to_packed<Vector3, PackedVector3Array>(vertices);
+    if (!normals.empty())
+        arrays[Mesh::ARRAY_NORMAL] = to_packed<Vector3, PackedVector3Array>(normals);
+    if (!uvs.empty())
+        arrays[Mesh::ARRAY_TEX_UV] = to_packed<Vector2, PackedVector2Array>(uvs);
+    if (!indices.empty())
+        arrays[Mesh::ARRAY_INDEX] = to_packed<int32_t, PackedInt32Array>(indices);
+    return arrays;
+}
+
+bool MeshArrays::from_godot(const Array& arrays, MeshArrays& out) {
+    MeshArrays mesh;
+    if (arrays.size() < Mesh::ARRAY_MAX) {
+        out = std::move(mesh);
+        return true;
+    }
+
+    mesh.vertices = from_packed<Vector3, PackedVector3Array>(arrays[Mesh::ARRAY_VERTEX]);
+    if (arrays[Mesh::ARRAY_NORMAL].get_type() == Variant::PACKED_VECTOR3_ARRAY)
+        mesh.normals = from_packed<Vector3, PackedVector3Array>(arrays[Mesh::ARRAY_NORMAL]);
+    if (arrays[Mesh::ARRAY_TEX_UV].get_type() == Variant::PACKED_VECTOR2_ARRAY)
+        mesh.uvs = from_packed<Vector2, PackedVector2Array>(arrays[Mesh::ARRAY_TEX_UV]);
+    if (arrays[Mesh::ARRAY_INDEX].get_type() == Variant::PACKED_INT32_ARRAY)
+        mesh.indices = from_packed<int32_t, PackedInt32Array>(arrays[Mesh::ARRAY_INDEX]);
+
+    // Indices are trusted by everything downstream, so malformed ones are rejected here.
+    ERR_FAIL_COND_V_MSG(mesh.indices.size() % 3 != 0, false, "Mesh index count is not a multiple of 3.");
+    const int64_t vertex_count = static_cast<int64_t>(mesh.vertices.size());
+    for (int32_t index : mesh.indices)
+        ERR_FAIL_COND_V_MSG(index < 0 || index >= vertex_count, false, "Mesh index out of range of the vertex array.");
+
+    // Attributes that do not match the vertex count are dropped rather than misread.
+    if (mesh.normals.size() != mesh.vertices.size())
+        mesh.normals.clear();
+    if (mesh.uvs.size() != mesh.vertices.size())
+        mesh.uvs.clear();
+    out = std::move(mesh);
+    return true;
+}
+
+/* Stats */
+
+MeshOptimizer::Stats& MeshOptimizer::Stats::operator+=(const Stats& rhs) {
+    // ACMR is averaged weighted by triangle count.
+    const int64_t total_triangles = triangles + rhs.triangles;
+    if (total_triangles > 0) {
+        acmr_before = (acmr_before * triangles + rhs.acmr_before * rhs.triangles) / total_triangles;
+        acmr_after = (acmr_after * triangles + rhs.acmr_after * rhs.triangles) / total_triangles;
+    }
+    input_vertices += rhs.input_vertices;
+    output_vertices += rhs.output_vertices;
+    triangles = total_triangles;
+    input_bytes += rhs.input_bytes;
+    output_bytes += rhs.output_bytes;
+    return *this;
+}
+
+Dictionary MeshOptimizer::Stats::to_dictionary() const {
+    Dictionary d;
+    d["input_vertices"] = input_vertices;
+    d["output_vertices"] = output_vertices;
+    d["triangles"] = triangles;
+    d["input_bytes"] = input_bytes;
+    d["output_bytes"] = output_bytes;
+    d["acmr_before"] = acmr_before;
+    d["acmr_after"] = acmr_after;
+    return d;
+}
+
+/* Passes */
+
+void MeshOptimizer::weld(MeshArrays& mesh) {
+    const bool has_normals = !mesh.normals.empty(), has_uvs = !mesh.uvs.empty();
+    const size_t corner_count = mesh.indices.empty() ? mesh.vertices.size() : mesh.indices.size();
+
+    MeshArrays out;
+    out.indices.reserve(corner_count);
+    std::unordered_map<VertexKey, int32_t, VertexKeyHash> unique;
+    unique.reserve(corner_count);
+
+    for (size_t corner = 0; corner < corner_count; corner++) {
+        const size_t v = mesh.indices.empty() ? corner : static_cast<size_t>(mesh.indices[corner]);
+
+        VertexKey key;
+        std::memset(key.data, 0, sizeof(key.data));
+        key.data[0] = mesh.vertices[v].x;
+        key.data[1] = mesh.vertices[v].y;
+        key.data[2] = mesh.vertices[v].z;
+        if (has_normals) {
+            key.data[3] = mesh.normals[v].x;
+            key.data[4] = mesh.normals[v].y;
+            key.data[5] = mesh.normals[v].z;
+        }
+        if (has_uvs) {
+            key.data[6] = mesh.uvs[v].x;
+            key.data[7] = mesh.uvs[v].y;
+        }
+
+        auto inserted = unique.emplace(key, static_cast<int32_t>(out.vertices.size()));
+        if (inserted.second) {
+            out.vertices.push_back(mesh.vertices[v]);
+            if (has_normals)
+                out.normals.push_back(mesh.normals[v]);
+            if (has_uvs)
+                out.uvs.push_back(mesh.uvs[v]);
+        }
+        out.indices.push_back(inserted.first->second);
+    }
+
+    mesh = std::move(out);
+}
+
+void MeshOptimizer::optimize_vertex_cache(std::vector<int32_t>& indices, size_t vertex_count) {
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+        return;
+
+    // Vertex -> triangle adjacency (compact, with per-vertex live counts).
+    std::vector<int> live(vertex_count, 0);
+    for (int32_t index : indices)
+        live[index]++;
+
+    std::vector<size_t> adjacency_offset(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++)
+        adjacency_offset[v + 1] = adjacency_offset[v] + live[v];
+
+    std::vector<int32_t> adjacency(indices.size());
+    {
+        std::vector<size_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+        for (size_t t = 0; t < triangle_count; t++) {
+            for (int k = 0; k < 3; k++)
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<int32_t>(t);
+        }
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+        vertex_score[v] = forsyth_score(-1, live[v]);
+
+    std::vector<float> triangle_score(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    for (size_t t = 0; t < triangle_count; t++) {
+        triangle_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+    }
+
+    int32_t best = static_cast<int32_t>(std::max_element(triangle_score.begin(), triangle_score.end()) - triangle_score.begin());
+    size_t scan_cursor = 0;
+
+    std::vector<int32_t> cache, new_cache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    new_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    std::vector<int32_t> out;
+    out.reserve(indices.size());
+
+    for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++) {
+        if (best < 0) {
+            // Cache ran dry: continue with the next triangle that has not been emitted yet.
+            while (emitted[scan_cursor])
+                scan_cursor++;
+            best = static_cast<int32_t>(scan_cursor);
+        }
+
+        const int32_t* tri = &indices[best * 3];
+        out.insert(out.end(), tri, tri + 3);
+        emitted[best] = true;
+
+        // Remove the triangle from its vertices' live lists.
+        for (int k = 0; k < 3; k++) {
+            const int32_t v = tri[k];
+            int32_t* begin = &adjacency[adjacency_offset[v]];
+            int32_t* end = begin + live[v];
+            int32_t* it = std::find(begin, end, best);
+            if (it != end) {
+                *it = *(end - 1);
+                live[v]--;
+            }
+        }
+
+        // New LRU cache: triangle vertices first, then the old contents.
+        new_cache.assign(tri, tri + 3);
+        for (int32_t v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                new_cache.push_back(v);
+        }
+        for (int32_t v : cache)
+            cache_position[v] = -1;
+
+        // Rescore cached and just evicted vertices, then pick the best triangle touching them.
+        for (size_t i = 0; i < new_cache.size(); i++) {
+            const int32_t v = new_cache[i];
+            const int position = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            cache_position[v] = position;
+
+            const float new_score = forsyth_score(position, live[v]);
+            const float delta = new_score - vertex_score[v];
+            vertex_score[v] = new_score;
+
+            for (int a = 0; a < live[v]; a++)
+                triangle_score[adjacency[adjacency_offset[v] + a]] += delta;
+        }
+
+        best = -1;
+        float best_score = -1.0f;
+        for (int32_t v : new_cache) {
+            for (int a = 0; a < live[v]; a++) {
+                const int32_t t = adjacency[adjacency_offset[v] + a];
+                if (triangle_score[t] > best_score) {
+                    best_score = triangle_score[t];
+                    best = t;
+                }
+            }
+        }
+
+        if (new_cache.size() > FORSYTH_CACHE_SIZE) {
+            for (size_t i = FORSYTH_CACHE_SIZE; i < new_cache.size(); i++)
+                cache_position[new_cache[i]] = -1;
+            new_cache.resize(FORSYTH_CACHE_SIZE);
+        }
+        std::swap(cache, new_cache);
+    }
+
+    indices = std::move(out);
+}
+
+void MeshOptimizer::optimize_overdraw(std::vector<int32_t>& indices, const std::vector<Vector3>& vertices, float threshold) {
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count < 2)
+        return;
+
+    // Split the cache-optimized sequence into clusters. A triangle with three cache misses starts
+    // a new cluster anyway; otherwise we split where the cluster is already cheap enough.
+    const int cache_size = 16;
+    std::vector<uint32_t> timestamps(vertices.size(), 0);
+    uint32_t now = cache_size + 1;
+    const double total_acmr = compute_acmr(indices, vertices.size(), cache_size);
+
+    std::vector<size_t> cluster_starts;
+    size_t cluster_misses = 0, cluster_triangles = 0;
+    for (size_t t = 0; t < triangle_count; t++) {
+        int misses = 0;
+        for (int k = 0; k < 3; k++) {
+            const int32_t v = indices[t * 3 + k];
+            if (now - timestamps[v] > static_cast<uint32_t>(cache_size)) {
+                timestamps[v] = now++;
+                misses++;
+            }
+        }
+
+        const bool hard_boundary = misses == 3;
+        const bool soft_boundary = cluster_triangles >= 16 && misses >= 2 &&
+                                   static_cast<double>(cluster_misses) / cluster_triangles <= total_acmr * threshold;
+        if (t == 0 || hard_boundary || soft_boundary) {
+            cluster_starts.push_back(t);
+            cluster_misses = 0;
+            cluster_triangles = 0;
+        }
+        cluster_misses += misses;
+        cluster_triangles++;
+    }
+
+    const size_t cluster_count = cluster_starts.size();
+    if (cluster_count < 2)
+        return;
+    cluster_starts.push_back(triangle_count);
+
+    // Sort clusters by how much they face away from the mesh center.
+    Vector3 mesh_center;
+    double mesh_area = 0.0;
+    std::vector<Vector3> cluster_centroid(cluster_count), cluster_normal(cluster_count);
+    for (size_t c = 0; c < cluster_count; c++) {
+        Vector3 centroid, normal;
+        double area = 0.0;
+        for (size_t t = cluster_starts[c]; t < cluster_starts[c + 1]; t++) {
+            const Vector3& a = vertices[indices[t * 3]];
+            const Vector3& b = vertices[indices[t * 3 + 1]];
+            const Vector3& d = vertices[indices[t * 3 + 2]];
+            // Godot front faces are clockwise, so the outward normal is (c - a) x (b - a).
+            const Vector3 n = (d - a).cross(b - a);
+            const real_t tri_area = n.length();
+            centroid += (a + b + d) * (tri_area / 3.0f);
+            normal += n;
+            area += tri_area;
+        }
+        mesh_center += centroid;
+        mesh_area += area;
+        cluster_centroid[c] = area > 0.0 ? centroid / static_cast<real_t>(area) : vertices[indices[cluster_starts[c] * 3]];
+        cluster_normal[c] = normal.normalized();
+    }
+    if (mesh_area > 0.0)
+        mesh_center /= static_cast<real_t>(mesh_area);
+
+    std::vector<float> sort_key(cluster_count);
+    for (size_t c = 0; c < cluster_count; c++)
+        sort_key[c] = (cluster_centroid[c] - mesh_center).dot(cluster_normal[c]);
+
+    std::vector<size_t> order(cluster_count);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&sort_key](size_t a, size_t b) { return sort_key[a] > sort_key[b]; });
+
+    std::vector<int32_t> out;
+    out.reserve(indices.size());
+    for (size_t c : order)
+        out.insert(out.end(), indices.begin() + cluster_starts[c] * 3, indices.begin() + cluster_starts[c + 1] * 3);
+    indices = std::move(out);
+}
+
+void MeshOptimizer::optimize_vertex_fetch(MeshArrays& mesh) {
+    std::vector<int32_t> remap(mesh.vertices.size(), -1);
+    int32_t next = 0;
+    for (int32_t& index : mesh.indices) {
+        if (remap[index] < 0)
+            remap[index] = next++;
+        index = remap[index];
+    }
+
+    auto reorder = [&remap, next](auto& attribute) {
+        if (attribute.empty())
+            return;
+        std::remove_reference_t<decltype(attribute)> reordered(next);
+        for (size_t v = 0; v < remap.size(); v++) {
+            if (remap[v] >= 0)
+                reordered[remap[v]] = attribute[v];
+        }
+        attribute = std::move(reordered);
+    };
+
+    reorder(mesh.vertices);
+    reorder(mesh.normals);
+    reorder(mesh.uvs);
+}
+
+double MeshOptimizer::compute_acmr(const std::vector<int32_t>& indices, size_t vertex_count, int cache_size) {
+    if (indices.size() < 3)
+        return 0.0;
+
+    std::vector<uint32_t> timestamps(vertex_count, 0);
+    uint32_t now = cache_size + 1;
+    size_t misses = 0;
+    for (int32_t v : indices) {
+        if (now - timestamps[v] > static_cast<uint32_t>(cache_size)) {
+            timestamps[v] = now++;
+            misses++;
+        }
+    }
+    return static_cast<double>(misses) / (indices.size() / 3);
+}
+
+MeshOptimizer::Stats MeshOptimizer::optimize(MeshArrays& mesh, float overdraw_threshold) {
+    Stats stats;
+    stats.input_vertices = static_cast<int64_t>(mesh.vertices.size());
+    stats.triangles = static_cast<int64_t>(mesh.triangle_count());
+    stats.input_bytes = mesh_bytes(mesh);
+    // A triangle soup transforms every corner.
+    stats.acmr_before = mesh.indices.empty() ? (stats.triangles > 0 ? 3.0 : 0.0) : compute_acmr(mesh.indices, mesh.vertices.size());
+
+    if (stats.triangles > 0) {
+        weld(mesh);
+        optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+        optimize_overdraw(mesh.indices, mesh.vertices, overdraw_threshold);
+        optimize_vertex_fetch(mesh);
+    }
+
+    stats.output_vertices = static_cast<int64_t>(mesh.vertices.size());
+    stats.output_bytes = mesh_bytes(mesh);
+    stats.acmr_after = compute_acmr(mesh.indices, mesh.vertices.size());
+    return stats;
+}
+
+Array MeshOptimizer::optimize_arrays(Array arrays) {
+    MeshArrays mesh;
+    if (!MeshArrays::from_godot(arrays, mesh))
+        return arrays;
+    last_stats = optimize(mesh);
+    return mesh.to_godot();
+}
+
+void MeshOptimizer::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("optimize_arrays", "arrays"), &MeshOptimizer::optimize_arrays);
+    ClassDB::bind_method(D_METHOD("get_last_stats"), &MeshOptimizer::get_last_stats);
+}
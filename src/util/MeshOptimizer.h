@@ -0,0 +1,84 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <cstdint>
+#include <vector>
+#include "Util.h"
+
+/* Plain C++ mesh arrays shared by the native meshers. Empty indices mean a triangle soup. */
+struct MeshArrays {
+    std::vector<godot::Vector3> vertices;
+    std::vector<godot::Vector3> normals;
+    std::vector<godot::Vector2> uvs;
+    std::vector<int32_t> indices;
+
+    size_t triangle_count() const {
+        return (indices.empty() ? vertices.size() : indices.size()) / 3;
+    }
+
+    /* Appends rhs (soup or indexed) to this mesh; both must be of the same kind. */
+    void append(const MeshArrays& rhs);
+
+    /* Mesh arrays as expected by ArrayMesh::add_surface_from_arrays. */
+    godot::Array to_godot() const;
+    /* @return false, leaving out untouched, if an index is out of range or the index count is not a multiple of 3. */
+    static bool from_godot(const godot::Array& arrays, MeshArrays& out);
+};
+
+/**
+ * Turns triangle soups into indexed meshes that are cheap to store and render:
+ *  1. weld: bit-identical vertices are merged,
+ *  2. vertex cache: triangles are reordered for the post-transform cache (Forsyth),
+ *  3. overdraw: cache-friendly clusters are sorted so outward facing ones are drawn first,
+ *  4. vertex fetch: vertices are renumbered in the order the index buffer uses them.
+ */
+class MeshOptimizer : public godot::RefCounted {
+    GDCLASS(MeshOptimizer, godot::RefCounted);
+public:
+    struct Stats {
+        int64_t input_vertices = 0;
+        int64_t output_vertices = 0;
+        int64_t triangles = 0;
+        int64_t input_bytes = 0;
+        int64_t output_bytes = 0;
+        /* Average cache miss ratio (transformed vertices per triangle) of a 16 entry FIFO. */
+        double acmr_before = 0.0;
+        double acmr_after = 0.0;
+
+        Stats& operator+=(const Stats& rhs);
+        godot::Dictionary to_dictionary() const;
+    };
+
+    /**
+     * Runs all passes on a soup or indexed mesh.
+     * @param overdraw_threshold Allowed ACMR degradation (e.g. 1.05) traded for less overdraw.
+     */
+    static Stats optimize(MeshArrays& mesh, float overdraw_threshold = 1.05f);
+
+    static void weld(MeshArrays& mesh);
+    static void optimize_vertex_cache(std::vector<int32_t>& indices, size_t vertex_count);
+    static void optimize_overdraw(std::vector<int32_t>& indices, const std::vector<godot::Vector3>& vertices, float threshold);
+    static void optimize_vertex_fetch(MeshArrays& mesh);
+    static double compute_acmr(const std::vector<int32_t>& indices, size_t vertex_count, int cache_size = 16);
+
+    /**
+     * Optimizes Godot mesh arrays (e.g. from RenderUtil) and returns indexed arrays.
+     * Statistics of the last call are available through get_last_stats.
+     * Arrays with out of range indices, or an index count that is not a multiple of 3, are returned unchanged.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Array optimize_arrays(godot::Array arrays);
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary get_last_stats() const {
+        return last_stats.to_dictionary();
+    }
+
+protected:
+    static void _bind_methods();
+
+private:
+    Stats last_stats;
+};
+
+#endif // MESH_OPTIMIZER_H
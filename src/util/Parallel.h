@@ -0,0 +1,72 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Returns how many workers parallel_for_ranges will use for the given amount of work.
+ * Use this to size per-worker scratch buffers before calling parallel_for_ranges.
+ *
+ * @param count Number of work items.
+ * @param min_items_per_worker Do not spawn a worker for less than this many items.
+ */
+inline size_t parallel_worker_count(size_t count, size_t min_items_per_worker = 1) {
+    const size_t hw = std::max<size_t>(1u, std::thread::hardware_concurrency());
+    const size_t by_work = std::max<size_t>(1u, count / std::max<size_t>(1u, min_items_per_worker));
+    return std::max<size_t>(1u, std::min(hw, by_work));
+}
+
+/**
+ * Splits [0, count) into contiguous ranges and calls f(begin, end, worker_index) for each of them,
+ * one std::thread per range. The calling thread runs the first range itself.
+ * Godot Variants are not safe to share between workers, so convert input to plain C++ data first.
+ */
+template <typename F>
+void parallel_for_ranges(size_t count, F &&f, size_t min_items_per_worker = 1) {
+    if (count == 0) {
+        return;
+    }
+
+    const size_t workers = parallel_worker_count(count, min_items_per_worker);
+    if (workers == 1) {
+        f(size_t(0), count, size_t(0));
+        return;
+    }
+
+    const size_t per_worker = (count + workers - 1) / workers;
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+
+    for (size_t w = 1; w < workers; w++) {
+        const size_t begin = std::min(count, w * per_worker);
+        const size_t end = std::min(count, begin + per_worker);
+        if (begin < end) {
+            threads.emplace_back([&f, begin, end, w]() { f(begin, end, w); });
+        }
+    }
+
+    f(size_t(0), std::min(count, per_worker), size_t(0));
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * Calls f(i, worker_index) for every i in [0, count), spread over worker threads.
+ */
+template <typename F>
+void parallel_for(size_t count, F &&f, size_t min_items_per_worker = 1) {
+    parallel_for_ranges(
+        count,
+        [&f](size_t begin, size_t end, size_t worker) {
+            for (size_t i = begin; i < end; i++) {
+                f(i, worker);
+            }
+        },
+        min_items_per_worker);
+}
+
+#endif // PARALLEL_H
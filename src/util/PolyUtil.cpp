@@ -6,6 +6,11 @@
 #include "../../extern/polyskel-cpp-port/polyskel.h"
 #include "../../extern/polyskel-cpp-port/vec.h"
 #include "../../extern/polyskel-cpp-port/lavertex.h"
+#include "Earcut.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 
 using namespace godot;
 
@@ -41,72 +46,387 @@ void SkeletonSubtree::_bind_methods() {
     ADD_PROPERTY(PropertyInfo(Variant::PACKED_VECTOR2_ARRAY, "sinks"), "set_sinks", "get_sinks");
 }
 
-bool polygon_invalid_edges_check(const std::vector<p2t::Point*>& polygon) {
-    const double epsilon = 1e-16;
-    for (int i = 0; i < polygon.size() - 1; i++) {
-        int j = i + 1;
-        if (std::abs(polygon[i]->x - polygon[j]->x) < epsilon && std::abs(polygon[i]->y - polygon[j]->y) < epsilon) {
-            ERR_PRINT("Duplicate point in polygon");
+namespace {
+    /* Ear clipping results whose area is off by more than this fraction go to CDT. */
+    const double EARCUT_MAX_DEVIATION = 1e-6;
+
+    int64_t usec_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * Scratch memory of one triangulating thread. It is reset rather than freed after every polygon, so once it has
+     * grown to the largest polygon, only poly2tri itself allocates.
+     */
+    struct TriangulationArena {
+        Earcut earcut;
+        std::vector<p2t::Point> points;
+        /* Input index of every point. */
+        std::vector<int32_t> sources;
+        std::vector<std::vector<p2t::Point*>> rings;
+        size_t ring_count = 0;
+
+        void reset() {
+            points.clear();
+            sources.clear();
+            for (size_t i = 0; i < ring_count; i++)
+                rings[i].clear();
+            ring_count = 0;
+        }
+        std::vector<p2t::Point*>& next_ring() {
+            if (ring_count == rings.size())
+                rings.emplace_back();
+            return rings[ring_count++];
+        }
+    };
+
+    /* Adds a ring without its repeated first point. @return false if it has less than 3 points or the same point twice in a row. */
+    bool add_ring(TriangulationArena& arena, const Vector2* points, int32_t begin, int32_t end) {
+        const double epsilon = 1e-16;
+        auto same = [&](int32_t i, int32_t j) {
+            return std::abs(points[i].x - points[j].x) < epsilon && std::abs(points[i].y - points[j].y) < epsilon;
+        };
+        if (end - begin > 1 && same(begin, end - 1))
+            end--;
+        if (end - begin < 3)
+            return false;
+
+        std::vector<p2t::Point*>& ring = arena.next_ring();
+        for (int32_t i = begin; i < end; i++) {
+            if (same(i, i + 1 < end ? i + 1 : begin))
+                return false;
+            arena.points.emplace_back(points[i].x, points[i].y);
+            arena.sources.push_back(i);
+            ring.push_back(&arena.points.back());
+        }
+        return true;
+    }
+
+    /* Constrained Delaunay triangulation of rings [first_ring, end_ring). @return false if a ring was rejected; out is then unchanged. */
+    bool cdt_polygon(TriangulationArena& arena, const Vector2* points, const int32_t* ring_offsets, int32_t first_ring, int32_t end_ring,
+                     std::vector<int32_t>& out) {
+        arena.reset();
+        // Reserved up front: the rings point into this buffer.
+        arena.points.reserve(static_cast<size_t>(ring_offsets[end_ring] - ring_offsets[first_ring]));
+        for (int32_t r = first_ring; r < end_ring; r++)
+            if (!add_ring(arena, points, ring_offsets[r], ring_offsets[r + 1]))
+                return false;
+
+        p2t::CDT cdt(arena.rings[0]);
+        for (size_t r = 1; r < arena.ring_count; r++)
+            cdt.AddHole(arena.rings[r]);
+        cdt.Triangulate();
+
+        const p2t::Point* base = arena.points.data();
+        for (const auto& triangle : cdt.GetTriangles())
+            for (int i = 0; i < 3; i++)
+                out.push_back(arena.sources[triangle->GetPoint(i) - base]);
+        return true;
+    }
+
+    /* Whether flat ring and polygon offsets are ascending and stay within points. */
+    bool valid_offsets(int64_t point_count, const PackedInt32Array& ring_offsets, const PackedInt32Array& polygon_offsets) {
+        const int64_t ring_count = ring_offsets.size() - 1, polygon_count = polygon_offsets.size() - 1;
+        bool valid = ring_count >= 0 && polygon_count >= 0 && ring_offsets[0] >= 0 && ring_offsets[ring_count] <= point_count &&
+                     polygon_offsets[0] >= 0 && polygon_offsets[polygon_count] <= ring_count;
+        for (int64_t i = 0; valid && i < ring_count; i++)
+            valid = ring_offsets[i] <= ring_offsets[i + 1];
+        for (int64_t i = 0; valid && i < polygon_count; i++)
+            valid = polygon_offsets[i] <= polygon_offsets[i + 1];
+        return valid;
+    }
+
+    template <typename T, typename Packed>
+    Packed to_packed(const std::vector<T>& values) {
+        Packed packed;
+        packed.resize(static_cast<int64_t>(values.size()));
+        std::copy(values.begin(), values.end(), packed.ptrw());
+        return packed;
+    }
+
+    /*
+     * Ring [begin, end) without its repeated first point and consecutive duplicates, which polyskel cannot handle.
+     * Outer rings are wound like RenderUtil.enforce_winding(verts, false), holes the other way round.
+     */
+    std::vector<Vector2> skeleton_ring(const Vector2* points, int32_t begin, int32_t end, bool hole) {
+        std::vector<Vector2> ring;
+        ring.reserve(static_cast<size_t>(end - begin));
+        for (int32_t i = begin; i < end; i++)
+            if (ring.empty() || ring.back() != points[i])
+                ring.push_back(points[i]);
+        while (ring.size() > 1 && ring.front() == ring.back())
+            ring.pop_back();
+
+        double winding_val = 0.0;
+        for (size_t i = 0; i < ring.size(); i++) {
+            const Vector2& cur = ring[i];
+            const Vector2& next = ring[(i + 1) % ring.size()];
+            winding_val += (static_cast<double>(next.x) - cur.x) * (static_cast<double>(next.y) + cur.y);
+        }
+        if ((winding_val < 0.0) != hole)
+            std::reverse(ring.begin(), ring.end());
+        return ring;
+    }
+
+    /* Appends the subtrees to the flat batch. */
+    void append_subtrees(const std::vector<PolyUtil::Subtree>& subtrees, PolyUtil::SkeletonBatch& out) {
+        for (const auto& subtree : subtrees) {
+            out.sources.push_back(subtree.source);
+            out.heights.push_back(subtree.height);
+            out.sinks.insert(out.sinks.end(), subtree.sinks.begin(), subtree.sinks.end());
+            out.sink_offsets.push_back(static_cast<int32_t>(out.sinks.size()));
+        }
+    }
+
+    enum class EarcutResult {
+        OK,
+        /* No triangles or the wrong area; out is unchanged. */
+        WRONG,
+        /* The polygon has no area, so there is nothing for CDT to do either. */
+        DEGENERATE,
+    };
+
+    EarcutResult earcut_polygon(TriangulationArena& arena, const Vector2* points, const int32_t* ring_offsets, int32_t first_ring, int32_t end_ring,
+                                std::vector<int32_t>& out) {
+        const size_t first = out.size();
+        const int32_t* rings = ring_offsets + first_ring;
+        const int32_t ring_count = end_ring - first_ring;
+        const bool made = arena.earcut.triangulate(points, rings, ring_count, out);
+        const double deviation = Earcut::deviation(points, rings, ring_count, out, first);
+        if (made && deviation <= EARCUT_MAX_DEVIATION)
+            return EarcutResult::OK;
+        out.resize(first);
+        return !made && deviation == 0.0 ? EarcutResult::DEGENERATE : EarcutResult::WRONG;
+    }
+
+    /**
+     * Triangulates the polygon made of rings [first_ring, end_ring), appending indices into points to out.
+     * @return false if neither path could; out is then unchanged.
+     */
+    bool triangulate_polygon(TriangulationArena& arena, const Vector2* points, const int32_t* ring_offsets, int32_t first_ring, int32_t end_ring,
+                             int cdt_point_threshold, PolyUtil::TriangulationStats& stats, std::vector<int32_t>& out) {
+        if (first_ring >= end_ring) {
+            stats.failed++;
             return false;
         }
+
+        auto try_earcut = [&]() {
+            const auto start = std::chrono::steady_clock::now();
+            const EarcutResult result = earcut_polygon(arena, points, ring_offsets, first_ring, end_ring, out);
+            stats.earcut_usec += usec_since(start);
+            if (result == EarcutResult::OK)
+                stats.earcut_polygons++;
+            return result;
+        };
+        auto try_cdt = [&]() {
+            const auto start = std::chrono::steady_clock::now();
+            const bool triangulated = cdt_polygon(arena, points, ring_offsets, first_ring, end_ring, out);
+            stats.cdt_usec += usec_since(start);
+            if (triangulated)
+                stats.cdt_polygons++;
+            return triangulated;
+        };
+
+        const int32_t point_count = ring_offsets[end_ring] - ring_offsets[first_ring];
+        if (cdt_point_threshold <= 0 || point_count < cdt_point_threshold) {
+            const EarcutResult result = try_earcut();
+            if (result == EarcutResult::OK)
+                return true;
+            if (result == EarcutResult::WRONG) {
+                stats.fallbacks++;
+                if (try_cdt())
+                    return true;
+            }
+        } else {
+            if (try_cdt())
+                return true;
+            stats.fallbacks++;
+            if (try_earcut() == EarcutResult::OK)
+                return true;
+        }
+        stats.failed++;
+        return false;
     }
-    return true;
+}
+
+void PolyUtil::TriangulationStats::add(const TriangulationStats& rhs) {
+    earcut_polygons += rhs.earcut_polygons;
+    cdt_polygons += rhs.cdt_polygons;
+    fallbacks += rhs.fallbacks;
+    failed += rhs.failed;
+    earcut_usec += rhs.earcut_usec;
+    cdt_usec += rhs.cdt_usec;
+}
+
+Dictionary PolyUtil::TriangulationStats::to_dictionary() const {
+    Dictionary d;
+    d["earcut_polygons"] = earcut_polygons;
+    d["cdt_polygons"] = cdt_polygons;
+    d["fallbacks"] = fallbacks;
+    d["failed"] = failed;
+    d["earcut_usec"] = earcut_usec;
+    d["cdt_usec"] = cdt_usec;
+    return d;
 }
 
 PackedVector2Array PolyUtil::triangulate_with_holes(PackedVector2Array outer, Array holes) {
-    //WARN_PRINT("Running triangulate w holes w outer size: " + String::num_int64(outer.size()) + " hole count: " + String::num_int64(holes.size()));
-    // Create polyline and CDT
-    std::vector<p2t::Point*> polyline;
-    polyline.reserve(outer.size());
-    for (const auto& v : outer)
-        polyline.push_back(new p2t::Point(v.x, v.y));
-
-    if (!polygon_invalid_edges_check(polyline))
+    // One flat polygon, so this goes through the same path as triangulate_batch.
+    PackedVector2Array points = outer;
+    std::vector<int32_t> ring_offsets = { 0, static_cast<int32_t>(outer.size()) };
+    for (int i = 0; i < holes.size(); i++) {
+        points.append_array(static_cast<PackedVector2Array>(holes[i]));
+        ring_offsets.push_back(static_cast<int32_t>(points.size()));
+    }
+
+    TriangulationArena arena;
+    std::vector<int32_t> indices;
+    last_stats = TriangulationStats();
+    if (!triangulate_polygon(arena, points.ptr(), ring_offsets.data(), 0, static_cast<int32_t>(ring_offsets.size() - 1), cdt_point_threshold,
+                             last_stats, indices)) {
+        ERR_PRINT("Could not triangulate polygon");
         return PackedVector2Array();
+    }
 
-    polyline.pop_back();
-    p2t::CDT* cdt = new p2t::CDT(polyline);
+    PackedVector2Array triangulated;
+    triangulated.resize(static_cast<int64_t>(indices.size()));
+    Vector2* dst = triangulated.ptrw();
+    const Vector2* src = points.ptr();
+    for (size_t i = 0; i < indices.size(); i++)
+        dst[i] = src[indices[i]];
+    return triangulated;
+}
 
-    // Add holes
-    for (int i = 0; i < holes.size(); i++) {
-        const PackedVector2Array& hole = holes[i];
-        std::vector<p2t::Point*> polyline;
-        for (const auto& v : hole) {
-            polyline.push_back(new p2t::Point(v.x, v.y));
+int64_t PolyUtil::triangulate_batch(const Vector2* points, const int32_t* ring_offsets, const int32_t* polygon_offsets,
+                                    size_t polygon_count, std::vector<int32_t>& out_indices, std::vector<int32_t>& out_offsets,
+                                    int cdt_point_threshold, TriangulationStats* stats) {
+    struct Result {
+        size_t worker, begin, count;
+    };
+    std::vector<Result> results(polygon_count);
+    const size_t workers = parallel_worker_count(polygon_count);
+    std::vector<std::vector<int32_t>> worker_indices(workers);
+    std::vector<TriangulationStats> worker_stats(workers);
+    std::atomic<size_t> next(0);
+
+    // Polygon sizes vary wildly, so workers take the next polygon when done instead of a fixed range.
+    parallel_for_ranges(workers, [&](size_t, size_t, size_t worker) {
+        TriangulationArena arena;
+        std::vector<int32_t>& indices = worker_indices[worker];
+        for (size_t p = next++; p < polygon_count; p = next++) {
+            const size_t begin = indices.size();
+            triangulate_polygon(arena, points, ring_offsets, polygon_offsets[p], polygon_offsets[p + 1], cdt_point_threshold, worker_stats[worker], indices);
+            results[p] = { worker, begin, indices.size() - begin };
         }
-        
-        if (!polygon_invalid_edges_check(polyline))
-            return PackedVector2Array();
+    });
 
-        polyline.pop_back();
+    out_offsets.resize(polygon_count + 1);
+    out_offsets[0] = 0;
+    for (size_t p = 0; p < polygon_count; p++)
+        out_offsets[p + 1] = out_offsets[p] + static_cast<int32_t>(results[p].count);
+    out_indices.resize(out_offsets[polygon_count]);
+    for (size_t p = 0; p < polygon_count; p++) {
+        const int32_t* src = worker_indices[results[p].worker].data() + results[p].begin;
+        std::copy(src, src + results[p].count, out_indices.data() + out_offsets[p]);
+    }
 
-        cdt->AddHole(polyline);
+    TriangulationStats total;
+    for (const auto& s : worker_stats)
+        total.add(s);
+    if (stats)
+        stats->add(total);
+    return total.failed;
+}
 
-        for (p2t::Point* v : polyline) {
-           ;// delete v;
-        }
+Dictionary PolyUtil::triangulate_batch(PackedVector2Array points, PackedInt32Array ring_offsets, PackedInt32Array polygon_offsets) {
+    last_stats = TriangulationStats();
+    if (!valid_offsets(points.size(), ring_offsets, polygon_offsets)) {
+        ERR_PRINT("triangulate_batch: offsets do not match the points.");
+        return Dictionary();
     }
 
+    std::vector<int32_t> indices, offsets;
+    const int64_t failed = triangulate_batch(points.ptr(), ring_offsets.ptr(), polygon_offsets.ptr(), static_cast<size_t>(polygon_offsets.size() - 1),
+                                             indices, offsets, cdt_point_threshold, &last_stats);
 
-    
-    cdt->Triangulate();
+    Dictionary result;
+    result["indices"] = to_packed<int32_t, PackedInt32Array>(indices);
+    result["offsets"] = to_packed<int32_t, PackedInt32Array>(offsets);
+    result["failed"] = failed;
+    return result;
+}
 
-    // Output
-    PackedVector2Array triangulated;
+int64_t PolyUtil::skeletonize_batch(const Vector2* points, const int32_t* ring_offsets, const int32_t* polygon_offsets,
+                                    size_t polygon_count, bool gabled, SkeletonBatch& out) {
+    struct Result {
+        size_t worker, begin, count;
+    };
+    std::vector<Result> results(polygon_count);
+    const size_t workers = parallel_worker_count(polygon_count);
+    std::vector<SkeletonBatch> worker_batches(workers);
+    std::atomic<size_t> next(0);
+    std::atomic<int64_t> failed(0);
+
+    // As in triangulate_batch, workers take the next polygon when done; skeleton cost grows fast with the point count.
+    parallel_for_ranges(workers, [&](size_t, size_t, size_t worker) {
+        SkeletonBatch& batch = worker_batches[worker];
+        std::vector<std::vector<Vector2>> holes;
+        for (size_t p = next++; p < polygon_count; p = next++) {
+            const size_t begin = batch.sources.size();
+            results[p] = { worker, begin, 0 };
+            const int32_t first_ring = polygon_offsets[p], end_ring = polygon_offsets[p + 1];
+            const std::vector<Vector2> outer =
+                first_ring < end_ring ? skeleton_ring(points, ring_offsets[first_ring], ring_offsets[first_ring + 1], false) : std::vector<Vector2>();
+            if (outer.size() < 3) {
+                failed++;
+                continue;
+            }
+            holes.clear();
+            for (int32_t r = first_ring + 1; r < end_ring; r++) {
+                holes.push_back(skeleton_ring(points, ring_offsets[r], ring_offsets[r + 1], true));
+                if (holes.back().size() < 3)
+                    holes.pop_back();
+            }
 
-    auto triangles = cdt->GetTriangles();
-    for (const auto& triangle : triangles) {
-        for (int i = 0; i < 3; i++) {
-            p2t::Point* p = triangle->GetPoint(i);
-            triangulated.append(Vector2(p->x, p->y));
+            std::vector<Subtree> subtrees = skeletonize(outer, holes);
+            if (gabled)
+                hipped_to_gabled(subtrees);
+            append_subtrees(subtrees, batch);
+            results[p].count = subtrees.size();
         }
+    });
+
+    // Subtrees are copied out in polygon order, rebasing their sink offsets.
+    for (size_t p = 0; p < polygon_count; p++) {
+        const SkeletonBatch& batch = worker_batches[results[p].worker];
+        for (size_t s = results[p].begin; s < results[p].begin + results[p].count; s++) {
+            out.sources.push_back(batch.sources[s]);
+            out.heights.push_back(batch.heights[s]);
+            out.sinks.insert(out.sinks.end(), batch.sinks.begin() + batch.sink_offsets[s], batch.sinks.begin() + batch.sink_offsets[s + 1]);
+            out.sink_offsets.push_back(static_cast<int32_t>(out.sinks.size()));
+        }
+        out.subtree_offsets.push_back(static_cast<int32_t>(out.sources.size()));
+    }
+    return failed;
+}
+
+Dictionary PolyUtil::straight_skeleton_batch(PackedVector2Array points, PackedInt32Array ring_offsets, PackedInt32Array polygon_offsets, bool gabled) {
+    if (!valid_offsets(points.size(), ring_offsets, polygon_offsets)) {
+        ERR_PRINT("straight_skeleton_batch: offsets do not match the points.");
+        return Dictionary();
     }
 
-    // Free
-    for (p2t::Point* v : polyline)
-        ;//delete v;
+    SkeletonBatch batch;
+    const int64_t failed = skeletonize_batch(points.ptr(), ring_offsets.ptr(), polygon_offsets.ptr(), static_cast<size_t>(polygon_offsets.size() - 1),
+                                             gabled, batch);
 
-    return triangulated;
+    Dictionary result;
+    result["sources"] = to_packed<Vector2, PackedVector2Array>(batch.sources);
+    result["heights"] = to_packed<double, PackedFloat64Array>(batch.heights);
+    result["sink_offsets"] = to_packed<int32_t, PackedInt32Array>(batch.sink_offsets);
+    result["sinks"] = to_packed<Vector2, PackedVector2Array>(batch.sinks);
+    result["subtree_offsets"] = to_packed<int32_t, PackedInt32Array>(batch.subtree_offsets);
+    result["failed"] = failed;
+    return result;
 }
 
 Array PolyUtil::straight_skeleton(PackedVector2Array outer, Array holes) {
@@ -145,7 +465,122 @@ Array PolyUtil::straight_skeleton(PackedVector2Array outer, Array holes) {
     return out;
 }
 
+bool PolyUtil::triangulate(const std::vector<Vector2>& outer, const std::vector<std::vector<Vector2>>& holes, std::vector<int>& out_indices,
+                           TriangulationStats* stats) {
+    // Meshers call this once per building from their workers, so each thread keeps its scratch memory.
+    thread_local TriangulationArena arena;
+    thread_local std::vector<Vector2> points;
+    thread_local std::vector<int32_t> ring_offsets;
+
+    points.assign(outer.begin(), outer.end());
+    ring_offsets.assign({ 0, static_cast<int32_t>(points.size()) });
+    for (const auto& hole : holes) {
+        points.insert(points.end(), hole.begin(), hole.end());
+        ring_offsets.push_back(static_cast<int32_t>(points.size()));
+    }
+
+    TriangulationStats polygon_stats;
+    const bool triangulated = triangulate_polygon(arena, points.data(), ring_offsets.data(), 0, static_cast<int32_t>(ring_offsets.size() - 1),
+                                                  DEFAULT_CDT_POINT_THRESHOLD, polygon_stats, out_indices);
+    if (stats)
+        stats->add(polygon_stats);
+    return triangulated;
+}
+
+std::vector<PolyUtil::Subtree> PolyUtil::skeletonize(const std::vector<Vector2>& outer, const std::vector<std::vector<Vector2>>& holes) {
+    std::vector<polyskel::Vec2> polyskel_outer;
+    std::vector<std::vector<polyskel::Vec2>> polyskel_holes;
+    polyskel_outer.reserve(outer.size());
+    for (const Vector2& v : outer)
+        polyskel_outer.push_back(polyskel::Vec2(v.x, v.y));
+
+    for (const auto& hole : holes) {
+        polyskel_holes.push_back(std::vector<polyskel::Vec2>());
+        for (const Vector2& v : hole)
+            polyskel_holes.back().push_back(polyskel::Vec2(v.x, v.y));
+    }
+
+    std::vector<Subtree> out;
+    for (const auto& subtree : polyskel::skeletonize(polyskel_outer, polyskel_holes)) {
+        Subtree st;
+        st.source = Vector2(subtree->source.x, subtree->source.y);
+        st.height = subtree->height;
+        st.sinks.reserve(subtree->sinks.size());
+        for (const auto& sink : subtree->sinks)
+            st.sinks.push_back(Vector2(sink.x, sink.y));
+        out.push_back(std::move(st));
+    }
+
+    return out;
+}
+
+void PolyUtil::hipped_to_gabled(std::vector<Subtree>& subtrees) {
+    // Index of the subtree whose source is the given point, -1 if the point is a polygon corner.
+    auto find_source = [&subtrees](const Vector2& p) -> int {
+        for (size_t i = 0; i < subtrees.size(); i++) {
+            if (subtrees[i].source == p)
+                return static_cast<int>(i);
+        }
+        return -1;
+    };
+
+    // Neighbour relation is computed on the original (hipped) sources only.
+    std::vector<Vector2> original_sources;
+    std::vector<std::vector<int>> neighbors(subtrees.size());
+    for (const auto& subtree : subtrees)
+        original_sources.push_back(subtree.source);
+
+    for (size_t i = 0; i < subtrees.size(); i++) {
+        for (const auto& sink : subtrees[i].sinks) {
+            const int j = find_source(sink);
+            if (j >= 0) {
+                neighbors[j].push_back(static_cast<int>(i));
+                neighbors[i].push_back(j);
+            }
+        }
+    }
+
+    auto is_original_source = [&original_sources](const Vector2& p) {
+        return std::find(original_sources.begin(), original_sources.end(), p) != original_sources.end();
+    };
+
+    // Ridge ends (subtrees with one neighbour) are moved onto the middle of their polygon edge.
+    for (size_t i = 0; i < subtrees.size(); i++) {
+        if (neighbors[i].size() != 1)
+            continue;
+
+        Subtree& subtree = subtrees[i];
+        const Vector2 old_source = subtree.source;
+        Vector2 new_source;
+        int corners = 0;
+        for (const auto& sink : subtree.sinks) {
+            if (!is_original_source(sink)) {
+                new_source += sink;
+                corners++;
+            }
+        }
+        if (corners == 0)
+            continue;
+
+        subtree.source = new_source / static_cast<real_t>(corners);
+
+        auto& neighbor_sinks = subtrees[neighbors[i][0]].sinks;
+        auto it = std::find(neighbor_sinks.begin(), neighbor_sinks.end(), old_source);
+        if (it != neighbor_sinks.end())
+            *it = subtree.source;
+    }
+}
+
 void PolyUtil::_bind_methods() {
     ClassDB::bind_method(D_METHOD("triangulate_with_holes", "outer", "holes"), &PolyUtil::triangulate_with_holes);
     ClassDB::bind_method(D_METHOD("straight_skeleton", "outer", "holes"), &PolyUtil::straight_skeleton);
+    ClassDB::bind_method(D_METHOD("triangulate_batch", "points", "ring_offsets", "polygon_offsets"),
+                         static_cast<Dictionary (PolyUtil::*)(PackedVector2Array, PackedInt32Array, PackedInt32Array)>(&PolyUtil::triangulate_batch));
+    ClassDB::bind_method(D_METHOD("straight_skeleton_batch", "points", "ring_offsets", "polygon_offsets", "gabled"), &PolyUtil::straight_skeleton_batch,
+                         DEFVAL(false));
+    ClassDB::bind_method(D_METHOD("get_last_stats"), &PolyUtil::get_last_stats);
+    ClassDB::bind_method(D_METHOD("set_cdt_point_threshold", "value"), &PolyUtil::set_cdt_point_threshold);
+    ClassDB::bind_method(D_METHOD("get_cdt_point_threshold"), &PolyUtil::get_cdt_point_threshold);
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "cdt_point_threshold"), "set_cdt_point_threshold", "get_cdt_point_threshold");
 }
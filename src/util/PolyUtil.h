@@ -4,8 +4,10 @@
 #include <godot_cpp/variant/variant.hpp>
 #include <godot_cpp/classes/ref_counted.hpp>
 #include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
 #include <godot_cpp/core/class_db.hpp>
 #include "Util.h"
+#include <vector>
 
 class SkeletonSubtree : public godot::RefCounted {
     GDCLASS(SkeletonSubtree, godot::RefCounted);
@@ -24,14 +26,125 @@ private:
     godot::PackedVector2Array sinks;
 };
 
+/**
+ * Polygon triangulation and straight skeletons.
+ *
+ * Polygons are ear clipped (Earcut) first, which is fast on the small footprints that make up most of a map and
+ * tolerates duplicate points. A polygon goes to poly2tri's constrained Delaunay triangulation (CDT) instead when
+ * ear clipping gets its area wrong, or when it has at least cdt_point_threshold points, where ear clipping's long
+ * slivers would show on large areas. If CDT rejects such a polygon, ear clipping gets another try.
+ */
 class PolyUtil : public godot::RefCounted
 {
     GDCLASS(PolyUtil, godot::RefCounted);
 public:
+    static constexpr int DEFAULT_CDT_POINT_THRESHOLD = 256;
+
+    /* Polygons per triangulation path. Times are summed over worker threads, in microseconds. */
+    struct TriangulationStats {
+        int64_t earcut_polygons = 0;
+        int64_t cdt_polygons = 0;
+        /* Polygons the first path failed on, whatever the second one did. */
+        int64_t fallbacks = 0;
+        int64_t failed = 0;
+        int64_t earcut_usec = 0;
+        int64_t cdt_usec = 0;
+
+        void add(const TriangulationStats& rhs);
+        godot::Dictionary to_dictionary() const;
+    };
+
     MAPSHADERS_DLL_SYMBOL godot::PackedVector2Array triangulate_with_holes(godot::PackedVector2Array outer, godot::Array holes);
     MAPSHADERS_DLL_SYMBOL godot::Array straight_skeleton(godot::PackedVector2Array outer, godot::Array holes);
+
+    /**
+     * Triangulates many polygons with holes in one call, spread over worker threads.
+     * @param points Points of all rings; a ring may repeat its first point at the end.
+     * @param ring_offsets Ring i has the points [ring_offsets[i], ring_offsets[i + 1]).
+     * @param polygon_offsets Polygon i has the rings [polygon_offsets[i], polygon_offsets[i + 1]), the outer one first.
+     * @return "indices": 3 per triangle into points; "offsets": polygon i has the indices [offsets[i], offsets[i + 1]);
+     *         "failed": number of polygons neither path could triangulate, which get no triangles.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary triangulate_batch(godot::PackedVector2Array points, godot::PackedInt32Array ring_offsets,
+                                                              godot::PackedInt32Array polygon_offsets);
+
+    /**
+     * Straight skeletons of many polygons with holes in one call, spread over worker threads, as flat arrays instead of
+     * one SkeletonSubtree per node. Rings are laid out as in triangulate_batch; outer rings are wound like
+     * RenderUtil.enforce_winding(verts, false) and holes the other way round first.
+     * @param gabled Whether to move ridge ends onto the footprint edges like RenderUtil.turn_hipped_skeleton_into_gabled.
+     * @return "sources", "heights": one per subtree; "sink_offsets": subtree i has the sinks [sink_offsets[i], sink_offsets[i + 1]);
+     *         "sinks": sink points; "subtree_offsets": polygon i has the subtrees [subtree_offsets[i], subtree_offsets[i + 1]);
+     *         "failed": number of polygons with an outer ring of less than 3 distinct points, which get no subtrees.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary straight_skeleton_batch(godot::PackedVector2Array points, godot::PackedInt32Array ring_offsets,
+                                                                    godot::PackedInt32Array polygon_offsets, bool gabled = false);
+
+    /* Counts and times of the last triangulate_with_holes or triangulate_batch call. */
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary get_last_stats() const {
+        return last_stats.to_dictionary();
+    }
+
+    /* Polygons with at least this many points go to CDT first; 0 ear clips every polygon first. */
+    void set_cdt_point_threshold(int value) {
+        cdt_point_threshold = value;
+    }
+    int get_cdt_point_threshold() const {
+        return cdt_point_threshold;
+    }
+
+    /* Native entry points for other C++ meshers. Rings must not repeat their first point. */
+
+    /**
+     * Triangulates a polygon with holes, ear clipping first as described above.
+     * @param out_indices Receives 3 counter-clockwise indices per triangle into the concatenation of outer and holes.
+     * @return False if neither path could triangulate the polygon.
+     */
+    static bool triangulate(const std::vector<godot::Vector2>& outer,
+                            const std::vector<std::vector<godot::Vector2>>& holes,
+                            std::vector<int>& out_indices, TriangulationStats* stats = nullptr);
+
+    /**
+     * Native counterpart of triangulate_batch. Offsets are not validated.
+     * @return The number of polygons that could not be triangulated.
+     */
+    static int64_t triangulate_batch(const godot::Vector2* points, const int32_t* ring_offsets, const int32_t* polygon_offsets,
+                                     size_t polygon_count, std::vector<int32_t>& out_indices, std::vector<int32_t>& out_offsets,
+                                     int cdt_point_threshold = DEFAULT_CDT_POINT_THRESHOLD, TriangulationStats* stats = nullptr);
+
+    struct Subtree {
+        godot::Vector2 source;
+        double height;
+        std::vector<godot::Vector2> sinks;
+    };
+
+    static std::vector<Subtree> skeletonize(const std::vector<godot::Vector2>& outer,
+                                            const std::vector<std::vector<godot::Vector2>>& holes);
+
+    /* Native counterpart of RenderUtil.turn_hipped_skeleton_into_gabled. */
+    static void hipped_to_gabled(std::vector<Subtree>& subtrees);
+
+    /* Flat skeletons of many polygons, laid out as returned by straight_skeleton_batch. */
+    struct SkeletonBatch {
+        std::vector<godot::Vector2> sources;
+        std::vector<double> heights;
+        std::vector<int32_t> sink_offsets = { 0 };
+        std::vector<godot::Vector2> sinks;
+        std::vector<int32_t> subtree_offsets = { 0 };
+    };
+
+    /**
+     * Native counterpart of straight_skeleton_batch; appends to out. Offsets are not validated.
+     * @return The number of polygons that got no skeleton.
+     */
+    static int64_t skeletonize_batch(const godot::Vector2* points, const int32_t* ring_offsets, const int32_t* polygon_offsets,
+                                     size_t polygon_count, bool gabled, SkeletonBatch& out);
 protected:
     static void _bind_methods();
+
+private:
+    int cdt_point_threshold = DEFAULT_CDT_POINT_THRESHOLD;
+    TriangulationStats last_stats;
 };
 
 #endif // POLYUTIL_H
\ No newline at end of file
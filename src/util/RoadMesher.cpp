@@ -0,0 +1,497 @@
+#include "RoadMesher.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+using namespace godot;
+
+namespace {
+    /* Junction patches reach this many half widths of their widest road from the node. */
+    const double JUNCTION_SCALE = 1.25;
+    /* Round joins get one triangle per this angle. */
+    const double ROUND_STEP = Math_PI / 8.0;
+    /* Lanes and lane width in metres of a road class whose way has neither width nor lanes. */
+    const double DEFAULT_LANES[RoadMesher::ROAD_CLASS_COUNT] = { 2.0, 2.0, 2.0, 2.0, 1.0 };
+    const double LANE_WIDTHS[RoadMesher::ROAD_CLASS_COUNT] = { 3.5, 3.5, 3.25, 3.0, 2.0 };
+
+    RoadMesher::RoadClass get_road_class(const String& highway) {
+        if (highway.begins_with("motorway") || highway.begins_with("trunk"))
+            return RoadMesher::ROAD_MOTORWAY;
+        if (highway.begins_with("primary"))
+            return RoadMesher::ROAD_PRIMARY;
+        if (highway.begins_with("secondary") || highway.begins_with("tertiary"))
+            return RoadMesher::ROAD_SECONDARY;
+        if (highway == "footway" || highway == "path" || highway == "cycleway" || highway == "pedestrian" || highway == "steps" ||
+            highway == "bridleway" || highway == "track" || highway == "corridor")
+            return RoadMesher::ROAD_PATH;
+        return RoadMesher::ROAD_MINOR;
+    }
+
+    double tag_to_float(const Dictionary& tags, const char* key) {
+        const String value = tags.get(key, "0");
+        return value.to_float();
+    }
+
+    struct Vertex {
+        Vector3 pos;
+        Vector3 normal;
+        Vector2 uv;
+    };
+
+    /* Godot treats clockwise triangles as front facing, so seen from above every triangle must turn clockwise. */
+    void push_triangle(MeshArrays& out, const Vertex& a, const Vertex& b, const Vertex& c) {
+        const real_t facing = (b.pos - a.pos).cross(c.pos - a.pos).dot(a.normal);
+        if (facing == 0.0)
+            return;
+        for (const Vertex* v : { &a, facing > 0.0 ? &c : &b, facing > 0.0 ? &b : &c }) {
+            out.vertices.push_back(v->pos);
+            out.normals.push_back(v->normal);
+            out.uvs.push_back(v->uv);
+        }
+    }
+
+    /* Cross-section of a road: its left (U = 0) and right (U = 1) edge. */
+    struct Section {
+        Vector3 left, right, up;
+        real_t v = 0.0;
+    };
+
+    void push_quad(MeshArrays& out, const Section& a, const Section& b) {
+        const Vertex al = { a.left, a.up, Vector2(0.0, a.v) }, ar = { a.right, a.up, Vector2(1.0, a.v) };
+        const Vertex bl = { b.left, b.up, Vector2(0.0, b.v) }, br = { b.right, b.up, Vector2(1.0, b.v) };
+        push_triangle(out, al, ar, br);
+        push_triangle(out, al, br, bl);
+    }
+
+    /* Road end that was cut back at a junction. */
+    struct Arm {
+        size_t junction;
+        RoadMesher::RoadClass road_class;
+        Section section;
+    };
+
+    struct Junction {
+        Vector3 centre, up;
+        double radius = 0.0;
+    };
+
+    /* Collects the geometry of one worker, one buffer per road class. */
+    struct MeshSink {
+        std::vector<RoadMesher::MeshBuffer> buffers;
+        std::vector<Arm> arms;
+
+        MeshSink() : buffers(RoadMesher::ROAD_CLASS_COUNT) {
+            for (int c = 0; c < RoadMesher::ROAD_CLASS_COUNT; c++)
+                buffers[c].road_class = static_cast<RoadMesher::RoadClass>(c);
+        }
+    };
+
+    /**
+     * Points [first, last] of a road cut back by trim_start and trim_end along the centreline.
+     * @return false if nothing is left of them.
+     */
+    bool trim(const RoadMesher::Road& road, size_t first, size_t last, double trim_start, double trim_end,
+              std::vector<Vector3>& points, std::vector<Vector3>& ups) {
+        points.clear();
+        ups.clear();
+        double total = 0.0;
+        for (size_t i = first; i < last; i++)
+            total += road.points[i].distance_to(road.points[i + 1]);
+        const double end = total - trim_end;
+        if (trim_start >= end)
+            return false;
+
+        auto push = [&](const Vector3& point, const Vector3& up) {
+            if (!points.empty() && points.back().distance_squared_to(point) < 1e-8)
+                return;
+            points.push_back(point);
+            ups.push_back(up);
+        };
+
+        double s = 0.0;
+        for (size_t i = first; i < last; i++) {
+            const double length = road.points[i].distance_to(road.points[i + 1]);
+            const double s_next = s + length;
+            if (s >= trim_start && s <= end)
+                push(road.points[i], road.ups[i]);
+            // The cuts within this segment, in order.
+            for (double cut : { trim_start, end }) {
+                if (cut > s && cut < s_next) {
+                    const real_t t = static_cast<real_t>((cut - s) / length);
+                    push(road.points[i].lerp(road.points[i + 1], t), road.ups[i].lerp(road.ups[i + 1], t).normalized());
+                }
+            }
+            s = s_next;
+        }
+        if (s <= end)
+            push(road.points[last], road.ups[last]);
+        return points.size() >= 2;
+    }
+
+    /**
+     * Meshes a strip of the given half width along points, joining segments as the settings say.
+     * @param first, last Receive the cross-sections at both ends.
+     */
+    void mesh_strip(const std::vector<Vector3>& points, const std::vector<Vector3>& ups, double half_width, const RoadMesher::Settings& settings,
+                    MeshArrays& out, Section& first, Section& last) {
+        const size_t count = points.size();
+        std::vector<Vector3> directions(count - 1), normals(count - 1);
+        for (size_t i = 0; i + 1 < count; i++) {
+            const Vector3 d = points[i + 1] - points[i];
+            directions[i] = (d - ups[i] * d.dot(ups[i])).normalized();
+            normals[i] = directions[i].cross(ups[i]).normalized();
+        }
+
+        const real_t hw = static_cast<real_t>(half_width);
+        const real_t v_scale = static_cast<real_t>(1.0 / (2.0 * half_width));
+        Section prev = { points[0] - normals[0] * hw, points[0] + normals[0] * hw, ups[0], 0.0 };
+        first = prev;
+        double distance = 0.0;
+
+        for (size_t i = 1; i < count; i++) {
+            const Vector3& p = points[i];
+            const Vector3& up = ups[i];
+            distance += points[i - 1].distance_to(p);
+            const real_t v = static_cast<real_t>(distance) * v_scale;
+            const Vector3& n0 = normals[i - 1];
+            if (i == count - 1) {
+                const Section end = { p - n0 * hw, p + n0 * hw, up, v };
+                push_quad(out, prev, end);
+                prev = end;
+                break;
+            }
+
+            const Vector3& n1 = normals[i];
+            // |n0 + n1| is twice the cosine of half the turn.
+            const Vector3 sum = n0 + n1;
+            const real_t cos_half = sum.length() / 2.0;
+            const Vector3 miter_dir = cos_half > 1e-6 ? sum / (2.0 * cos_half) : Vector3();
+            const real_t miter = cos_half > 1e-6 ? hw / cos_half : std::numeric_limits<real_t>::infinity();
+            const real_t miter_limit = static_cast<real_t>(settings.miter_limit) * hw;
+            if (cos_half > 0.9999 || (settings.join_type == RoadMesher::JOIN_MITER && miter <= miter_limit)) {
+                const Section section = { p - miter_dir * miter, p + miter_dir * miter, up, v };
+                push_quad(out, prev, section);
+                prev = section;
+                continue;
+            }
+
+            // The outer side of the turn gets a bevel or an arc; the inner one is mitered, but no further than the limit.
+            const real_t outer = directions[i].dot(n0) > 0.0 ? -1.0 : 1.0;
+            const Vector3 inner = p - miter_dir * (outer * std::min(miter, miter_limit));
+            const Vector3 outer0 = p + n0 * (outer * hw);
+            const Vector3 outer1 = p + n1 * (outer * hw);
+            const Section end = outer > 0.0 ? Section{ inner, outer0, up, v } : Section{ outer0, inner, up, v };
+            push_quad(out, prev, end);
+
+            const real_t angle = std::acos(std::clamp<real_t>(n0.dot(n1), -1.0, 1.0));
+            const int steps = settings.join_type == RoadMesher::JOIN_ROUND ? std::max(1, static_cast<int>(std::ceil(angle / ROUND_STEP))) : 1;
+            const real_t turn = directions[i - 1].cross(directions[i]).dot(up) >= 0.0 ? angle : -angle;
+            const Vertex apex = { inner, up, Vector2(outer > 0.0 ? 0.0 : 1.0, v) };
+            Vertex arc_prev = { outer0, up, Vector2(outer > 0.0 ? 1.0 : 0.0, v) };
+            for (int k = 1; k <= steps; k++) {
+                const Vector3 arc_point = k == steps ? outer1 : p + (n0 * (outer * hw)).rotated(up, turn * k / steps);
+                const Vertex arc = { arc_point, up, arc_prev.uv };
+                push_triangle(out, apex, arc_prev, arc);
+                arc_prev = arc;
+            }
+            prev = outer > 0.0 ? Section{ inner, outer1, up, v } : Section{ outer1, inner, up, v };
+        }
+        last = prev;
+    }
+
+    /* Fills the space between the cut back road ends around a junction, fanning from its centre. */
+    void mesh_junction(const Junction& junction, const Arm* arms, size_t arm_count, MeshArrays& out) {
+        const Vector3& up = junction.up;
+        Vector3 e1 = up.cross(Vector3(0.0, 0.0, 1.0));
+        if (e1.length_squared() < 1e-6)
+            e1 = up.cross(Vector3(1.0, 0.0, 0.0));
+        e1.normalize();
+        const Vector3 e2 = up.cross(e1);
+
+        std::vector<std::pair<real_t, Vector3>> rim;
+        for (size_t a = 0; a < arm_count; a++) {
+            for (const Vector3& point : { arms[a].section.left, arms[a].section.right }) {
+                const Vector3 offset = point - junction.centre;
+                rim.emplace_back(std::atan2(offset.dot(e2), offset.dot(e1)), point);
+            }
+        }
+        std::sort(rim.begin(), rim.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+
+        const real_t uv_scale = junction.radius > 0.0 ? static_cast<real_t>(1.0 / (2.0 * junction.radius)) : 0.0;
+        auto vertex = [&](const Vector3& point) {
+            const Vector3 offset = point - junction.centre;
+            return Vertex{ point, up, Vector2(0.5 + offset.dot(e1) * uv_scale, 0.5 + offset.dot(e2) * uv_scale) };
+        };
+        const Vertex centre = vertex(junction.centre);
+        for (size_t k = 0; k < rim.size(); k++)
+            push_triangle(out, centre, vertex(rim[k].second), vertex(rim[(k + 1) % rim.size()].second));
+    }
+}
+
+Dictionary RoadMesher::road_info(Dictionary osm_dict, PackedVector2Array nodes_geo, PackedInt64Array node_ids) const {
+    const RoadClass road_class = get_road_class(osm_dict.get("highway", ""));
+    double width = tag_to_float(osm_dict, "width");
+    if (!(width > 0.0)) {
+        const double lanes = tag_to_float(osm_dict, "lanes");
+        width = (lanes > 0.0 ? lanes : DEFAULT_LANES[road_class]) * LANE_WIDTHS[road_class];
+    }
+
+    Dictionary d;
+    d["name"] = osm_dict.get("name", String::num_int64(osm_dict["id"]));
+    d["road_class"] = road_class;
+    d["width"] = width;
+    d["nodes_geo"] = nodes_geo;
+    d["node_ids"] = node_ids;
+    return d;
+}
+
+RoadMesher::Road RoadMesher::road_from_info(const Dictionary& info) {
+    Road road;
+    const PackedVector2Array geo = info.get("nodes_geo", PackedVector2Array());
+    const PackedInt64Array ids = info.get("node_ids", PackedInt64Array());
+    road.geo.assign(geo.ptr(), geo.ptr() + geo.size());
+    if (ids.size() == geo.size())
+        road.node_ids.assign(ids.ptr(), ids.ptr() + ids.size());
+    else
+        road.node_ids.assign(road.geo.size(), -1);
+    road.width = info.get("width", 6.0);
+    road.road_class = static_cast<RoadClass>(std::clamp(static_cast<int>(info.get("road_class", ROAD_MINOR)), 0, ROAD_CLASS_COUNT - 1));
+    return road;
+}
+
+void RoadMesher::place(std::vector<Road>& roads, GeoMap& geomap, OSMHeightmap* heightmap, const Settings& settings) {
+    // Consecutive duplicates would give segments without a direction.
+    size_t node_count = 0;
+    for (Road& road : roads) {
+        size_t kept = 0;
+        for (size_t i = 0; i < road.geo.size(); i++) {
+            if (kept > 0 && road.geo[i] == road.geo[kept - 1])
+                continue;
+            road.geo[kept] = road.geo[i];
+            road.node_ids[kept] = road.node_ids[i];
+            kept++;
+        }
+        road.geo.resize(kept);
+        road.node_ids.resize(kept);
+        node_count += kept;
+    }
+
+    // Nodes are projected once to measure their segments, which are then split to follow the terrain.
+    std::vector<double> lon, lat;
+    lon.reserve(node_count);
+    lat.reserve(node_count);
+    for (const Road& road : roads) {
+        for (const Vector2& g : road.geo) {
+            lon.push_back(g.x);
+            lat.push_back(g.y);
+        }
+    }
+    std::vector<Vector3> node_points(node_count);
+    geomap.geo_to_world_batch(lon.data(), lat.data(), node_count, node_points.data());
+
+    size_t base = 0;
+    for (Road& road : roads) {
+        std::vector<Vector2> geo;
+        std::vector<int64_t> node_ids;
+        for (size_t i = 0; i < road.geo.size(); i++) {
+            geo.push_back(road.geo[i]);
+            node_ids.push_back(road.node_ids[i]);
+            if (i + 1 == road.geo.size() || !(settings.max_segment_length > 0.0))
+                continue;
+            const double length = node_points[base + i].distance_to(node_points[base + i + 1]);
+            const int pieces = static_cast<int>(std::ceil(length / settings.max_segment_length));
+            for (int k = 1; k < pieces; k++) {
+                geo.push_back(road.geo[i].lerp(road.geo[i + 1], static_cast<real_t>(k) / pieces));
+                node_ids.push_back(-1);
+            }
+        }
+        base += road.geo.size();
+        road.geo = std::move(geo);
+        road.node_ids = std::move(node_ids);
+    }
+
+    lon.clear();
+    lat.clear();
+    for (const Road& road : roads) {
+        for (const Vector2& g : road.geo) {
+            lon.push_back(g.x);
+            lat.push_back(g.y);
+        }
+    }
+    const size_t count = lon.size();
+    std::vector<Vector3> points(count), ups(count);
+    std::vector<double> elevations(count, 0.0);
+    geomap.geo_to_world_batch(lon.data(), lat.data(), count, points.data(), ups.data());
+    if (heightmap)
+        heightmap->getElevations(lon.data(), lat.data(), count, elevations.data());
+
+    base = 0;
+    for (Road& road : roads) {
+        road.points.resize(road.geo.size());
+        road.ups.resize(road.geo.size());
+        for (size_t i = 0; i < road.geo.size(); i++) {
+            road.ups[i] = ups[base + i];
+            road.points[i] = points[base + i] + ups[base + i] * static_cast<real_t>(elevations[base + i] + settings.surface_offset);
+        }
+        base += road.geo.size();
+    }
+}
+
+void RoadMesher::mesh(const std::vector<Road>& roads, const Settings& settings, std::vector<MeshBuffer>& out) {
+    // A node where three or more road ends meet is a junction; a road passing through counts as two ends.
+    std::unordered_map<int64_t, int> ends;
+    for (const Road& road : roads) {
+        for (size_t i = 0; i < road.node_ids.size(); i++)
+            if (road.node_ids[i] >= 0)
+                ends[road.node_ids[i]] += i == 0 || i + 1 == road.node_ids.size() ? 1 : 2;
+    }
+    std::unordered_map<int64_t, size_t> junction_of;
+    std::vector<Junction> junctions;
+    for (const Road& road : roads) {
+        for (size_t i = 0; i < road.node_ids.size(); i++) {
+            const int64_t id = road.node_ids[i];
+            if (id < 0 || ends[id] < 3)
+                continue;
+            auto found = junction_of.emplace(id, junctions.size());
+            if (found.second)
+                junctions.push_back({ road.points[i], road.ups[i], 0.0 });
+            Junction& junction = junctions[found.first->second];
+            junction.radius = std::max(junction.radius, road.width / 2.0 * JUNCTION_SCALE);
+        }
+    }
+
+    std::vector<MeshSink> sinks(parallel_worker_count(roads.size(), 64));
+    parallel_for(roads.size(), [&](size_t r, size_t worker) {
+        const Road& road = roads[r];
+        if (road.points.size() < 2 || !(road.width > 0.0))
+            return;
+        MeshSink& sink = sinks[worker];
+        MeshArrays& buffer = sink.buffers[road.road_class];
+        std::vector<Vector3> points, ups;
+
+        // The road is cut into pieces at its junctions; each piece stops short of them by the junction radius.
+        auto junction_at = [&](size_t i) -> int64_t {
+            if (road.node_ids[i] < 0)
+                return -1;
+            auto found = junction_of.find(road.node_ids[i]);
+            return found == junction_of.end() ? -1 : static_cast<int64_t>(found->second);
+        };
+        size_t first = 0;
+        for (size_t i = 1; i < road.points.size(); i++) {
+            const int64_t end_junction = junction_at(i);
+            if (end_junction < 0 && i + 1 < road.points.size())
+                continue;
+            const int64_t start_junction = junction_at(first);
+            const double trim_start = start_junction >= 0 ? junctions[start_junction].radius : 0.0;
+            const double trim_end = end_junction >= 0 ? junctions[end_junction].radius : 0.0;
+            if (trim(road, first, i, trim_start, trim_end, points, ups)) {
+                Section start_section, end_section;
+                mesh_strip(points, ups, road.width / 2.0, settings, buffer, start_section, end_section);
+                if (start_junction >= 0)
+                    sink.arms.push_back({ static_cast<size_t>(start_junction), road.road_class, start_section });
+                if (end_junction >= 0)
+                    sink.arms.push_back({ static_cast<size_t>(end_junction), road.road_class, end_section });
+            }
+            first = i;
+        }
+    }, 64);
+
+    std::vector<Arm> arms;
+    for (auto& sink : sinks)
+        arms.insert(arms.end(), sink.arms.begin(), sink.arms.end());
+    std::stable_sort(arms.begin(), arms.end(), [](const Arm& a, const Arm& b) {
+        return a.junction < b.junction;
+    });
+    std::vector<size_t> arm_offsets;
+    for (size_t a = 0; a < arms.size(); a++)
+        if (a == 0 || arms[a].junction != arms[a - 1].junction)
+            arm_offsets.push_back(a);
+    arm_offsets.push_back(arms.size());
+
+    // Patches take the class of their most important road.
+    std::vector<MeshSink> junction_sinks(parallel_worker_count(arm_offsets.size() - 1, 64));
+    parallel_for(arm_offsets.size() - 1, [&](size_t j, size_t worker) {
+        const Arm* begin = arms.data() + arm_offsets[j];
+        const size_t count = arm_offsets[j + 1] - arm_offsets[j];
+        RoadClass road_class = ROAD_CLASS_COUNT;
+        for (size_t a = 0; a < count; a++)
+            road_class = std::min(road_class, begin[a].road_class);
+        mesh_junction(junctions[begin->junction], begin, count, junction_sinks[worker].buffers[road_class]);
+    }, 64);
+
+    // Merge worker buffers in worker order so the output does not depend on scheduling.
+    std::vector<MeshBuffer> merged = MeshSink().buffers;
+    for (const auto* group : { &sinks, &junction_sinks })
+        for (const auto& sink : *group)
+            for (int c = 0; c < ROAD_CLASS_COUNT; c++)
+                merged[c].append(sink.buffers[c]);
+    for (auto& buffer : merged)
+        if (!buffer.vertices.empty())
+            out.push_back(std::move(buffer));
+}
+
+Array RoadMesher::mesh_roads(Array road_infos, Ref<GeoMap> geomap, Ref<OSMHeightmap> heightmap) {
+    last_stats = MeshOptimizer::Stats();
+    if (geomap.is_null()) {
+        ERR_PRINT("mesh_roads: a GeoMap is required.");
+        return Array();
+    }
+
+    std::vector<Road> roads;
+    roads.reserve(road_infos.size());
+    for (int i = 0; i < road_infos.size(); i++)
+        roads.push_back(road_from_info(road_infos[i]));
+
+    place(roads, *geomap.ptr(), heightmap.ptr(), settings);
+    std::vector<MeshBuffer> buffers;
+    mesh(roads, settings, buffers);
+
+    std::vector<MeshOptimizer::Stats> stats(buffers.size());
+    parallel_for(buffers.size(), [&](size_t i, size_t) {
+        stats[i] = MeshOptimizer::optimize(buffers[i]);
+    });
+
+    Array surfaces;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        last_stats += stats[i];
+
+        Dictionary surface;
+        surface["road_class"] = buffers[i].road_class;
+        surface["arrays"] = buffers[i].to_godot();
+        surface["stats"] = stats[i].to_dictionary();
+        surfaces.push_back(surface);
+    }
+    return surfaces;
+}
+
+void RoadMesher::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("road_info", "osm_dict", "nodes_geo", "node_ids"), &RoadMesher::road_info);
+    ClassDB::bind_method(D_METHOD("mesh_roads", "road_infos", "geomap", "heightmap"), &RoadMesher::mesh_roads, DEFVAL(Ref<OSMHeightmap>()));
+    ClassDB::bind_method(D_METHOD("get_last_stats"), &RoadMesher::get_last_stats);
+
+    ClassDB::bind_method(D_METHOD("set_join_type", "value"), &RoadMesher::set_join_type);
+    ClassDB::bind_method(D_METHOD("get_join_type"), &RoadMesher::get_join_type);
+    ClassDB::bind_method(D_METHOD("set_miter_limit", "value"), &RoadMesher::set_miter_limit);
+    ClassDB::bind_method(D_METHOD("get_miter_limit"), &RoadMesher::get_miter_limit);
+    ClassDB::bind_method(D_METHOD("set_max_segment_length", "value"), &RoadMesher::set_max_segment_length);
+    ClassDB::bind_method(D_METHOD("get_max_segment_length"), &RoadMesher::get_max_segment_length);
+    ClassDB::bind_method(D_METHOD("set_surface_offset", "value"), &RoadMesher::set_surface_offset);
+    ClassDB::bind_method(D_METHOD("get_surface_offset"), &RoadMesher::get_surface_offset);
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "join_type", PROPERTY_HINT_ENUM, "Miter,Round"), "set_join_type", "get_join_type");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "miter_limit"), "set_miter_limit", "get_miter_limit");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "max_segment_length"), "set_max_segment_length", "get_max_segment_length");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "surface_offset"), "set_surface_offset", "get_surface_offset");
+
+    BIND_ENUM_CONSTANT(ROAD_MOTORWAY);
+    BIND_ENUM_CONSTANT(ROAD_PRIMARY);
+    BIND_ENUM_CONSTANT(ROAD_SECONDARY);
+    BIND_ENUM_CONSTANT(ROAD_MINOR);
+    BIND_ENUM_CONSTANT(ROAD_PATH);
+    BIND_ENUM_CONSTANT(JOIN_MITER);
+    BIND_ENUM_CONSTANT(JOIN_ROUND);
+}
@@ -0,0 +1,138 @@
+#ifndef ROAD_MESHER_H
+#define ROAD_MESHER_H
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <cstdint>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "Util.h"
+#include "../import/GeoMap.h"
+#include "../import/osm_parser/OSMHeightmap.h"
+
+/**
+ * Native replacement for the per way CSGPolygon3D roads of roads.gd.
+ *
+ * Takes every highway of a tile at once and returns one mesh per road class. Roads are strips of
+ * their width along the centreline, with mitered or rounded joins, draped on the heightmap by
+ * splitting long segments. Where three or more road ends meet at an OSM node, the roads are cut
+ * back and the gap is filled with a junction patch. V runs along the road in road widths, U across it.
+ * Projection and elevation sampling run on the calling thread, meshing on worker threads.
+ */
+class RoadMesher : public godot::RefCounted {
+    GDCLASS(RoadMesher, godot::RefCounted);
+public:
+    enum RoadClass {
+        ROAD_MOTORWAY,
+        ROAD_PRIMARY,
+        ROAD_SECONDARY,
+        ROAD_MINOR,
+        ROAD_PATH,
+        ROAD_CLASS_COUNT
+    };
+
+    enum JoinType {
+        JOIN_MITER,
+        JOIN_ROUND
+    };
+
+    struct Settings {
+        JoinType join_type = JOIN_MITER;
+        /* Longest miter in half road widths; sharper corners are beveled. */
+        double miter_limit = 2.0;
+        /* Segments longer than this (world units) are split so the road follows the terrain. */
+        double max_segment_length = 10.0;
+        /* Height of the road surface above the terrain, against z-fighting. */
+        double surface_offset = 0.1;
+    };
+
+    struct Road {
+        /* OSM node per point, -1 for points added between nodes. */
+        std::vector<int64_t> node_ids;
+        /* Vector2 geo representation. */
+        std::vector<godot::Vector2> geo;
+        /* World positions on the terrain and their UP vectors, filled by place. */
+        std::vector<godot::Vector3> points;
+        std::vector<godot::Vector3> ups;
+        double width = 6.0;
+        RoadClass road_class = ROAD_MINOR;
+    };
+
+    /* Vertex data of one road class. */
+    struct MeshBuffer : MeshArrays {
+        RoadClass road_class = ROAD_MINOR;
+    };
+
+    /**
+     * Road class and width of a highway way.
+     * @param osm_dict Tags of the way.
+     * @param nodes_geo Positions of its nodes in the Vector2 geo representation ("pos_geo").
+     * @param node_ids Ids of the same nodes, which tell where roads meet.
+     * @return Dictionary with "name", "road_class", "width", "nodes_geo" and "node_ids".
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary road_info(godot::Dictionary osm_dict, godot::PackedVector2Array nodes_geo,
+                                                      godot::PackedInt64Array node_ids) const;
+
+    /**
+     * Meshes all given roads into welded, cache-optimized indexed meshes.
+     * @param road_infos Array of dictionaries returned by road_info.
+     * @param heightmap Optional; without it, roads lie on the GeoMap surface.
+     * @return Array of dictionaries { "road_class": int, "arrays": Array, "stats": Dictionary }, one per road class.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Array mesh_roads(godot::Array road_infos, godot::Ref<GeoMap> geomap,
+                                                  godot::Ref<OSMHeightmap> heightmap = godot::Ref<OSMHeightmap>());
+
+    /* MeshOptimizer statistics summed over all surfaces of the last mesh_roads call. */
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary get_last_stats() const {
+        return last_stats.to_dictionary();
+    }
+
+    /* Native API: splits long segments and fills points and ups of every road, sampling all elevations in one batch. */
+    static void place(std::vector<Road>& roads, GeoMap& geomap, OSMHeightmap* heightmap, const Settings& settings);
+
+    /* Native API: meshes placed roads and their junctions in parallel, appending to out (one buffer per road class). */
+    static void mesh(const std::vector<Road>& roads, const Settings& settings, std::vector<MeshBuffer>& out);
+
+    static Road road_from_info(const godot::Dictionary& info);
+
+    void set_join_type(JoinType value) {
+        settings.join_type = value;
+    }
+    JoinType get_join_type() const {
+        return settings.join_type;
+    }
+
+    void set_miter_limit(double value) {
+        settings.miter_limit = value;
+    }
+    double get_miter_limit() const {
+        return settings.miter_limit;
+    }
+
+    void set_max_segment_length(double value) {
+        settings.max_segment_length = value;
+    }
+    double get_max_segment_length() const {
+        return settings.max_segment_length;
+    }
+
+    void set_surface_offset(double value) {
+        settings.surface_offset = value;
+    }
+    double get_surface_offset() const {
+        return settings.surface_offset;
+    }
+
+protected:
+    static void _bind_methods();
+
+private:
+    Settings settings;
+    MeshOptimizer::Stats last_stats;
+};
+
+VARIANT_ENUM_CAST(RoadMesher::RoadClass);
+VARIANT_ENUM_CAST(RoadMesher::JoinType);
+
+#endif // ROAD_MESHER_H
@@ -0,0 +1,503 @@
+#include "TerrainMesher.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/variant/aabb.hpp>
+#include <godot_cpp/variant/vector2i.hpp>
+
+using namespace godot;
+
+namespace {
+    /* Coastline edge in grid space: x is the column, y the row, both continuous. */
+    struct Edge {
+        double x0, y0, x1, y1;
+    };
+
+    /* Edges overlapping a chunk, bucketed into SUB x SUB parts of it for crossing queries. */
+    struct ChunkEdges {
+        static constexpr int SUB = 8;
+        std::vector<std::vector<uint32_t>> buckets;
+    };
+
+    struct Context {
+        const float* raster;
+        int64_t stride;
+        int nrows;
+        int ncols;
+        float nodata;
+        double left;
+        double top;
+        double cellsize;
+        GeoMap* geomap;
+        TerrainMesher::Settings settings;
+        int chunks_x;
+        int chunks_y;
+        /* Land flag per sample, or null if everything is land. */
+        const std::vector<uint8_t>* land;
+        const std::vector<Edge>* edges;
+        const std::vector<ChunkEdges>* chunk_edges;
+
+        float height(int row, int col) const {
+            const float h = raster[row * stride + col];
+            return h == nodata ? 0.0f : h;
+        }
+
+        /* Bilinear height at a grid space point. */
+        double height_at(double x, double y) const {
+            const int col = std::max(0, std::min(static_cast<int>(std::floor(x)), ncols - 2));
+            const int row = std::max(0, std::min(static_cast<int>(std::floor(y)), nrows - 2));
+            const double dx = x - col, dy = y - row;
+            const double top_h = height(row, col) + dx * (height(row, col + 1) - height(row, col));
+            const double bottom_h = height(row + 1, col) + dx * (height(row + 1, col + 1) - height(row + 1, col));
+            return top_h + dy * (bottom_h - top_h);
+        }
+
+        GeoCoords geo(double x, double y) const {
+            return GeoCoords(Longitude::degrees(left + x * cellsize), Latitude::degrees(top - y * cellsize));
+        }
+    };
+
+    bool intersect(double ax, double ay, double bx, double by, const Edge& e, double& t) {
+        const double rx = bx - ax, ry = by - ay;
+        const double sx = e.x1 - e.x0, sy = e.y1 - e.y0;
+        const double denominator = rx * sy - ry * sx;
+        if (denominator == 0.0)
+            return false;
+        const double qx = e.x0 - ax, qy = e.y0 - ay;
+        t = (qx * sy - qy * sx) / denominator;
+        const double u = (qx * ry - qy * rx) / denominator;
+        return t >= 0.0 && t <= 1.0 && u >= 0.0 && u <= 1.0;
+    }
+
+    /* Even-odd land flag of every sample, scanning bands of rows in parallel. */
+    std::vector<uint8_t> classify_samples(const std::vector<Edge>& edges, int nrows, int ncols) {
+        const int BAND = 64;
+        const int band_count = (nrows + BAND - 1) / BAND;
+        std::vector<std::vector<uint32_t>> band_edges(band_count);
+        for (uint32_t i = 0; i < edges.size(); i++) {
+            const double y_min = std::min(edges[i].y0, edges[i].y1), y_max = std::max(edges[i].y0, edges[i].y1);
+            if (y_max < 0.0 || y_min > nrows - 1 || y_min == y_max)
+                continue;
+            const int first = std::max(0, static_cast<int>(std::floor(y_min)) / BAND);
+            const int last = std::min(band_count - 1, static_cast<int>(std::floor(y_max)) / BAND);
+            for (int b = first; b <= last; b++)
+                band_edges[b].push_back(i);
+        }
+
+        std::vector<uint8_t> land(static_cast<size_t>(nrows) * ncols, 0);
+        parallel_for(band_count, [&](size_t band, size_t) {
+            std::vector<double> crossings;
+            const int row_end = std::min(nrows, static_cast<int>(band + 1) * BAND);
+            for (int row = static_cast<int>(band) * BAND; row < row_end; row++) {
+                crossings.clear();
+                for (uint32_t i : band_edges[band]) {
+                    const Edge& e = edges[i];
+                    if ((e.y0 <= row) != (e.y1 <= row))
+                        crossings.push_back(e.x0 + (row - e.y0) * (e.x1 - e.x0) / (e.y1 - e.y0));
+                }
+                std::sort(crossings.begin(), crossings.end());
+                uint8_t* dst = land.data() + static_cast<size_t>(row) * ncols;
+                for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+                    const int begin = static_cast<int>(std::max(0.0, std::ceil(crossings[k])));
+                    const int end = static_cast<int>(std::min<double>(ncols, std::ceil(crossings[k + 1])));
+                    for (int col = begin; col < end; col++)
+                        dst[col] = 1;
+                }
+            }
+        });
+        return land;
+    }
+
+    std::vector<ChunkEdges> bucket_edges(const std::vector<Edge>& edges, int chunks_x, int chunks_y, int chunk_size) {
+        std::vector<ChunkEdges> chunk_edges(static_cast<size_t>(chunks_x) * chunks_y);
+        const double sub_size = static_cast<double>(chunk_size) / ChunkEdges::SUB;
+        for (uint32_t i = 0; i < edges.size(); i++) {
+            const Edge& e = edges[i];
+            const double x_min = std::min(e.x0, e.x1), x_max = std::max(e.x0, e.x1);
+            const double y_min = std::min(e.y0, e.y1), y_max = std::max(e.y0, e.y1);
+            const int sx_begin = std::max(0, static_cast<int>(std::floor(x_min / sub_size)));
+            const int sx_end = std::min(chunks_x * ChunkEdges::SUB - 1, static_cast<int>(std::floor(x_max / sub_size)));
+            const int sy_begin = std::max(0, static_cast<int>(std::floor(y_min / sub_size)));
+            const int sy_end = std::min(chunks_y * ChunkEdges::SUB - 1, static_cast<int>(std::floor(y_max / sub_size)));
+            for (int sy = sy_begin; sy <= sy_end; sy++) {
+                for (int sx = sx_begin; sx <= sx_end; sx++) {
+                    ChunkEdges& chunk = chunk_edges[(sy / ChunkEdges::SUB) * chunks_x + sx / ChunkEdges::SUB];
+                    if (chunk.buckets.empty())
+                        chunk.buckets.resize(ChunkEdges::SUB * ChunkEdges::SUB);
+                    chunk.buckets[(sy % ChunkEdges::SUB) * ChunkEdges::SUB + sx % ChunkEdges::SUB].push_back(i);
+                }
+            }
+        }
+        return chunk_edges;
+    }
+
+    /* Side of the triangle Godot treats as its front (clockwise winding). */
+    Vector3 front_normal(const Vector3& a, const Vector3& b, const Vector3& c) {
+        return (c - a).cross(b - a);
+    }
+
+    class ChunkBuilder {
+    public:
+        ChunkBuilder(const Context& context, int chunk_x, int chunk_y, int lod) : ctx(context), step(1 << lod) {
+            const int size = ctx.settings.chunk_size;
+            const int row_begin = chunk_y * size, col_begin = chunk_x * size;
+            const int row_end = std::min(row_begin + size, ctx.nrows - 1);
+            const int col_end = std::min(col_begin + size, ctx.ncols - 1);
+            for (int r = row_begin; r < row_end; r += step)
+                rows.push_back(r);
+            rows.push_back(row_end);
+            for (int c = col_begin; c < col_end; c += step)
+                cols.push_back(c);
+            cols.push_back(col_end);
+            chunk = &(*ctx.chunk_edges)[static_cast<size_t>(chunk_y) * ctx.chunks_x + chunk_x];
+            chunk_origin_x = col_begin;
+            chunk_origin_y = row_begin;
+        }
+
+        int64_t build(MeshArrays& mesh) {
+            const int nr = static_cast<int>(rows.size()), nc = static_cast<int>(cols.size());
+            land.resize(static_cast<size_t>(nr) * nc);
+            bool any_land = false;
+            for (int i = 0; i < nr; i++) {
+                for (int j = 0; j < nc; j++) {
+                    land[i * nc + j] = ctx.land == nullptr || (*ctx.land)[static_cast<size_t>(rows[i]) * ctx.ncols + cols[j]];
+                    any_land = any_land || land[i * nc + j];
+                }
+            }
+            if (!any_land)
+                return 0;
+
+            build_lattice(mesh);
+
+            int64_t clipped = 0;
+            for (int i = 0; i + 1 < nr; i++) {
+                for (int j = 0; j + 1 < nc; j++) {
+                    const int a = i * nc + j, b = a + 1, c = a + nc, d = c + 1;
+                    clipped += emit(mesh, a, b, c);
+                    clipped += emit(mesh, b, d, c);
+                }
+            }
+
+            add_skirts(mesh);
+            return clipped;
+        }
+
+    private:
+        /* Lattice vertices with positions, normals (from neighbours one step away) and grid UVs. */
+        void build_lattice(MeshArrays& mesh) {
+            const int nr = static_cast<int>(rows.size()), nc = static_cast<int>(cols.size());
+            // One extra sample on every side (clamped to the grid) for the normals.
+            std::vector<int> ext_rows, ext_cols;
+            ext_rows.push_back(std::max(0, rows.front() - step));
+            ext_rows.insert(ext_rows.end(), rows.begin(), rows.end());
+            ext_rows.push_back(std::min(ctx.nrows - 1, rows.back() + step));
+            ext_cols.push_back(std::max(0, cols.front() - step));
+            ext_cols.insert(ext_cols.end(), cols.begin(), cols.end());
+            ext_cols.push_back(std::min(ctx.ncols - 1, cols.back() + step));
+
+            const int er = nr + 2, ec = nc + 2;
+            std::vector<double> lon(static_cast<size_t>(er) * ec), lat(lon.size());
+            for (int i = 0; i < er; i++) {
+                for (int j = 0; j < ec; j++) {
+                    const GeoCoords coords = ctx.geo(ext_cols[j], ext_rows[i]);
+                    lon[i * ec + j] = coords.lon.get_radians();
+                    lat[i * ec + j] = coords.lat.get_radians();
+                }
+            }
+            std::vector<Vector3> pos(lon.size()), up(lon.size());
+            ctx.geomap->geo_to_world_batch(lon.data(), lat.data(), lon.size(), pos.data(), up.data());
+            for (int i = 0; i < er; i++)
+                for (int j = 0; j < ec; j++)
+                    pos[i * ec + j] += up[i * ec + j] * ctx.height(ext_rows[i], ext_cols[j]);
+
+            mesh.vertices.resize(static_cast<size_t>(nr) * nc);
+            mesh.normals.resize(mesh.vertices.size());
+            mesh.uvs.resize(mesh.vertices.size());
+            ups.resize(mesh.vertices.size());
+            for (int i = 0; i < nr; i++) {
+                for (int j = 0; j < nc; j++) {
+                    const int e = (i + 1) * ec + (j + 1);
+                    const Vector3 along_row = pos[e + 1] - pos[e - 1];
+                    const Vector3 along_col = pos[e + ec] - pos[e - ec];
+                    Vector3 normal = along_col.cross(along_row);
+                    if (normal.length_squared() == 0.0f)
+                        normal = up[e];
+                    normal = normal.normalized();
+                    if (normal.dot(up[e]) < 0.0f)
+                        normal = -normal;
+
+                    const int v = i * nc + j;
+                    mesh.vertices[v] = pos[e];
+                    mesh.normals[v] = normal;
+                    mesh.uvs[v] = uv(cols[j], rows[i]);
+                    ups[v] = up[e];
+                }
+            }
+        }
+
+        Vector2 uv(double x, double y) const {
+            return Vector2(static_cast<real_t>(x / std::max(1, ctx.ncols - 1)), static_cast<real_t>(y / std::max(1, ctx.nrows - 1)));
+        }
+
+        /* Emits the land part of lattice triangle (a, b, c). @return 1 if the triangle had to be cut. */
+        int emit(MeshArrays& mesh, int a, int b, int c) {
+            int v[3] = { a, b, c };
+            const int land_count = land[a] + land[b] + land[c];
+            if (land_count == 0)
+                return 0;
+            if (land_count == 3) {
+                mesh.indices.insert(mesh.indices.end(), { a, b, c });
+                return 0;
+            }
+
+            // Rotations keep the winding. One land corner: rotate it to v[0]; two: rotate the sea one to v[2].
+            for (int r = 0; r < 3; r++) {
+                if ((land_count == 1 && land[v[0]]) || (land_count == 2 && !land[v[2]]))
+                    break;
+                std::rotate(v, v + 1, v + 3);
+            }
+            if (land_count == 1) {
+                const int x01 = crossing(mesh, v[0], v[1]), x02 = crossing(mesh, v[0], v[2]);
+                mesh.indices.insert(mesh.indices.end(), { v[0], x01, x02 });
+            } else {
+                const int x12 = crossing(mesh, v[1], v[2]), x02 = crossing(mesh, v[0], v[2]);
+                mesh.indices.insert(mesh.indices.end(), { v[0], v[1], x12 });
+                mesh.indices.insert(mesh.indices.end(), { v[0], x12, x02 });
+            }
+            return 1;
+        }
+
+        /* Vertex where the lattice edge from land vertex p to sea vertex q meets the coastline. */
+        int crossing(MeshArrays& mesh, int p, int q) {
+            const uint64_t key = static_cast<uint64_t>(std::min(p, q)) << 32 | static_cast<uint32_t>(std::max(p, q));
+            const auto found = crossings.find(key);
+            if (found != crossings.end())
+                return found->second;
+
+            const int nc = static_cast<int>(cols.size());
+            const double px = cols[p % nc], py = rows[p / nc];
+            const double qx = cols[q % nc], qy = rows[q / nc];
+            const double t = coastline_parameter(px, py, qx, qy);
+            const double x = px + (qx - px) * t, y = py + (qy - py) * t;
+
+            Vector3 pos, up;
+            ctx.geomap->geo_to_world_and_up(ctx.geo(x, y), pos, up);
+            pos += up * ctx.height_at(x, y);
+
+            const int index = static_cast<int>(mesh.vertices.size());
+            mesh.vertices.push_back(pos);
+            mesh.normals.push_back(mesh.normals[p].lerp(mesh.normals[q], static_cast<real_t>(t)).normalized());
+            mesh.uvs.push_back(uv(x, y));
+            ups.push_back(up);
+            crossings.emplace(key, index);
+            return index;
+        }
+
+        /* Parameter along p -> q of the coastline crossing closest to p; the midpoint if none is found. */
+        double coastline_parameter(double px, double py, double qx, double qy) const {
+            if (chunk->buckets.empty())
+                return 0.5;
+            const double sub_size = static_cast<double>(ctx.settings.chunk_size) / ChunkEdges::SUB;
+            auto sub = [&](double v, double origin) {
+                return std::max(0, std::min(ChunkEdges::SUB - 1, static_cast<int>(std::floor((v - origin) / sub_size))));
+            };
+            const int sx_begin = sub(std::min(px, qx), chunk_origin_x), sx_end = sub(std::max(px, qx), chunk_origin_x);
+            const int sy_begin = sub(std::min(py, qy), chunk_origin_y), sy_end = sub(std::max(py, qy), chunk_origin_y);
+
+            double best = 2.0;
+            for (int sy = sy_begin; sy <= sy_end; sy++) {
+                for (int sx = sx_begin; sx <= sx_end; sx++) {
+                    for (uint32_t i : chunk->buckets[sy * ChunkEdges::SUB + sx]) {
+                        double t;
+                        if (intersect(px, py, qx, qy, (*ctx.edges)[i], t))
+                            best = std::min(best, t);
+                    }
+                }
+            }
+            return best <= 1.0 ? best : 0.5;
+        }
+
+        /* Walls hanging from the chunk border, facing outwards. */
+        void add_skirts(MeshArrays& mesh) {
+            const int nr = static_cast<int>(rows.size()), nc = static_cast<int>(cols.size());
+            const Vector3 center = (mesh.vertices[0] + mesh.vertices[nc - 1] + mesh.vertices[(nr - 1) * nc] + mesh.vertices[nr * nc - 1]) * 0.25f;
+            const real_t depth = static_cast<real_t>(ctx.settings.skirt_depth);
+
+            auto border = [&](int first, int stride, int count) {
+                int previous_low = -1;
+                for (int k = 0; k < count; k++) {
+                    const int v = first + k * stride;
+                    if (!land[v]) {
+                        previous_low = -1;
+                        continue;
+                    }
+                    const int low = static_cast<int>(mesh.vertices.size());
+                    mesh.vertices.push_back(mesh.vertices[v] - ups[v] * depth);
+                    mesh.normals.push_back(mesh.normals[v]);
+                    mesh.uvs.push_back(mesh.uvs[v]);
+                    ups.push_back(ups[v]);
+
+                    if (previous_low >= 0) {
+                        const int p = v - stride, q = v, p_low = previous_low, q_low = low;
+                        const Vector3 outward = (mesh.vertices[p] + mesh.vertices[q]) * 0.5f - center;
+                        if (front_normal(mesh.vertices[p], mesh.vertices[q], mesh.vertices[q_low]).dot(outward) >= 0.0f)
+                            mesh.indices.insert(mesh.indices.end(), { p, q, q_low, p, q_low, p_low });
+                        else
+                            mesh.indices.insert(mesh.indices.end(), { p, q_low, q, p, p_low, q_low });
+                    }
+                    previous_low = low;
+                }
+            };
+            border(0, 1, nc);
+            border((nr - 1) * nc, 1, nc);
+            border(0, nc, nr);
+            border(nc - 1, nc, nr);
+        }
+
+        const Context& ctx;
+        const int step;
+        std::vector<int> rows;
+        std::vector<int> cols;
+        std::vector<uint8_t> land;
+        std::vector<Vector3> ups;
+        std::unordered_map<uint64_t, int> crossings;
+        const ChunkEdges* chunk = nullptr;
+        double chunk_origin_x = 0.0;
+        double chunk_origin_y = 0.0;
+    };
+}
+
+Dictionary TerrainMesher::Stats::to_dictionary() const {
+    Dictionary d;
+    d["chunk_meshes"] = chunk_meshes;
+    d["vertices"] = vertices;
+    d["triangles"] = triangles;
+    d["clipped_triangles"] = clipped_triangles;
+    return d;
+}
+
+TerrainMesher::Stats TerrainMesher::mesh(const ElevationGrid& grid, GeoMap& geomap, const std::vector<std::vector<Vector2>>& land_rings,
+                                         const Settings& settings, std::vector<ChunkMesh>& out) {
+    Stats stats;
+    if (grid.getRasterData() == nullptr || grid.getNcols() < 2 || grid.getNrows() < 2 || settings.chunk_size < 1)
+        return stats;
+
+    Context ctx;
+    ctx.raster = grid.getRasterData();
+    ctx.stride = grid.getStride();
+    ctx.nrows = grid.getNrows();
+    ctx.ncols = grid.getNcols();
+    ctx.nodata = static_cast<float>(grid.getNodataValue());
+    ctx.left = grid.getTopLeftGeo().lon.get_degrees();
+    ctx.top = grid.getTopLeftGeo().lat.get_degrees();
+    ctx.cellsize = grid.getCellsize();
+    ctx.geomap = &geomap;
+    ctx.settings = settings;
+    ctx.chunks_x = (ctx.ncols - 2) / settings.chunk_size + 1;
+    ctx.chunks_y = (ctx.nrows - 2) / settings.chunk_size + 1;
+
+    // Coastline in grid space, classified and bucketed once for all chunks and LODs.
+    std::vector<Edge> edges;
+    for (const auto& ring : land_rings) {
+        for (size_t i = 0; i < ring.size(); i++) {
+            const GeoCoords a = GeoCoords::from_vector2_representation(ring[i]);
+            const GeoCoords b = GeoCoords::from_vector2_representation(ring[(i + 1) % ring.size()]);
+            const Edge edge = { (a.lon.get_degrees() - ctx.left) / ctx.cellsize, (ctx.top - a.lat.get_degrees()) / ctx.cellsize,
+                                (b.lon.get_degrees() - ctx.left) / ctx.cellsize, (ctx.top - b.lat.get_degrees()) / ctx.cellsize };
+            if (edge.x0 != edge.x1 || edge.y0 != edge.y1)
+                edges.push_back(edge);
+        }
+    }
+    std::vector<uint8_t> land;
+    if (!land_rings.empty())
+        land = classify_samples(edges, ctx.nrows, ctx.ncols);
+    const std::vector<ChunkEdges> chunk_edges = bucket_edges(edges, ctx.chunks_x, ctx.chunks_y, settings.chunk_size);
+    ctx.land = land_rings.empty() ? nullptr : &land;
+    ctx.edges = &edges;
+    ctx.chunk_edges = &chunk_edges;
+
+    // LODs coarser than a chunk would not have any inner vertices.
+    int lod_count = std::max(1, settings.lod_count);
+    while (lod_count > 1 && (1 << (lod_count - 1)) > settings.chunk_size)
+        lod_count--;
+
+    const size_t chunk_count = static_cast<size_t>(ctx.chunks_x) * ctx.chunks_y;
+    std::vector<ChunkMesh> meshes(chunk_count * lod_count);
+    std::vector<int64_t> clipped(meshes.size(), 0);
+    parallel_for(meshes.size(), [&](size_t i, size_t) {
+        ChunkMesh& chunk = meshes[i];
+        chunk.lod = static_cast<int>(i % lod_count);
+        chunk.x = static_cast<int>((i / lod_count) % ctx.chunks_x);
+        chunk.y = static_cast<int>((i / lod_count) / ctx.chunks_x);
+        clipped[i] = ChunkBuilder(ctx, chunk.x, chunk.y, chunk.lod).build(chunk.mesh);
+    });
+
+    for (size_t i = 0; i < meshes.size(); i++) {
+        if (meshes[i].mesh.indices.empty())
+            continue;
+        stats.chunk_meshes++;
+        stats.vertices += meshes[i].mesh.vertices.size();
+        stats.triangles += meshes[i].mesh.triangle_count();
+        stats.clipped_triangles += clipped[i];
+        out.push_back(std::move(meshes[i]));
+    }
+    return stats;
+}
+
+Array TerrainMesher::mesh_grid(Ref<ElevationGrid> grid, Array land_polygons) {
+    if (grid.is_null()) {
+        ERR_PRINT("ElevationGrid is null");
+        return Array();
+    }
+    Ref<GeoMap> geomap = grid->get_geo_map();
+    if (geomap.is_null()) {
+        ERR_PRINT("GeoMap is not set");
+        return Array();
+    }
+
+    std::vector<std::vector<Vector2>> rings;
+    for (int i = 0; i < land_polygons.size(); i++) {
+        const Array polygon = land_polygons[i];
+        for (int j = 0; j < polygon.size(); j++) {
+            const PackedVector2Array ring = polygon[j];
+            if (ring.size() >= 3)
+                rings.emplace_back(ring.ptr(), ring.ptr() + ring.size());
+        }
+    }
+
+    std::vector<ChunkMesh> chunks;
+    last_stats = mesh(*grid.ptr(), *geomap.ptr(), rings, settings, chunks);
+
+    Array result;
+    for (const ChunkMesh& chunk : chunks) {
+        AABB aabb(chunk.mesh.vertices[0], Vector3());
+        for (const Vector3& v : chunk.mesh.vertices)
+            aabb.expand_to(v);
+
+        Dictionary d;
+        d["chunk"] = Vector2i(chunk.x, chunk.y);
+        d["lod"] = chunk.lod;
+        d["arrays"] = chunk.mesh.to_godot();
+        d["aabb"] = aabb;
+        result.push_back(d);
+    }
+    return result;
+}
+
+void TerrainMesher::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("mesh_grid", "grid", "land_polygons"), &TerrainMesher::mesh_grid, DEFVAL(Array()));
+    ClassDB::bind_method(D_METHOD("get_last_stats"), &TerrainMesher::get_last_stats);
+
+    ClassDB::bind_method(D_METHOD("set_chunk_size", "value"), &TerrainMesher::set_chunk_size);
+    ClassDB::bind_method(D_METHOD("get_chunk_size"), &TerrainMesher::get_chunk_size);
+    ClassDB::bind_method(D_METHOD("set_lod_count", "value"), &TerrainMesher::set_lod_count);
+    ClassDB::bind_method(D_METHOD("get_lod_count"), &TerrainMesher::get_lod_count);
+    ClassDB::bind_method(D_METHOD("set_skirt_depth", "value"), &TerrainMesher::set_skirt_depth);
+    ClassDB::bind_method(D_METHOD("get_skirt_depth"), &TerrainMesher::get_skirt_depth);
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "chunk_size", PROPERTY_HINT_RANGE, "1,1024,1"), "set_chunk_size", "get_chunk_size");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "lod_count", PROPERTY_HINT_RANGE, "1,10,1"), "set_lod_count", "get_lod_count");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "skirt_depth", PROPERTY_HINT_RANGE, "0,1000,0.1,or_greater"), "set_skirt_depth", "get_skirt_depth");
+}
@@ -0,0 +1,97 @@
+#ifndef TERRAIN_MESHER_H
+#define TERRAIN_MESHER_H
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <cstdint>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "Util.h"
+#include "../import/GeoMap.h"
+#include "../import/elevation/ElevationParser.h"
+
+/**
+ * Native replacement for the per cell terrain loop in ground.gd.
+ *
+ * Splits an ElevationGrid into square chunks and meshes every chunk at every LOD (LOD n uses every
+ * 2^n-th sample) on worker threads. Chunks get skirts along their borders to hide cracks between
+ * neighbours at different LODs. Optional land polygons clip the terrain to the coastline: samples are
+ * classified once per grid with even-odd scanlines, triangles crossing the coastline are cut where
+ * their edges meet it, so coastline detail finer than a triangle becomes one straight segment.
+ */
+class TerrainMesher : public godot::RefCounted {
+    GDCLASS(TerrainMesher, godot::RefCounted);
+public:
+    struct Settings {
+        /* Cells per chunk side. */
+        int chunk_size = 64;
+        int lod_count = 3;
+        /* How far skirts reach below the terrain, in world units. */
+        double skirt_depth = 10.0;
+    };
+
+    struct ChunkMesh {
+        int x = 0;
+        int y = 0;
+        int lod = 0;
+        MeshArrays mesh;
+    };
+
+    struct Stats {
+        int64_t chunk_meshes = 0;
+        int64_t vertices = 0;
+        int64_t triangles = 0;
+        int64_t clipped_triangles = 0;
+
+        godot::Dictionary to_dictionary() const;
+    };
+
+    /**
+     * Native API. Meshes all chunks and LODs in parallel; chunks without land are left out.
+     * @param land_rings Land rings in their Vector2 geo representation, filled even-odd. Empty: no clipping.
+     */
+    static Stats mesh(const ElevationGrid& grid, GeoMap& geomap, const std::vector<std::vector<godot::Vector2>>& land_rings,
+                      const Settings& settings, std::vector<ChunkMesh>& out);
+
+    /**
+     * Meshes an ElevationGrid (which must have a GeoMap) into chunked LOD patches.
+     * @param land_polygons Optional land polygons as passed to import_polygons_geo: Array of Arrays of PackedVector2Array.
+     * @return Array of dictionaries { "chunk": Vector2i, "lod": int, "arrays": Array, "aabb": AABB }.
+     */
+    MAPSHADERS_DLL_SYMBOL godot::Array mesh_grid(godot::Ref<ElevationGrid> grid, godot::Array land_polygons = godot::Array());
+
+    MAPSHADERS_DLL_SYMBOL godot::Dictionary get_last_stats() const {
+        return last_stats.to_dictionary();
+    }
+
+    void set_chunk_size(int value) {
+        settings.chunk_size = value;
+    }
+    int get_chunk_size() const {
+        return settings.chunk_size;
+    }
+
+    void set_lod_count(int value) {
+        settings.lod_count = value;
+    }
+    int get_lod_count() const {
+        return settings.lod_count;
+    }
+
+    void set_skirt_depth(double value) {
+        settings.skirt_depth = value;
+    }
+    double get_skirt_depth() const {
+        return settings.skirt_depth;
+    }
+
+protected:
+    static void _bind_methods();
+
+private:
+    Settings settings;
+    Stats last_stats;
+};
+
+#endif // TERRAIN_MESHER_H